@@ -27,17 +27,8 @@ static const char* g_stats_file = COMP_STATS_FILE;
  * EXTERNAL SYMBOLS FROM SIMULA.C
  * ============================================================================ */
 
-// Core simulator state (defined in simula.c)
-extern map_t map;
-extern robot_t r;
-extern sensor_t *hist;
-extern config_t config;
-extern int timer;
-extern struct _stat stats;
-
-// Core functions we need
-extern int load_map(char* filename);
-extern void sim_request_stop(void);
+// Core simulator state lives in the active simulation context
+// (sim_ctx_current(), declared in simula_internal.h)
 
 /* ============================================================================
  * PRIVATE HELPER FUNCTIONS
@@ -124,31 +115,32 @@ const char* competition_get_team_id(void) {
  * @param map_type Identificador del tipo de mapa
  */
 void competition_execute_map(const char* filename, int map_type) {
+    sim_ctx_t *ctx = sim_ctx_current();
+
     // Store map type for statistics
     if(filename) {
-        snprintf(map.name, sizeof(map.name), "%s", filename);
+        snprintf(ctx->map.name, sizeof(ctx->map.name), "%s", filename);
     } else {
-        map.name[0] = '\0';
+        ctx->map.name[0] = '\0';
     }
     
     // Load the map
-    if(load_map((char*)filename) != 0) {
+    if(sim_ctx_load_map(ctx, (char*)filename) != 0) {
         fprintf(stderr, "Error: Cannot load map %s\n", filename);
         exit(1);
     }
     
     // Execute initialization callback if provided
-    if(config.on_start != NULL) {
-        config.on_start();
+    if(ctx->config.on_start != NULL) {
+        ctx->config.on_start();
     }
     
     // Execute behavior loop until time expires or stop requested
-    while(timer < config.exec_time) {
-        config.exec_beh();
+    while(ctx->timer < ctx->config.exec_time) {
+        sim_ctx_exec_beh(ctx);
         
         // Check for early termination
-        extern int sim_should_stop;
-        if(sim_should_stop) break;
+        if(ctx->should_stop) break;
     }
 }
 
@@ -211,20 +203,14 @@ void run_competition(void) {
  * @brief Guarda las estadísticas de la ejecución en el archivo centralizado
  */
 void save_stats_competition(void) {
+    sim_ctx_t *ctx = sim_ctx_current();
+    const struct _stat *stats = stats_get(ctx);
     const char *team_id;
-    int i;
     
     // Get team identifier
     team_id = get_team_id();
     
-    // Calculate mean battery
-    stats.bat_mean = 0;
-    for(i = 0; i < config.exec_time && i < timer; i++) {
-        stats.bat_mean += hist[i].battery;
-    }
-    if(timer > 0) {
-        stats.bat_mean /= timer;
-    }
+    // bat_mean is kept up to date on every tick (stats_tick)
     
     // Open centralized stats file in append mode
     FILE *fd = fopen(g_stats_file, "a");
@@ -243,14 +229,15 @@ void save_stats_competition(void) {
     
     // Write statistics line with team ID and map type
     // Format: team,map_type,cell_total,cell_visited,dirt_total,dirt_cleaned,
-    //         bat_total,bat_mean,forward,turn,bumps,clean,load
-    fprintf(fd, "%s,%d,%d,%d,%d,%d,%.1f,%.1f,%d,%d,%d,%d,%d\n",
+    //         bat_total,bat_mean,forward,turn,bumps,clean,load,end
+    fprintf(fd, "%s,%d,%d,%d,%d,%d,%.1f,%.1f,%d,%d,%d,%d,%d,%d\n",
         team_id, map_type,
-        stats.cell_total, stats.cell_visited,
-        stats.dirt_total, stats.dirt_cleaned,
-        stats.bat_total, stats.bat_mean,
-        stats.moves[FWD], stats.moves[TURN], 
-        stats.moves[BUMP], stats.moves[CLEAN], stats.moves[LOAD]);
+        stats->cell_total, stats->cell_visited,
+        stats->dirt_total, stats->dirt_cleaned,
+        stats->bat_total, stats->bat_mean,
+        stats->moves[FWD], stats->moves[TURN], 
+        stats->moves[BUMP], stats->moves[CLEAN], stats->moves[LOAD],
+        stats->end);
     
     fclose(fd);
 }
@@ -34,6 +34,31 @@ void run();
  */
 void configure(void (*start)(), void (*beh)(), void (*stop)(), int exec_time);
 
+/**
+ * @brief Añade otro robot a la simulación
+ *
+ * Debe llamarse después de configure() y antes de run(). El nuevo robot
+ * tiene sus propias funciones start, beh y stop, sus sensores y sus
+ * estadísticas, y comparte con los demás el mapa, la base y la suciedad.
+ * Los robots se estorban: avanzar hacia la celda de otro robot activa el
+ * bumper como un muro, salvo en la base, que admite varios a la vez.
+ *
+ * run() ejecuta una llamada a beh de cada robot por vuelta, siempre en el
+ * mismo orden (primero el de configure(), después los añadidos), y cada
+ * robot termina por su cuenta al agotar el tiempo o la batería. Las
+ * macroacciones (rmb_forward_n(), rmb_forward_until()) dan todos sus pasos
+ * en el turno del robot, sin intercalarse con los demás. stats.csv
+ * recoge una fila con el total de todos los robots, con el mismo formato
+ * que la de un solo robot.
+ * visualize() y log.csv muestran solo el robot de configure().
+ *
+ * @param start Función de inicialización del robot (llamará a rmb_awake)
+ * @param beh Comportamiento cíclico del robot
+ * @param stop Función de finalización del robot (puede ser NULL)
+ * @return Índice del robot (1, 2... hasta 15), o -1 si error
+ */
+int add_robot(void (*start)(), void (*beh)(), void (*stop)());
+
 /**
  * @brief Carga un mapa generado en una simulación anterior
  *
@@ -96,6 +121,43 @@ void rmb_turn(float alpha);
  */
 void rmb_forward();
 
+#define RMB_UNTIL_BUMP 1 ///< Parar al chocar (siempre activa)
+#define RMB_UNTIL_DIRT 2 ///< Parar al llegar a una celda con suciedad
+
+/**
+ * @brief Acción de avanzar varios pasos seguidos en la dirección actual
+ *
+ * Con un solo robot equivale a llamar a rmb_forward() hasta 'n' veces,
+ * una por ciclo: cada paso consume su tick y su batería y queda en el
+ * historial igual que un rmb_forward() suelto. Se detiene antes si el
+ * robot choca (el choque cuenta como un rmb_forward() contra el muro y
+ * deja el bumper activo) o si se acaba el tiempo o la batería.
+ *
+ * Con varios robots (add_robot()) no equivale: todos los pasos se dan
+ * dentro de una sola llamada al comportamiento, mientras los demás robots
+ * siguen quietos hasta su turno, así que los choques entre robots no
+ * ocurren en el mismo orden que con un rmb_forward() por vuelta.
+ *
+ * @param n Número máximo de pasos
+ * @return Número de celdas que ha avanzado
+ */
+int rmb_forward_n(int n);
+
+/**
+ * @brief Acción de avanzar hasta que se cumpla una condición
+ *
+ * Como rmb_forward_n(), pero con RMB_UNTIL_DIRT se detiene también en la
+ * primera celda con suciedad (rmb_ifr() > 0). El choque siempre detiene
+ * el avance, así que RMB_UNTIL_BUMP solo documenta la intención.
+ *
+ * Ejemplo: rmb_forward_until(RMB_UNTIL_BUMP | RMB_UNTIL_DIRT, 50);
+ *
+ * @param until Combinación de RMB_UNTIL_BUMP y RMB_UNTIL_DIRT
+ * @param n Número máximo de pasos
+ * @return Número de celdas que ha avanzado
+ */
+int rmb_forward_until(int until, int n);
+
 /**
  * @brief Acción de limpiar la posición actual
  *
@@ -156,4 +218,51 @@ float rmb_battery();
  */
 int rmb_at_base();
 
+/**
+ * @brief Número pseudoaleatorio para el comportamiento
+ *
+ * Alternativa reproducible a rand(): cada simulación tiene su propio
+ * generador, inicializado con la semilla de la ejecución (variable de
+ * entorno ROOMBA_SEED, que fija el runner para cada mapa y repetición).
+ * Para un real en [0, 1): rmb_rand() / 4294967296.0
+ *
+ * @return Valor entre 0 y 4294967295
+ */
+unsigned int rmb_rand();
+
+/**
+ * @brief Consulta qué robot está ejecutando su comportamiento
+ *
+ * Permite compartir una misma función de comportamiento entre varios
+ * robots (ver add_robot()).
+ *
+ * @return 0 para el robot de configure(), 1, 2... para los de add_robot()
+ */
+int rmb_id();
+
+/**
+ * @brief Declara las variables de las que depende el comportamiento
+ *
+ * Con el estado declarado el simulador puede detectar que el robot ha
+ * entrado en un ciclo (misma posición, orientación, sensores y variables
+ * que en una llamada anterior, sin haber limpiado nada entre medias) y
+ * repetir las acciones del ciclo sin llamar al comportamiento hasta el
+ * final. Las estadísticas y el historial salen idénticos.
+ *
+ * El comportamiento debe depender solo de los sensores (salvo la batería),
+ * del mapa y de las variables de state; no puede usar rand() ni variables
+ * fuera de state. rmb_battery(), rmb_state() (que incluye la batería) y
+ * rmb_rand() desactivan la detección hasta la siguiente ejecución, y con
+ * varios robots (add_robot()) no se usa. Se llama en la función de
+ * inicialización, por ejemplo:
+ *
+ *   static struct { int steps; float turn; } st;
+ *   rmb_declare_state(&st, sizeof(st));
+ *
+ * @param state Variables del comportamiento (NULL si no tiene)
+ * @param size Bytes de state (máximo 256)
+ * @return 0 si OK, -1 si el tamaño no es válido
+ */
+int rmb_declare_state(void *state, int size);
+
 #endif
\ No newline at end of file
@@ -16,23 +16,41 @@
  *     ...
  *
  * Usage:
- *   ./runner [teams_dir]
+ *   ./runner [teams_dir] [--batch] [-j N]
+ *
+ * Parallel mode (-j N or workers = N in runner.conf) runs up to N rounds
+ * (team, map, rep) at once, each worker in its own scratch directory
+ * teams/<team>/.worker<k>/. Results are merged in serial order.
+ *
+ * Batch mode (--batch or batch_mode = 1 in runner.conf) compiles each team
+ * as a shared object and runs all of its rounds inside a single process,
+ * instead of launching one ./roomba process per round.
  *
  * Output:
  *   stats.csv - Complete statistics for all teams and maps
  *   ranking.txt - Final team rankings
  */
 
+#define _GNU_SOURCE // dl_iterate_phdr() (batch mode)
 #include <dirent.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h> // For access()
+#ifdef __linux__
+#include <link.h>
+#endif
 
 #define MAX_TEAMS 100    ///< Número máximo de equipos permitidos
 #define TEAM_NAME_LEN 64 ///< Longitud máxima del nombre de equipo
@@ -42,6 +60,7 @@
 #define DEFAULT_REPS_PER_MAP 5
 #define DEFAULT_TIMEOUT 30
 #define DEFAULT_LOGS_DIR "logs"
+#define DEFAULT_LOG_FORMAT "bin"
 #define DEFAULT_MAPS_DIR "maps"
 
 /**
@@ -52,8 +71,12 @@ typedef struct {
   int reps_per_map;
   int timeout_seconds;
   int max_ticks;
+  int batch_mode; ///< 1 = ejecutar las rondas de cada equipo en un proceso
+  int workers;    ///< Ejecuciones simultáneas (1 = serie)
   char maps_dir[256];
   char logs_dir[256];
+  char log_format[16]; ///< Trayectoria de cada ronda: "bin" (log.bin), "csv" o "actions"
+  uint64_t seed;       ///< Semilla base de la competición (ver round_seed)
 } runner_config_t;
 
 runner_config_t runner_cfg;
@@ -80,8 +103,12 @@ void load_runner_config(const char *filename) {
   runner_cfg.timeout_seconds = DEFAULT_TIMEOUT;
   strcpy(runner_cfg.maps_dir, DEFAULT_MAPS_DIR);
   strcpy(runner_cfg.logs_dir, DEFAULT_LOGS_DIR);
+  strcpy(runner_cfg.log_format, DEFAULT_LOG_FORMAT);
+  runner_cfg.seed = 0;
   runner_cfg.max_ticks =
       2000; // Valor por defecto si no se encuentra en runner.conf
+  runner_cfg.batch_mode = 0;
+  runner_cfg.workers = 1;
 
   FILE *f = fopen(filename, "r");
   if (!f) {
@@ -122,6 +149,17 @@ void load_runner_config(const char *filename) {
         strcpy(runner_cfg.logs_dir, v);
       } else if (strcmp(k, "max_ticks ") == 0 || strcmp(k, "max_ticks") == 0) {
         runner_cfg.max_ticks = atoi(v);
+      } else if (strcmp(k, "batch_mode ") == 0 ||
+                 strcmp(k, "batch_mode") == 0) {
+        runner_cfg.batch_mode = atoi(v);
+      } else if (strcmp(k, "workers ") == 0 || strcmp(k, "workers") == 0) {
+        runner_cfg.workers = atoi(v);
+      } else if (strcmp(k, "log_format ") == 0 ||
+                 strcmp(k, "log_format") == 0) {
+        if (strlen(v) < sizeof(runner_cfg.log_format))
+          strcpy(runner_cfg.log_format, v);
+      } else if (strcmp(k, "seed ") == 0 || strcmp(k, "seed") == 0) {
+        runner_cfg.seed = strtoull(v, NULL, 0);
       }
     }
   }
@@ -155,7 +193,7 @@ void init_stats_file(const char *filename) {
   }
 
   fprintf(fd, "team,map_type,cell_total,cell_visited,dirt_total,dirt_cleaned,"
-              "bat_total,bat_mean,forward,turn,bumps,clean,load\n");
+              "bat_total,bat_mean,forward,turn,bumps,clean,load,end\n");
   fclose(fd);
 
   printf("✓ Statistics file initialized: %s\n", filename);
@@ -164,11 +202,24 @@ void init_stats_file(const char *filename) {
 /**
  * @brief Verifica el resultado de ejecución y registra información de crash
  * @param status Código de estado del proceso
+ * @param timed_out 1 si el runner mató el proceso por superar el timeout
  * @param stderr_file Archivo de log de errores
- * @return Cadena con el estado: "success", "error", "crash", "stopped",
- * "unknown"
+ * @return Cadena con el estado: "success", "error", "crash", "timeout",
+ * "stopped", "unknown"
  */
-const char *check_execution_result(int status, const char *stderr_file) {
+const char *check_execution_result(int status, int timed_out,
+                                   const char *stderr_file) {
+  if (timed_out) {
+    FILE *log = fopen(stderr_file, "a");
+    if (log) {
+      fprintf(log, "\n=== TIMEOUT ===\n");
+      fprintf(log, "Killed after %ds (timeout_seconds)\n",
+              runner_cfg.timeout_seconds);
+      fprintf(log, "===============\n");
+      fclose(log);
+    }
+    return "timeout";
+  }
   if (WIFEXITED(status)) {
     int exit_code = WEXITSTATUS(status);
     if (exit_code == 0) {
@@ -211,6 +262,168 @@ const char *check_execution_result(int status, const char *stderr_file) {
   return "unknown";
 }
 
+/* ============================================================================
+ * LANZAMIENTO DE EJECUCIONES (fork/execve + timeout)
+ * ============================================================================
+ */
+
+extern char **environ;
+
+/**
+ * @brief Semilla de una ronda
+ * @param map_idx Índice del mapa
+ * @param rep Repetición
+ * @return Semilla para ROOMBA_SEED
+ *
+ * Depende solo de la semilla base, el mapa y la repetición (splitmix64):
+ * todos los equipos juegan la ronda (mapa, rep) con la misma semilla, en
+ * serie, en paralelo o en batch, y repetir la competición da lo mismo.
+ */
+static uint64_t round_seed(int map_idx, int rep) {
+  uint64_t z = runner_cfg.seed ^ ((uint64_t)(uint32_t)map_idx << 32 |
+                                  (uint32_t)rep);
+  z += 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief Exporta ROOMBA_SEED para una ronda
+ * @param seed Semilla (round_seed)
+ */
+static void set_round_seed(uint64_t seed) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%" PRIu64, seed);
+  setenv("ROOMBA_SEED", buf, 1);
+}
+
+/**
+ * @brief Lanza ./roomba en su propio grupo de procesos
+ * @param dir Directorio de trabajo de la ejecución
+ * @param roomba Ejecutable, relativo a dir
+ * @param map_arg Argumento de mapa ("" = mapa aleatorio)
+ * @param log_stdout Log de salida estándar (relativo al directorio actual)
+ * @param log_stderr Log de errores (relativo al directorio actual)
+ * @param seed Semilla de la ronda (ROOMBA_SEED)
+ * @return PID del proceso (igual a su PGID), o -1 si error
+ */
+pid_t spawn_round(const char *dir, const char *roomba, const char *map_arg,
+                  const char *log_stdout, const char *log_stderr,
+                  uint64_t seed) {
+  int out = open(log_stdout, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  int err = open(log_stderr, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (out < 0 || err < 0) {
+    if (out >= 0)
+      close(out);
+    if (err >= 0)
+      close(err);
+    return -1;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // New process group: a timeout kills the team and anything it spawned
+    setpgid(0, 0);
+    dup2(out, STDOUT_FILENO);
+    dup2(err, STDERR_FILENO);
+    if (chdir(dir) != 0)
+      _exit(127);
+    setenv("VISUAL", "0", 1);
+    setenv("ROOMBA_LOG", runner_cfg.log_format, 1);
+    set_round_seed(seed);
+    char *argv[3] = {(char *)roomba, NULL, NULL};
+    if (map_arg[0])
+      argv[1] = (char *)map_arg;
+    execve(roomba, argv, environ);
+    fprintf(stderr, "Cannot execute %s/%s\n", dir, roomba);
+    _exit(127);
+  }
+  if (pid > 0)
+    setpgid(pid, pid); // Same as the child, whichever runs first
+  close(out);
+  close(err);
+  return pid;
+}
+
+/**
+ * @brief Segundos transcurridos entre dos instantes
+ */
+static double elapsed_seconds(const struct timespec *from,
+                              const struct timespec *to) {
+  return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Espera a que termine una de las ejecuciones en curso
+ * @param pids Procesos en curso (0 = hueco libre); el terminado pasa a 0
+ * @param started Instante de lanzamiento de cada proceso (CLOCK_MONOTONIC)
+ * @param timed_out Se pone a 1 en los procesos matados por timeout
+ * @param n Número de huecos
+ * @param timeout Segundos permitidos por proceso (<= 0 = sin límite)
+ * @param status Salida: estado devuelto por waitpid()
+ * @return Índice del hueco que ha terminado, o -1 si no había procesos
+ *
+ * Bloquea SIGCHLD y duerme en sigtimedwait() hasta que un hijo termina o
+ * vence el timeout más próximo. Al vencer, envía SIGKILL a todo el grupo
+ * de procesos de esa ejecución.
+ */
+int wait_round(pid_t pids[], const struct timespec started[],
+               int timed_out[], int n, int timeout, int *status) {
+  sigset_t chld, old;
+  sigemptyset(&chld);
+  sigaddset(&chld, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &chld, &old);
+
+  int done = -1;
+  while (done < 0) {
+    struct timespec now;
+    double next = -1; // Seconds to the nearest deadline (-1 = none)
+    int active = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    for (int k = 0; k < n && done < 0; k++) {
+      if (pids[k] <= 0)
+        continue;
+      active++;
+      if (waitpid(pids[k], status, WNOHANG) == pids[k]) {
+        kill(-pids[k], SIGKILL); // Leftover children of the run, if any
+        pids[k] = 0;
+        done = k;
+        break;
+      }
+      if (timeout <= 0 || timed_out[k])
+        continue;
+      double left = timeout - elapsed_seconds(&started[k], &now);
+      if (left <= 0) {
+        kill(-pids[k], SIGKILL);
+        timed_out[k] = 1;
+        continue;
+      }
+      if (next < 0 || left < next)
+        next = left;
+    }
+    if (done >= 0 || active == 0)
+      break;
+
+    if (next < 0) {
+      sigwaitinfo(&chld, NULL);
+    } else {
+      struct timespec ts;
+      ts.tv_sec = (time_t)next;
+      ts.tv_nsec = (long)((next - ts.tv_sec) * 1e9) + 1000000;
+      if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+      }
+      sigtimedwait(&chld, NULL, &ts);
+    }
+  }
+
+  sigprocmask(SIG_SETMASK, &old, NULL);
+  return done;
+}
+
 // ... (previous functions unchaged)
 
 /**
@@ -250,18 +463,16 @@ int is_team_dir(const char *base_path, struct dirent *entry) {
 }
 
 /**
- * @brief Compila el código de un equipo con el simulador de competición
+ * @brief Busca el archivo fuente principal de un equipo
  * @param teams_dir Directorio de equipos
  * @param team_name Nombre del equipo
- * @return 0 si OK, -1 si error
+ * @param main_file Buffer donde guardar el nombre del fuente (main.c por
+ * defecto, o el primer .c encontrado)
+ * @param size Tamaño del buffer
  */
-int compile_team(const char *teams_dir, const char *team_name) {
-  char cmd[2048];
-  char comp_path[256];
-  char main_file[256] = "main.c";
-
-  // Get absolute path to competition directory
-  getcwd(comp_path, sizeof(comp_path));
+void find_team_source(const char *teams_dir, const char *team_name,
+                      char *main_file, size_t size) {
+  snprintf(main_file, size, "main.c");
 
   // Check if main.c exists, otherwise look for any .c file
   char test_path[512];
@@ -280,13 +491,29 @@ int compile_team(const char *teams_dir, const char *team_name) {
       while ((entry = readdir(dir)) != NULL) {
         size_t len = strlen(entry->d_name);
         if (len > 2 && strcmp(entry->d_name + len - 2, ".c") == 0) {
-          strncpy(main_file, entry->d_name, sizeof(main_file) - 1);
+          snprintf(main_file, size, "%s", entry->d_name);
           break;
         }
       }
       closedir(dir);
     }
   }
+}
+
+/**
+ * @brief Compila el código de un equipo con el simulador de competición
+ * @param teams_dir Directorio de equipos
+ * @param team_name Nombre del equipo
+ * @return 0 si OK, -1 si error
+ */
+int compile_team(const char *teams_dir, const char *team_name) {
+  char cmd[2048];
+  char comp_path[256];
+  char main_file[256];
+
+  // Get absolute path to competition directory
+  getcwd(comp_path, sizeof(comp_path));
+  find_team_source(teams_dir, team_name, main_file, sizeof(main_file));
 
   // Use precompiled object file from lib/
   // Add -DCOMPETITION_MODE to disable visualization
@@ -312,6 +539,47 @@ int compile_team(const char *teams_dir, const char *team_name) {
   }
 }
 
+/**
+ * @brief Compila el código de un equipo como objeto compartido (modo batch)
+ * @param teams_dir Directorio de equipos
+ * @param team_name Nombre del equipo
+ * @return 0 si OK, -1 si error
+ *
+ * Usa los mismos flags que compile_team() pero enlaza lib/simula_pic.o,
+ * de modo que el simulador se comporta igual que en el binario ./roomba.
+ */
+int compile_team_shared(const char *teams_dir, const char *team_name) {
+  char cmd[2048];
+  char comp_path[256];
+  char main_file[256];
+
+  getcwd(comp_path, sizeof(comp_path));
+  find_team_source(teams_dir, team_name, main_file, sizeof(main_file));
+
+  if (access("lib/simula_pic.o", F_OK) != 0) {
+    printf("  [!] lib/simula_pic.o not found, batch mode disabled\n");
+    return -1;
+  }
+
+  snprintf(cmd, sizeof(cmd),
+           "cd %s/%s && gcc -shared -fPIC -Wall -Wno-unused-function "
+           "-DCOMPETITION_MODE -DCOMPETITION_EXEC_TIME=%d -I%s/.. "
+           "%s %s/lib/simula_pic.o "
+           "%s/competition_ext.c %s/simula_comp.c -lm -o roomba.so 2>&1",
+           teams_dir, team_name, runner_cfg.max_ticks, comp_path, main_file,
+           comp_path, comp_path, comp_path);
+
+  printf("  Compiling %s (batch)... ", team_name);
+  fflush(stdout);
+
+  if (safe_system(cmd) == 0) {
+    printf("✓\n");
+    return 0;
+  }
+  printf("✗ FAILED\n");
+  return -1;
+}
+
 /**
  * @brief Inicializa el archivo config.txt para un equipo
  * @param teams_dir Directorio de equipos
@@ -400,16 +668,105 @@ int get_official_maps(const char *maps_dir, char map_files[][256],
 }
 
 /**
- * @brief Ejecuta todas las rondas para un equipo
+ * @brief Construye una ruta absoluta
+ * @param buf Buffer de salida
+ * @param size Tamaño del buffer
+ * @param base Directorio base (absoluto)
+ * @param path Ruta absoluta o relativa a base
+ */
+void make_abs_path(char *buf, size_t size, const char *base,
+                   const char *path) {
+  if (path[0] == '/')
+    snprintf(buf, size, "%s", path);
+  else
+    snprintf(buf, size, "%s/%s", base, path);
+}
+
+/**
+ * @brief Copia un archivo al final de otro o en su lugar
+ * @param src Origen
+ * @param dst Destino
+ * @param mode "wb" para sobrescribir dst, "ab" para añadir al final
+ * @return 0 si OK, -1 si error
+ */
+static int copy_file_mode(const char *src, const char *dst, const char *mode) {
+  char buf[8192];
+  size_t n;
+  FILE *in = fopen(src, "rb");
+  if (!in)
+    return -1;
+  FILE *out = fopen(dst, mode);
+  if (!out) {
+    fclose(in);
+    return -1;
+  }
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    fwrite(buf, 1, n, out);
+  fclose(in);
+  return fclose(out) == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Copia un archivo
+ * @param src Origen
+ * @param dst Destino (se sobrescribe)
+ * @return 0 si OK, -1 si error
+ */
+static int copy_file(const char *src, const char *dst) {
+  return copy_file_mode(src, dst, "wb");
+}
+
+/**
+ * @brief Crea el stats.csv de un equipo con su cabecera
  * @param teams_dir Directorio de equipos
  * @param team_name Nombre del equipo
- * @return Número de ejecuciones exitosas
  */
-int execute_team_rounds(const char *teams_dir, const char *team_name) {
+void init_team_stats(const char *teams_dir, const char *team_name) {
+  char team_stats[512];
+  snprintf(team_stats, sizeof(team_stats), "%s/%s/stats.csv", teams_dir,
+           team_name);
+  FILE *stats_fd = fopen(team_stats, "w");
+  if (stats_fd) {
+    fprintf(stats_fd,
+            "cell_total, cell_visited, dirt_total, dirt_cleaned, bat_total, "
+            "bat_mean, forward, turn, bumps, clean, load, end\n");
+    fclose(stats_fd);
+  }
+}
+
+/**
+ * @brief Cuenta las líneas de datos del stats.csv de un equipo
+ * @param teams_dir Directorio de equipos
+ * @param team_name Nombre del equipo
+ * @return Número de líneas sin contar la cabecera
+ */
+int count_team_stats(const char *teams_dir, const char *team_name) {
+  char team_stats[512];
+  char line[1024];
+  int lines = 0;
+  snprintf(team_stats, sizeof(team_stats), "%s/%s/stats.csv", teams_dir,
+           team_name);
+  FILE *fd = fopen(team_stats, "r");
+  if (!fd)
+    return 0;
+  while (fgets(line, sizeof(line), fd))
+    lines++;
+  fclose(fd);
+  return lines > 0 ? lines - 1 : 0;
+}
+
+/**
+ * @brief Ejecuta las rondas de un equipo a partir de una dada
+ * @param teams_dir Directorio de equipos
+ * @param team_name Nombre del equipo
+ * @param first_run Primera ronda (0 = todas; si no, continúa el stats.csv)
+ * @return Número de ejecuciones exitosas entre las ejecutadas
+ */
+static int execute_team_rounds_from(const char *teams_dir,
+                                    const char *team_name, int first_run) {
   char cmd[1024];
   char log_stdout[256];
   char log_stderr[256];
-  char team_stats[512];
 
 // Allocate map files dynamically or use a max constant
 // Reusing MAX_TEAMS as a safe upper bound for maps for now or defining MAX_MAPS
@@ -425,20 +782,14 @@ int execute_team_rounds(const char *teams_dir, const char *team_name) {
   int total_runs = maps_to_run * runner_cfg.reps_per_map;
   int successful_runs = 0;
   int crashes = 0;
+  int timeouts = 0;
   int errors = 0;
 
   // ...existing code...
 
   // Initialize team's stats.csv with header
-  snprintf(team_stats, sizeof(team_stats), "%s/%s/stats.csv", teams_dir,
-           team_name);
-  FILE *stats_fd = fopen(team_stats, "w");
-  if (stats_fd) {
-    fprintf(stats_fd,
-            "cell_total, cell_visited, dirt_total, dirt_cleaned, bat_total, "
-            "bat_mean, forward, turn, bumps, clean, load\n");
-    fclose(stats_fd);
-  }
+  if (first_run == 0)
+    init_team_stats(teams_dir, team_name);
 
   // Abrir log de experimentos
   FILE *exp_log = fopen("runner_experiments.log", "a");
@@ -446,9 +797,9 @@ int execute_team_rounds(const char *teams_dir, const char *team_name) {
     fprintf(stderr, "Error opening runner_experiments.log\n");
   }
 
-  printf("  Executing %d rounds for %s:\n", total_runs, team_name);
+  printf("  Executing %d rounds for %s:\n", total_runs - first_run, team_name);
 
-  for (int run = 0; run < total_runs; run++) {
+  for (int run = first_run; run < total_runs; run++) {
     int map_idx = run / runner_cfg.reps_per_map;
     int rep = run % runner_cfg.reps_per_map;
 
@@ -456,10 +807,12 @@ int execute_team_rounds(const char *teams_dir, const char *team_name) {
     char map_arg[300] = "";
 
     if (available_maps > 0) {
-      // Copiar el mapa oficial
-      snprintf(cmd, sizeof(cmd), "cp %s/%s %s/%s/map.pgm", runner_cfg.maps_dir,
-               map_files_buf[map_idx], teams_dir, team_name);
-      safe_system(cmd);
+      // Copiar el mapa oficial (sin lanzar un shell por ronda)
+      char src[512], dst[512];
+      snprintf(src, sizeof(src), "%s/%s", runner_cfg.maps_dir,
+               map_files_buf[map_idx]);
+      snprintf(dst, sizeof(dst), "%s/%s/map.pgm", teams_dir, team_name);
+      copy_file(src, dst);
 
       // Argumento para ./roomba será "map.pgm"
       strcpy(map_arg, "map.pgm");
@@ -473,12 +826,8 @@ int execute_team_rounds(const char *teams_dir, const char *team_name) {
     snprintf(log_stderr, sizeof(log_stderr), "%s/%s_map%d_run%d.stderr",
              runner_cfg.logs_dir, team_name, map_idx, rep);
 
-    // Execute with logging and crash detection
-    // Using configured timeout could be implemented with 'timeout' command if
-    // installed
-    snprintf(cmd, sizeof(cmd),
-             "cd %s/%s && VISUAL=0 ./roomba %s > ../../%s 2> ../../%s",
-             teams_dir, team_name, map_arg, log_stdout, log_stderr);
+    // Execute with logging, crash detection and timeout
+    snprintf(cmd, sizeof(cmd), "%s/%s", teams_dir, team_name);
 
     // Show progress bar
     printf("\r");
@@ -488,8 +837,22 @@ int execute_team_rounds(const char *teams_dir, const char *team_name) {
       printf(" [%s] ", map_files_buf[map_idx]);
     fflush(stdout);
 
-    int result = safe_system(cmd);
-    const char *status = check_execution_result(result, log_stderr);
+    int result = 0;
+    int timed_out = 0;
+    if (dry_run_mode) {
+      printf("[DRY-RUN] Would execute: cd %s && VISUAL=0 ROOMBA_SEED=%" PRIu64
+             " ./roomba %s\n",
+             cmd, round_seed(map_idx, rep), map_arg);
+    } else {
+      struct timespec started;
+      clock_gettime(CLOCK_MONOTONIC, &started);
+      pid_t pid = spawn_round(cmd, "./roomba", map_arg, log_stdout,
+                              log_stderr, round_seed(map_idx, rep));
+      if (pid < 0 || wait_round(&pid, &started, &timed_out, 1,
+                                runner_cfg.timeout_seconds, &result) < 0)
+        result = 127 << 8; // Could not launch: report as error
+    }
+    const char *status = check_execution_result(result, timed_out, log_stderr);
 
     // Log de experimento
     if (exp_log) {
@@ -503,14 +866,18 @@ int execute_team_rounds(const char *teams_dir, const char *team_name) {
       successful_runs++;
     } else if (strcmp(status, "crash") == 0) {
       crashes++;
+    } else if (strcmp(status, "timeout") == 0) {
+      timeouts++;
     } else if (strcmp(status, "error") == 0) {
       errors++;
     }
 
     // Limpieza de mapa copiado
     if (available_maps > 0) {
-      snprintf(cmd, sizeof(cmd), "rm -f %s/%s/map.pgm", teams_dir, team_name);
-      safe_system(cmd);
+      char map_copy[512];
+      snprintf(map_copy, sizeof(map_copy), "%s/%s/map.pgm", teams_dir,
+               team_name);
+      unlink(map_copy);
     }
   }
 
@@ -524,12 +891,729 @@ int execute_team_rounds(const char *teams_dir, const char *team_name) {
   printf(" [OK] Done\n");
 
   // Summary
-  printf("  Results: %d OK, %d CRASH, %d ERROR (Total: %d/%d successful)\n\n",
-         successful_runs, crashes, errors, successful_runs, total_runs);
+  printf("  Results: %d OK, %d CRASH, %d TIMEOUT, %d ERROR "
+         "(Total: %d/%d successful)\n\n",
+         successful_runs, crashes, timeouts, errors, successful_runs,
+         total_runs - first_run);
 
   return successful_runs;
 }
 
+/**
+ * @brief Ejecuta todas las rondas para un equipo
+ * @param teams_dir Directorio de equipos
+ * @param team_name Nombre del equipo
+ * @return Número de ejecuciones exitosas
+ */
+int execute_team_rounds(const char *teams_dir, const char *team_name) {
+  return execute_team_rounds_from(teams_dir, team_name, 0);
+}
+
+/* ============================================================================
+ * MODO BATCH (una sola carga del código del equipo)
+ * ============================================================================
+ */
+
+#define MAX_DATA_SEGMENTS 4
+
+/**
+ * @brief Copia de los segmentos de datos escribibles del objeto del equipo
+ *
+ * Restaurarla antes de cada ronda deja las variables globales del equipo
+ * (y las del simulador enlazado en el .so) como recién cargadas, igual que
+ * en una ejecución en un proceso nuevo.
+ */
+typedef struct {
+  const char *path;
+  int count;
+  unsigned char *addr[MAX_DATA_SEGMENTS];
+  size_t len[MAX_DATA_SEGMENTS];
+  unsigned char *copy[MAX_DATA_SEGMENTS];
+} data_snapshot_t;
+
+#ifdef __linux__
+/**
+ * @brief Callback de dl_iterate_phdr: localiza los datos escribibles del .so
+ */
+static int snapshot_phdr_cb(struct dl_phdr_info *info, size_t size,
+                            void *data) {
+  data_snapshot_t *snap = (data_snapshot_t *)data;
+  (void)size;
+  if (!info->dlpi_name || strcmp(info->dlpi_name, snap->path) != 0)
+    return 0;
+
+  // RELRO (.got, .data.rel.ro) queda de solo lectura tras la reubicación
+  ElfW(Addr) relro_end = 0;
+  for (int i = 0; i < info->dlpi_phnum; i++) {
+    const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+    if (ph->p_type == PT_GNU_RELRO)
+      relro_end = info->dlpi_addr + ph->p_vaddr + ph->p_memsz;
+  }
+  for (int i = 0; i < info->dlpi_phnum && snap->count < MAX_DATA_SEGMENTS;
+       i++) {
+    const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+    if (ph->p_type != PT_LOAD || !(ph->p_flags & PF_W))
+      continue;
+    ElfW(Addr) start = info->dlpi_addr + ph->p_vaddr;
+    ElfW(Addr) end = start + ph->p_memsz;
+    if (relro_end > start && relro_end < end)
+      start = relro_end;
+    else if (relro_end >= end)
+      continue;
+    snap->addr[snap->count] = (unsigned char *)start;
+    snap->len[snap->count] = end - start;
+    snap->count++;
+  }
+  return 1;
+}
+#endif
+
+/**
+ * @brief Guarda los segmentos de datos de un objeto recién cargado
+ * @param snap Snapshot a rellenar (snap->path = ruta pasada a dlopen)
+ * @return 0 si OK, -1 si no está soportado o no hay memoria
+ */
+static int data_snapshot_take(data_snapshot_t *snap) {
+#ifdef __linux__
+  snap->count = 0;
+  dl_iterate_phdr(snapshot_phdr_cb, snap);
+  if (snap->count == 0)
+    return -1;
+  for (int i = 0; i < snap->count; i++) {
+    snap->copy[i] = malloc(snap->len[i]);
+    if (!snap->copy[i])
+      return -1;
+    memcpy(snap->copy[i], snap->addr[i], snap->len[i]);
+  }
+  return 0;
+#else
+  (void)snap;
+  return -1;
+#endif
+}
+
+/**
+ * @brief Restaura los segmentos de datos guardados
+ * @param snap Snapshot obtenido con data_snapshot_take()
+ */
+static void data_snapshot_restore(const data_snapshot_t *snap) {
+  for (int i = 0; i < snap->count; i++)
+    memcpy(snap->addr[i], snap->copy[i], snap->len[i]);
+}
+
+/**
+ * @brief Redirige stdout/stderr a los logs de una ronda
+ * @param log_stdout Ruta del log de salida estándar
+ * @param log_stderr Ruta del log de errores
+ * @param saved Descriptores originales (salida)
+ */
+static void redirect_round_output(const char *log_stdout,
+                                  const char *log_stderr, int saved[2]) {
+  fflush(stdout);
+  fflush(stderr);
+  saved[0] = dup(STDOUT_FILENO);
+  saved[1] = dup(STDERR_FILENO);
+  int out = open(log_stdout, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  int err = open(log_stderr, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out >= 0) {
+    dup2(out, STDOUT_FILENO);
+    close(out);
+  }
+  if (err >= 0) {
+    dup2(err, STDERR_FILENO);
+    close(err);
+  }
+}
+
+/**
+ * @brief Restaura stdout/stderr tras una ronda
+ * @param saved Descriptores devueltos por redirect_round_output()
+ */
+static void restore_round_output(int saved[2]) {
+  fflush(stdout);
+  fflush(stderr);
+  dup2(saved[0], STDOUT_FILENO);
+  dup2(saved[1], STDERR_FILENO);
+  close(saved[0]);
+  close(saved[1]);
+}
+
+/**
+ * @brief Progreso del hijo del modo batch, compartido con el runner
+ *
+ * Vive en memoria compartida (mmap): si el hijo muere a mitad de una ronda,
+ * el runner sabe cuál era y si la cortó el vigilante de tiempo.
+ */
+typedef struct {
+  volatile int next;                ///< Ronda en curso o siguiente
+  volatile int ok;                  ///< Rondas terminadas con éxito
+  volatile sig_atomic_t timed_out;  ///< La ronda next agotó su tiempo
+} batch_progress_t;
+
+/// Progreso del hijo batch (para el manejador de SIGALRM)
+static batch_progress_t *batch_progress;
+
+/**
+ * @brief Vigilante de una ronda batch: agotó timeout_seconds
+ * @param signo Número de señal (no usado)
+ *
+ * El código del equipo sigue dentro de comportamiento(): no hay forma
+ * segura de volver, así que el hijo termina y el runner sigue desde la
+ * ronda siguiente.
+ */
+static void batch_round_timeout(int signo) {
+  (void)signo;
+  batch_progress->timed_out = 1;
+  _exit(3);
+}
+
+/**
+ * @brief Proceso hijo del modo batch: ejecuta las rondas de un equipo
+ * @param team_dir Directorio del equipo (ruta absoluta)
+ * @param maps_dir Directorio de mapas oficiales (ruta absoluta)
+ * @param map_files Nombres de los mapas oficiales
+ * @param available_maps Número de mapas oficiales (0 = mapa aleatorio)
+ * @param first_run Primera ronda a ejecutar
+ * @param total_runs Número total de rondas
+ * @param team_name Nombre del equipo
+ * @param logs_dir Directorio de logs (ruta absoluta)
+ * @param exp_log_path Ruta absoluta de runner_experiments.log
+ * @param progress Progreso compartido con el runner
+ * @return Código de salida del proceso (0 si todas las rondas terminaron)
+ *
+ * Cada ronda tiene su propio plazo de timeout_seconds (SIGALRM).
+ */
+static int run_batch_child(const char *team_dir, const char *maps_dir,
+                           char map_files[][256], int available_maps,
+                           int first_run, int total_runs,
+                           const char *team_name, const char *logs_dir,
+                           const char *exp_log_path,
+                           batch_progress_t *progress) {
+  char so_path[768];
+  snprintf(so_path, sizeof(so_path), "%s/roomba.so", team_dir);
+  if (chdir(team_dir) != 0)
+    return 2;
+
+  void *handle = dlopen(so_path, RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    fprintf(stderr, "  [!] dlopen: %s\n", dlerror());
+    return 2;
+  }
+  int (*team_main)(int, char **) =
+      (int (*)(int, char **))dlsym(handle, "main");
+  void (*batch_enable)(void) = (void (*)(void))dlsym(handle, "sim_batch_enable");
+  void (*batch_finish)(void) =
+      (void (*)(void))dlsym(handle, "sim_batch_finish_run");
+  if (!team_main || !batch_enable || !batch_finish) {
+    fprintf(stderr, "  [!] roomba.so lacks main() or batch entry points\n");
+    return 2;
+  }
+
+  // Parse every official map once: the cache lives in the team's data
+  // segment, so the templates become part of the snapshot and each round
+  // only copies the cells of its map.
+  int (*cache_preload)(const char *) =
+      (int (*)(const char *))dlsym(handle, "sim_world_cache_preload");
+  char (*map_paths)[768] = NULL;
+  if (available_maps > 0) {
+    map_paths = calloc(available_maps, sizeof(*map_paths));
+    if (!map_paths)
+      return 2;
+    for (int i = 0; i < available_maps; i++) {
+      snprintf(map_paths[i], sizeof(map_paths[i]), "%s/%s", maps_dir,
+               map_files[i]);
+      if (cache_preload)
+        cache_preload(map_paths[i]);
+    }
+  }
+
+  data_snapshot_t snap = {.path = so_path};
+  if (data_snapshot_take(&snap) != 0) {
+    fprintf(stderr, "  [!] Cannot snapshot team data segment\n");
+    return 2;
+  }
+
+  struct sigaction sa = {0};
+  sa.sa_handler = batch_round_timeout;
+  sigemptyset(&sa.sa_mask);
+  batch_progress = progress;
+  sigaction(SIGALRM, &sa, NULL);
+
+  FILE *exp_log = fopen(exp_log_path, "a");
+  for (int run = first_run; run < total_runs; run++) {
+    int map_idx = run / runner_cfg.reps_per_map;
+    int rep = run % runner_cfg.reps_per_map;
+    char log_stdout[1024], log_stderr[1024];
+    snprintf(log_stdout, sizeof(log_stdout), "%s/%s_map%d_run%d.stdout",
+             logs_dir, team_name, map_idx, rep);
+    snprintf(log_stderr, sizeof(log_stderr), "%s/%s_map%d_run%d.stderr",
+             logs_dir, team_name, map_idx, rep);
+
+    printf("\r");
+    print_progress_bar(run, total_runs, 30);
+    printf(" Map %d Rep %d [batch] ", map_idx, rep);
+    fflush(stdout);
+
+    // Fresh process state: team globals, simulator state and map
+    data_snapshot_restore(&snap);
+    batch_enable();
+    char *argv[3] = {"roomba", NULL, NULL};
+    int argc = 1;
+    if (available_maps > 0) {
+      // Ruta del mapa oficial: load_map() la encuentra en la caché
+      argv[1] = map_paths[map_idx];
+      argc = 2;
+    }
+
+    set_round_seed(round_seed(map_idx, rep));
+    int saved[2];
+    redirect_round_output(log_stdout, log_stderr, saved);
+    progress->next = run;
+    if (runner_cfg.timeout_seconds > 0)
+      alarm(runner_cfg.timeout_seconds);
+    int rc = team_main(argc, argv);
+    batch_finish();
+    alarm(0);
+    restore_round_output(saved);
+
+    if (exp_log) {
+      fprintf(exp_log, "TEAM=%s MAP=%s IDX=%d REP=%d STATUS=%s\n", team_name,
+              (available_maps > 0) ? map_files[map_idx] : "N/A", map_idx,
+              rep, rc == 0 ? "success" : "error");
+      fflush(exp_log);
+    }
+    if (rc == 0)
+      progress->ok++;
+    progress->next = run + 1;
+  }
+  if (exp_log)
+    fclose(exp_log);
+  free(map_paths);
+  return 0;
+}
+
+/**
+ * @brief Ejecuta todas las rondas de un equipo en un único proceso
+ * @param teams_dir Directorio de equipos
+ * @param team_name Nombre del equipo
+ * @return Número de ejecuciones exitosas, o -1 si el modo batch no pudo
+ * empezar y debe repetirse el equipo en modo proceso
+ *
+ * El código del equipo (compilado como roomba.so) se carga en un proceso
+ * hijo, que llama a su main() en cada ronda tras restaurar sus datos
+ * globales. El hijo aísla al runner de los fallos del equipo:
+ * - Una ronda que agota timeout_seconds se anota como timeout y un hijo
+ *   nuevo sigue desde la ronda siguiente.
+ * - Si el hijo falla de otra forma (crash, exit()), las rondas que faltan,
+ *   empezando por la que falló, se ejecutan en modo proceso.
+ */
+int execute_team_rounds_batch(const char *teams_dir, const char *team_name) {
+  char comp_path[256];
+  char team_dir[512];
+  char logs_dir[512];
+  char exp_log_path[512];
+  char maps_dir[512];
+  char map_files_buf[MAX_MAPS][256];
+
+  getcwd(comp_path, sizeof(comp_path));
+  make_abs_path(team_dir, sizeof(team_dir), comp_path, teams_dir);
+  strncat(team_dir, "/", sizeof(team_dir) - strlen(team_dir) - 1);
+  strncat(team_dir, team_name, sizeof(team_dir) - strlen(team_dir) - 1);
+  make_abs_path(logs_dir, sizeof(logs_dir), comp_path, runner_cfg.logs_dir);
+  snprintf(exp_log_path, sizeof(exp_log_path), "%s/runner_experiments.log",
+           comp_path);
+
+  int available_maps = get_official_maps(runner_cfg.maps_dir, map_files_buf,
+                                         runner_cfg.maps_count);
+  make_abs_path(maps_dir, sizeof(maps_dir), comp_path, runner_cfg.maps_dir);
+  int maps_to_run =
+      (available_maps > 0) ? available_maps : runner_cfg.maps_count;
+  int total_runs = maps_to_run * runner_cfg.reps_per_map;
+
+  batch_progress_t *progress =
+      mmap(NULL, sizeof(*progress), PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (progress == MAP_FAILED)
+    return -1;
+
+  init_team_stats(teams_dir, team_name);
+  printf("  Executing %d rounds for %s (batch):\n", total_runs, team_name);
+  fflush(stdout);
+
+  int first = 0, ok = 0, timeouts = 0;
+  const char *failure = NULL;
+  while (first < total_runs && !failure) {
+    progress->next = first;
+    progress->ok = 0;
+    progress->timed_out = 0;
+    pid_t pid = fork();
+    if (pid < 0) {
+      failure = "fork";
+      break;
+    }
+    if (pid == 0) {
+      setpgid(0, 0);
+      _exit(run_batch_child(team_dir, maps_dir, map_files_buf, available_maps,
+                            first, total_runs, team_name, logs_dir,
+                            exp_log_path, progress));
+    }
+
+    // Cada ronda tiene su plazo en el hijo; este, una ronda más holgado,
+    // solo cubre a un equipo que bloquee SIGALRM
+    int status;
+    int timed_out = 0;
+    struct timespec started;
+    setpgid(pid, pid);
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    int budget = runner_cfg.timeout_seconds > 0
+                     ? runner_cfg.timeout_seconds * (total_runs - first + 1)
+                     : 0;
+    wait_round(&pid, &started, &timed_out, 1, budget, &status);
+    ok += progress->ok;
+    first = progress->next;
+    if (first >= total_runs)
+      break;
+
+    if (progress->timed_out || timed_out) {
+      // La ronda colgada no llega a escribir su línea: la anota el runner
+      int map_idx = first / runner_cfg.reps_per_map;
+      int rep = first % runner_cfg.reps_per_map;
+      char log_stderr[1024];
+      snprintf(log_stderr, sizeof(log_stderr), "%s/%s_map%d_run%d.stderr",
+               logs_dir, team_name, map_idx, rep);
+      const char *st = check_execution_result(0, 1, log_stderr);
+      FILE *exp_log = fopen(exp_log_path, "a");
+      if (exp_log) {
+        fprintf(exp_log, "TEAM=%s MAP=%s IDX=%d REP=%d STATUS=%s\n",
+                team_name,
+                (available_maps > 0) ? map_files_buf[map_idx] : "N/A",
+                map_idx, rep, st);
+        fclose(exp_log);
+      }
+      printf("\n  [!] Map %d Rep %d timed out (batch), continuing\n", map_idx,
+             rep);
+      timeouts++;
+      first++;
+    } else {
+      failure = WIFSIGNALED(status) ? "crash" : "early exit";
+    }
+  }
+  munmap(progress, sizeof(*progress));
+
+  if (failure) {
+    printf("\n  [!] Batch run stopped at round %d/%d (%s), "
+           "running the rest in process mode\n",
+           first, total_runs, failure);
+    if (first == 0)
+      return -1;
+    if (compile_team(teams_dir, team_name) != 0) {
+      printf("  Skipping remaining rounds due to compilation errors\n");
+      return ok;
+    }
+    return ok + execute_team_rounds_from(teams_dir, team_name, first);
+  }
+
+  printf("\r");
+  print_progress_bar(total_runs, total_runs, 30);
+  printf(" [OK] Done\n");
+  printf("  Results: %d OK, %d TIMEOUT (Total: %d/%d successful, batch)\n\n",
+         ok, timeouts, ok, total_runs);
+  return ok;
+}
+
+/* ============================================================================
+ * EJECUCIÓN PARALELA (pool de workers)
+ * ============================================================================
+ */
+
+/**
+ * @brief Una ejecución (equipo, mapa, repetición) del torneo
+ */
+typedef struct {
+  int team;           ///< Índice en la lista de equipos
+  int map_idx;        ///< Índice del mapa
+  int rep;            ///< Repetición dentro del mapa
+  const char *status; ///< Resultado según check_execution_result()
+  char *stats;        ///< Líneas que la ejecución añadió a stats.csv
+} round_job_t;
+
+/**
+ * @brief Lee un archivo completo en memoria
+ * @param path Ruta del archivo
+ * @return Contenido terminado en '\0' (liberar con free), o NULL si no existe
+ */
+static char *read_whole_file(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return NULL;
+  size_t cap = 256, len = 0, n;
+  char *buf = malloc(cap);
+  while (buf && (n = fread(buf + len, 1, cap - len - 1, f)) > 0) {
+    len += n;
+    if (cap - len - 1 == 0) {
+      char *tmp = realloc(buf, cap * 2);
+      if (!tmp) {
+        free(buf);
+        buf = NULL;
+        break;
+      }
+      buf = tmp;
+      cap *= 2;
+    }
+  }
+  fclose(f);
+  if (buf)
+    buf[len] = '\0';
+  return buf;
+}
+
+/**
+ * @brief Prepara el directorio de trabajo de un worker para una ejecución
+ * @param workdir Directorio privado del worker
+ * @param map_path Mapa a copiar como map.pgm (NULL = mapa aleatorio)
+ * @return 0 si OK, -1 si error
+ *
+ * ../roomba se ejecuta desde workdir igual que en modo serie, de modo que
+ * map.pgm y stats.csv no se comparten entre workers.
+ */
+static int prepare_worker_dir(const char *workdir, const char *map_path) {
+  char path[1024];
+  mkdir(workdir, 0755);
+  snprintf(path, sizeof(path), "%s/stats.csv", workdir);
+  unlink(path);
+  if (!map_path)
+    return 0;
+  snprintf(path, sizeof(path), "%s/map.pgm", workdir);
+  return copy_file(map_path, path);
+}
+
+/**
+ * @brief Borra los directorios de trabajo de los workers de un equipo
+ * @param teams_dir Directorio de equipos
+ * @param team Nombre del equipo
+ * @param workers Número de workers
+ *
+ * Solo borra los archivos que escribe el simulador; si el equipo ha dejado
+ * otros, el directorio se conserva y se avisa.
+ */
+static void remove_worker_dirs(const char *teams_dir, const char *team,
+                               int workers) {
+  static const char *const files[] = {
+      "stats.csv",   "map.pgm",     "log.csv",     "log.bin",
+      "actions.bin", "latency.csv", "heatmap.bin",
+  };
+  char dir[1024], path[1100];
+  for (int k = 0; k < workers; k++) {
+    snprintf(dir, sizeof(dir), "%s/%s/.worker%d", teams_dir, team, k);
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+      snprintf(path, sizeof(path), "%s/%s", dir, files[i]);
+      unlink(path);
+    }
+    if (rmdir(dir) != 0 && errno != ENOENT)
+      fprintf(stderr, "Warning: Cannot remove %s: %s\n", dir,
+              strerror(errno));
+  }
+}
+
+/**
+ * @brief Mata y recoge las rondas que siguen en marcha
+ * @param pids Procesos en curso (0 = hueco libre); quedan todos a 0
+ * @param n Número de huecos
+ */
+static void stop_slots(pid_t pids[], int n) {
+  for (int k = 0; k < n; k++) {
+    if (pids[k] <= 0)
+      continue;
+    kill(-pids[k], SIGKILL);
+    waitpid(pids[k], NULL, 0);
+    pids[k] = 0;
+  }
+}
+
+/**
+ * @brief Ejecuta todas las rondas de varios equipos con un pool de workers
+ * @param teams_dir Directorio de equipos
+ * @param teams Equipos (ya compilados)
+ * @param runs Salida: ejecuciones exitosas de cada equipo
+ * @param team_count Número de equipos
+ * @param workers Número máximo de ejecuciones simultáneas
+ *
+ * Cada worker k usa teams/<equipo>/.worker<k>/ como directorio de trabajo.
+ * Al terminar, los stats.csv de los equipos y runner_experiments.log se
+ * escriben en el mismo orden (equipo, mapa, repetición) que en modo serie,
+ * así que el ranking no depende del orden en que acaban las ejecuciones.
+ */
+void execute_rounds_parallel(const char *teams_dir, char *teams[], int runs[],
+                             int team_count, int workers) {
+  char comp_path[256];
+  char abs_teams[512], abs_maps[512], abs_logs[512];
+  char map_files_buf[MAX_MAPS][256];
+
+  getcwd(comp_path, sizeof(comp_path));
+  make_abs_path(abs_teams, sizeof(abs_teams), comp_path, teams_dir);
+  make_abs_path(abs_maps, sizeof(abs_maps), comp_path, runner_cfg.maps_dir);
+  make_abs_path(abs_logs, sizeof(abs_logs), comp_path, runner_cfg.logs_dir);
+  int available_maps = get_official_maps(runner_cfg.maps_dir, map_files_buf,
+                                         runner_cfg.maps_count);
+  int maps_to_run =
+      (available_maps > 0) ? available_maps : runner_cfg.maps_count;
+  int runs_per_team = maps_to_run * runner_cfg.reps_per_map;
+  int total_jobs = runs_per_team * team_count;
+
+  round_job_t *jobs = calloc(total_jobs > 0 ? total_jobs : 1, sizeof(*jobs));
+  pid_t *slot_pid = calloc(workers, sizeof(*slot_pid));
+  int *slot_job = calloc(workers, sizeof(*slot_job));
+  int *slot_timeout = calloc(workers, sizeof(*slot_timeout));
+  struct timespec *slot_start = calloc(workers, sizeof(*slot_start));
+  if (!jobs || !slot_pid || !slot_job || !slot_timeout || !slot_start) {
+    fprintf(stderr, "Error: Out of memory for %d jobs\n", total_jobs);
+    free(jobs);
+    free(slot_pid);
+    free(slot_job);
+    free(slot_timeout);
+    free(slot_start);
+    return;
+  }
+  for (int i = 0; i < total_jobs; i++) {
+    jobs[i].team = i / runs_per_team;
+    jobs[i].map_idx = (i % runs_per_team) / runner_cfg.reps_per_map;
+    jobs[i].rep = i % runner_cfg.reps_per_map;
+    jobs[i].status = "error";
+  }
+
+  printf("Executing %d rounds with %d workers:\n", total_jobs, workers);
+
+  char path[1024], map_path[1024], log_stdout[1024], log_stderr[1024];
+  int next = 0, running = 0, done = 0;
+  while (done < total_jobs) {
+    // Fill every idle worker
+    for (int k = 0; k < workers && next < total_jobs; k++) {
+      if (slot_pid[k] > 0)
+        continue;
+      round_job_t *job = &jobs[next];
+      const char *team = teams[job->team];
+      snprintf(path, sizeof(path), "%s/%s/.worker%d", abs_teams, team, k);
+      snprintf(map_path, sizeof(map_path), "%s/%s", abs_maps,
+               map_files_buf[job->map_idx]);
+      snprintf(log_stdout, sizeof(log_stdout), "%s/%s_map%d_run%d.stdout",
+               abs_logs, team, job->map_idx, job->rep);
+      snprintf(log_stderr, sizeof(log_stderr), "%s/%s_map%d_run%d.stderr",
+               abs_logs, team, job->map_idx, job->rep);
+
+      pid_t pid = -1;
+      if (prepare_worker_dir(path, (available_maps > 0) ? map_path : NULL) ==
+          0)
+        pid = spawn_round(path, "../roomba",
+                          (available_maps > 0) ? "map.pgm" : "", log_stdout,
+                          log_stderr, round_seed(job->map_idx, job->rep));
+      if (pid < 0) {
+        // Cannot launch: leave the job as "error" and move on
+        next++;
+        done++;
+        continue;
+      }
+      clock_gettime(CLOCK_MONOTONIC, &slot_start[k]);
+      slot_timeout[k] = 0;
+      slot_pid[k] = pid;
+      slot_job[k] = next++;
+      running++;
+    }
+    if (running == 0)
+      continue;
+
+    // Collect whichever worker finishes first (or kill it on timeout)
+    int status;
+    int k = wait_round(slot_pid, slot_start, slot_timeout, workers,
+                       runner_cfg.timeout_seconds, &status);
+    if (k < 0) {
+      // No debería pasar con running > 0: no dejar rondas huérfanas
+      fprintf(stderr, "Error: Lost track of %d running rounds, stopping\n",
+              running);
+      stop_slots(slot_pid, workers);
+      break;
+    }
+
+    round_job_t *job = &jobs[slot_job[k]];
+    const char *team = teams[job->team];
+    snprintf(log_stderr, sizeof(log_stderr), "%s/%s_map%d_run%d.stderr",
+             runner_cfg.logs_dir, team, job->map_idx, job->rep);
+    job->status = check_execution_result(status, slot_timeout[k], log_stderr);
+    snprintf(path, sizeof(path), "%s/%s/.worker%d/stats.csv", teams_dir, team,
+             k);
+    job->stats = read_whole_file(path);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s/.worker%d/map.pgm", teams_dir, team,
+             k);
+    unlink(path);
+
+    running--;
+    done++;
+    printf("\r");
+    print_progress_bar(done, total_jobs, 30);
+    printf(" %s Map %d Rep %d   ", team, job->map_idx, job->rep);
+    fflush(stdout);
+  }
+  printf("\n\n");
+
+  // Deterministic merge: same order as the serial runner
+  FILE *exp_log = fopen("runner_experiments.log", "a");
+  for (int t = 0; t < team_count; t++) {
+    int ok = 0, crashes = 0, timeouts = 0, errors = 0;
+    char team_stats[512];
+
+    init_team_stats(teams_dir, teams[t]);
+    snprintf(team_stats, sizeof(team_stats), "%s/%s/stats.csv", teams_dir,
+             teams[t]);
+    FILE *stats_fd = fopen(team_stats, "a");
+    for (int i = t * runs_per_team; i < (t + 1) * runs_per_team; i++) {
+      if (stats_fd && jobs[i].stats)
+        fputs(jobs[i].stats, stats_fd);
+      if (exp_log)
+        fprintf(exp_log, "TEAM=%s MAP=%s IDX=%d REP=%d STATUS=%s\n",
+                teams[t],
+                (available_maps > 0) ? map_files_buf[jobs[i].map_idx] : "N/A",
+                jobs[i].map_idx, jobs[i].rep, jobs[i].status);
+      if (strcmp(jobs[i].status, "success") == 0)
+        ok++;
+      else if (strcmp(jobs[i].status, "crash") == 0)
+        crashes++;
+      else if (strcmp(jobs[i].status, "timeout") == 0)
+        timeouts++;
+      else if (strcmp(jobs[i].status, "error") == 0)
+        errors++;
+      free(jobs[i].stats);
+    }
+    if (stats_fd)
+      fclose(stats_fd);
+
+    // Los registros de heatmap.bin (ROOMBA_HEATMAP) no dependen del orden
+    char heatmap[512];
+    snprintf(team_stats, sizeof(team_stats), "%s/%s/heatmap.bin", teams_dir,
+             teams[t]);
+    for (int k = 0; k < workers; k++) {
+      snprintf(heatmap, sizeof(heatmap), "%s/%s/.worker%d/heatmap.bin",
+               teams_dir, teams[t], k);
+      copy_file_mode(heatmap, team_stats, "ab");
+    }
+
+    remove_worker_dirs(teams_dir, teams[t], workers);
+
+    printf("  %s: %d OK, %d CRASH, %d TIMEOUT, %d ERROR "
+           "(Total: %d/%d successful)\n",
+           teams[t], ok, crashes, timeouts, errors, ok, runs_per_team);
+    runs[t] = ok;
+  }
+  if (exp_log)
+    fclose(exp_log);
+  printf("\n");
+
+  free(jobs);
+  free(slot_pid);
+  free(slot_job);
+  free(slot_timeout);
+  free(slot_start);
+}
+
 /**
  * @brief Valida que todos los archivos de log esperados existen
  * @param team_name Nombre del equipo
@@ -728,6 +1812,52 @@ void display_ranking(const char *stats_file) {
   }
 }
 
+/**
+ * @brief Ejecuta la competición con un pool de workers (-j N)
+ * @param teams_dir Directorio de equipos
+ * @param teams Equipos descubiertos
+ * @param team_count Número de equipos
+ * @param stats_file Archivo de estadísticas central
+ * @return Número de equipos con al menos una ejecución exitosa
+ *
+ * Compila todos los equipos, reparte sus rondas entre los workers y
+ * consolida los resultados en el mismo orden que el modo serie.
+ */
+int run_competition_parallel(const char *teams_dir, char *teams[],
+                             int team_count, const char *stats_file) {
+  char *compiled[MAX_TEAMS];
+  int runs[MAX_TEAMS];
+  int compiled_count = 0;
+  int successful_teams = 0;
+
+  for (int i = 0; i < team_count; i++) {
+    printf("▶ Compiling Team %d/%d: %s\n", i + 1, team_count, teams[i]);
+    init_team_config(teams_dir, teams[i]);
+    if (compile_team(teams_dir, teams[i]) == 0)
+      compiled[compiled_count++] = teams[i];
+    else
+      printf("  Skipping due to compilation errors\n");
+  }
+  printf("\n");
+  if (compiled_count == 0)
+    return 0;
+
+  execute_rounds_parallel(teams_dir, compiled, runs, compiled_count,
+                          runner_cfg.workers);
+
+  for (int i = 0; i < compiled_count; i++) {
+    validate_team_logs(compiled[i],
+                       runner_cfg.maps_count * runner_cfg.reps_per_map);
+    if (runs[i] > 0) {
+      successful_teams++;
+      consolidate_team_stats(teams_dir, compiled[i], stats_file);
+    } else {
+      printf("  [!] Warning: Team %s had 0 successful runs\n", compiled[i]);
+    }
+  }
+  return successful_teams;
+}
+
 /**
  * @brief Función principal del runner de competición
  */
@@ -746,6 +1876,13 @@ int main(int argc, char *argv[]) {
       dry_run_mode = 1;
     } else if (strcmp(argv[i], "--test") == 0) {
       test_mode = 1;
+    } else if (strcmp(argv[i], "--batch") == 0) {
+      runner_cfg.batch_mode = 1;
+    } else if (strncmp(argv[i], "-j", 2) == 0) {
+      const char *n = argv[i][2] ? argv[i] + 2 : "";
+      if (!argv[i][2] && i + 1 < argc)
+        n = argv[++i];
+      runner_cfg.workers = atoi(n);
     } else if (strncmp(argv[i], "--team=", 7) == 0) {
       single_team = argv[i] + 7;
     } else if (argv[i][0] != '-') {
@@ -753,12 +1890,21 @@ int main(int argc, char *argv[]) {
     } else {
       fprintf(stderr, "Unknown option: %s\n", argv[i]);
       fprintf(stderr,
-              "Usage: %s [teams_dir] [--dry-run] [--test] [--team=XX]\n",
+              "Usage: %s [teams_dir] [--dry-run] [--test] [--batch] "
+              "[-j N] [--team=XX]\n",
               argv[0]);
       return 1;
     }
   }
 
+  if (runner_cfg.workers < 1)
+    runner_cfg.workers = 1;
+  if (runner_cfg.batch_mode && runner_cfg.workers > 1) {
+    printf("[!] Batch mode runs teams one at a time, ignoring workers = %d\n",
+           runner_cfg.workers);
+    runner_cfg.workers = 1;
+  }
+
   // Apply test mode overrides
   if (test_mode) {
     runner_cfg.maps_count = 1;
@@ -780,6 +1926,8 @@ int main(int argc, char *argv[]) {
   printf("  Logs Directory: %s\n", runner_cfg.logs_dir);
   printf("  Timeout: %ds\n", runner_cfg.timeout_seconds);
   printf("  Max Ticks: %d\n", runner_cfg.max_ticks);
+  printf("  Execution: %s\n", runner_cfg.batch_mode ? "batch" : "process");
+  printf("  Workers: %d\n", runner_cfg.workers);
   if (dry_run_mode) {
     printf("[DRY RUN MODE - No execution, just showing what would run]\n");
   }
@@ -804,7 +1952,8 @@ int main(int argc, char *argv[]) {
   printf("\n");
 
   // Check if simula.o exists, if not build it
-  if (access("lib/simula.o", F_OK) != 0) {
+  if (access("lib/simula.o", F_OK) != 0 ||
+      (runner_cfg.batch_mode && access("lib/simula_pic.o", F_OK) != 0)) {
     printf("⚙️  Building competition library...\n");
     int result = safe_system("cd .. && make lib-competition > /dev/null 2>&1");
     if (result != 0) {
@@ -870,17 +2019,31 @@ int main(int argc, char *argv[]) {
 
   // Execution Phase
   int successful_teams = 0;
-  for (int i = 0; i < team_count; i++) {
+  int parallel = runner_cfg.workers > 1 && !dry_run_mode;
+  if (parallel) {
+    successful_teams =
+        run_competition_parallel(teams_dir, teams, team_count, stats_file);
+    for (int i = 0; i < team_count; i++)
+      free(teams[i]);
+  }
+  for (int i = 0; !parallel && i < team_count; i++) {
     printf("▶ Processing Team %d/%d: %s\n", i + 1, team_count, teams[i]);
 
     // Initialize config
     init_team_config(teams_dir, teams[i]);
 
+    // Batch mode: load the team once, fall back to one process per round
+    int runs = -1;
+    if (runner_cfg.batch_mode && !dry_run_mode &&
+        compile_team_shared(teams_dir, teams[i]) == 0)
+      runs = execute_team_rounds_batch(teams_dir, teams[i]);
+
     // Compile
-    if (compile_team(teams_dir, teams[i]) == 0 ||
+    if (runs >= 0 || compile_team(teams_dir, teams[i]) == 0 ||
         dry_run_mode) { // Allow continue in dry-run
       // Run rounds
-      int runs = execute_team_rounds(teams_dir, teams[i]);
+      if (runs < 0)
+        runs = execute_team_rounds(teams_dir, teams[i]);
 
       // Validate logs were created
       validate_team_logs(teams[i],
@@ -35,7 +35,7 @@ def process_team(team_path: Path):
     # Prepare per-map files
     map_files = [open(target_dir / f'map{m}_stats.csv', 'w') for m in range(MAPS_COUNT)]
     # write header for map files (use same header as runner's teams/stats.csv)
-    header = 'cell_total, cell_visited, dirt_total, dirt_cleaned, bat_total, bat_mean, forward, turn, bumps, clean, load\n'
+    header = 'cell_total, cell_visited, dirt_total, dirt_cleaned, bat_total, bat_mean, forward, turn, bumps, clean, load, end\n'
     for f in map_files:
         f.write(header)
 
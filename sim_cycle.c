@@ -0,0 +1,285 @@
+/**
+ * @file sim_cycle.c
+ * @brief Detección de ciclos en el comportamiento de un robot
+ *
+ * Un comportamiento que declara su estado con rmb_declare_state() promete
+ * que cada llamada depende solo de los sensores del robot, del mapa y de
+ * ese estado. Si antes de una llamada todo eso coincide con lo que había
+ * antes de otra anterior, y entre medias no se ha limpiado nada, las
+ * llamadas siguientes repetirán las mismas acciones una y otra vez. El
+ * detector las aplica entonces directamente desde su cinta, de modo que
+ * el resultado es exactamente el de ejecutar el comportamiento.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simula_internal.h"
+
+/// Mayor coste de batería de una acción (cota para no repetir una llamada
+/// en la que la simulación podría detenerse por batería)
+#define CYCLE_MAX_COST COST_MOVE_DIAG
+
+/* ============================================================================
+ * FUNCIONES AUXILIARES PRIVADAS
+ * ============================================================================ */
+
+/**
+ * @brief Hash FNV-1a de un bloque de memoria
+ * @param h Hash acumulado
+ * @param p Bloque
+ * @param len Bytes del bloque
+ * @return Hash actualizado
+ */
+static uint64_t fnv1a(uint64_t h, const void *p, size_t len){
+  const unsigned char *b = p;
+  for(size_t i = 0; i < len; i++){
+    h ^= b[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+/**
+ * @brief Situación actual del robot
+ * @param ctx Contexto de simulación
+ * @param key Estructura a rellenar
+ */
+static void cycle_key(const sim_ctx_t *ctx, cycle_key_t *key){
+  const sensor_t *rob = &ctx->robot.sensor;
+  memset(key, 0, sizeof(*key));
+  key->precise_x = ctx->robot.precise_x;
+  key->precise_y = ctx->robot.precise_y;
+  key->x = rob->x;
+  key->y = rob->y;
+  key->heading = rob->heading;
+  key->bumper = rob->bumper;
+  key->infrared = rob->infrared;
+  key->dirt_cleaned = ctx->stats.dirt_cleaned;
+}
+
+/**
+ * @brief Reserva sitio para una llamada vigilada más
+ * @param c Detector
+ * @return 0 si OK, -1 si no hay memoria
+ */
+static int cycle_grow(sim_cycle_t *c){
+  if(c->n < c->cap) return 0;
+  int cap = c->cap ? c->cap * 2 : 1024;
+  cycle_entry_t *e = realloc(c->entry, cap * sizeof(*e));
+  if(!e) return -1;
+  c->entry = e;
+  if(c->size > 0){
+    unsigned char *s = realloc(c->states, (size_t)cap * c->size);
+    if(!s) return -1;
+    c->states = s;
+  }
+  c->cap = cap;
+  return 0;
+}
+
+/**
+ * @brief Ticks que avanza la llamada j del ciclo
+ * @param c Detector en modo repetición
+ * @param j Llamada
+ * @return Ticks
+ */
+static int cycle_ticks(const sim_cycle_t *c, int j){
+  int end = j + 1 < c->n ? c->entry[j + 1].timer
+                         : c->entry[c->first].timer + c->period;
+  return end - c->entry[j].timer;
+}
+
+/**
+ * @brief Repite una llamada del ciclo
+ * @param ctx Contexto de simulación
+ * @return 1 si la ha repetido, 0 si hay que llamar al comportamiento
+ *
+ * Cerca del final (por tiempo o por batería) una llamada podría quedarse a
+ * medias y el comportamiento tendría la última palabra: entonces se deja
+ * de repetir y se le devuelve el control con el estado de esa llamada.
+ */
+static int cycle_replay(sim_ctx_t *ctx){
+  sim_cycle_t *c = ctx->cycle;
+  int j = c->next;
+  size_t pos = c->entry[j].pos;
+  size_t end = j + 1 < c->n ? c->entry[j + 1].pos : c->tape.len;
+  float alpha = 0;
+
+  if(ctx->timer + cycle_ticks(c, j) > ctx->config.exec_time ||
+     ctx->robot.sensor.battery - CYCLE_MAX_COST * (end - pos) <
+     MIN_BATTERY_THRESHOLD + 1.0f){
+    c->replay = 0;
+    c->off = 1;
+    return 0;
+  }
+  while(pos < end){
+    int action = action_log_next(&c->tape, &pos, &alpha);
+    sim_apply_action(ctx, action, alpha);
+  }
+  c->next = j + 1 < c->n ? j + 1 : c->first;
+  // El estado que tendría el comportamiento al empezar la siguiente llamada
+  if(c->size > 0)
+    memcpy(c->state, c->states + c->entry[c->next].state, c->size);
+  return 1;
+}
+
+/* ============================================================================
+ * API DEL DETECTOR
+ * ============================================================================ */
+
+/**
+ * @brief Declara el estado del comportamiento y activa la detección
+ * @param ctx Contexto de simulación
+ * @param state Variables del comportamiento (NULL si size es 0)
+ * @param size Bytes de state (0 a SIM_CYCLE_STATE_MAX)
+ * @return 0 si OK, -1 si el tamaño no es válido o no hay memoria
+ *
+ * Volver a declarar el mismo estado no hace nada; uno distinto empieza a
+ * vigilar desde cero.
+ */
+int sim_cycle_declare(sim_ctx_t *ctx, void *state, int size){
+  if(size < 0 || size > SIM_CYCLE_STATE_MAX || (size > 0 && !state)){
+    fprintf(stderr, "Error: Declared state must be 0 to %d bytes\n",
+            SIM_CYCLE_STATE_MAX);
+    return -1;
+  }
+  sim_cycle_t *c = ctx->cycle;
+  if(c && c->state == state && c->size == size)
+    return 0;
+  sim_cycle_destroy(ctx);
+  c = calloc(1, sizeof(*c));
+  if(c){
+    c->nslot = 2 * SIM_CYCLE_MAX_CALLS;
+    c->slot = calloc(c->nslot, sizeof(uint32_t));
+  }
+  if(!c || !c->slot){
+    free(c);
+    fprintf(stderr, "Error: Cannot allocate cycle detector\n");
+    return -1;
+  }
+  c->state = state;
+  c->size = size;
+  ctx->cycle = c;
+  return 0;
+}
+
+/**
+ * @brief Olvida las llamadas vigiladas al empezar una ejecución
+ * @param ctx Contexto de simulación
+ *
+ * Mantiene el estado declarado y vuelve a activar la detección.
+ */
+void sim_cycle_reset(sim_ctx_t *ctx){
+  sim_cycle_t *c = ctx->cycle;
+  if(!c) return;
+  if(c->n > 0)
+    memset(c->slot, 0, c->nslot * sizeof(uint32_t));
+  c->n = 0;
+  c->tape.len = 0;
+  c->tape.count = 0;
+  c->tape.failed = 0;
+  c->off = 0;
+  c->replay = 0;
+}
+
+/**
+ * @brief Desactiva la detección hasta la siguiente ejecución
+ * @param ctx Contexto de simulación
+ *
+ * En plena repetición el estado declarado ya es el de la llamada en curso,
+ * así que el comportamiento sigue donde lo habría dejado.
+ */
+void sim_cycle_taint(sim_ctx_t *ctx){
+  if(ctx->cycle){
+    ctx->cycle->off = 1;
+    ctx->cycle->replay = 0;
+  }
+}
+
+/**
+ * @brief Anota una acción de la llamada en curso
+ * @param ctx Contexto de simulación
+ * @param action Código de la acción
+ * @param alpha Ángulo (solo con TURN)
+ *
+ * Las acciones de on_start() y las repetidas desde la cinta no se anotan.
+ */
+void sim_cycle_record(sim_ctx_t *ctx, int action, float alpha){
+  sim_cycle_t *c = ctx->cycle;
+  if(c->off || c->replay || c->n == 0) return;
+  action_log_push(&c->tape, action, alpha);
+  if(c->tape.failed) c->off = 1;
+}
+
+/**
+ * @brief Paso del detector antes de una llamada al comportamiento
+ * @param ctx Contexto de simulación
+ * @return 1 si ha repetido una llamada del ciclo (no hay que llamar al
+ *         comportamiento), 0 si hay que llamarlo
+ *
+ * Con varios robots en el mapa los demás también cambian lo que ve el
+ * robot, así que la detección solo funciona con un robot.
+ */
+int sim_cycle_step(sim_ctx_t *ctx){
+  sim_cycle_t *c = ctx->cycle;
+  if(c->off) return 0;
+  if(c->replay) return cycle_replay(ctx);
+  if(ctx->team || c->n >= SIM_CYCLE_MAX_CALLS){
+    c->off = 1;
+    return 0;
+  }
+
+  cycle_key_t key;
+  cycle_key(ctx, &key);
+  uint64_t h = fnv1a(0xcbf29ce484222325ull, &key, sizeof(key));
+  if(c->size > 0)
+    h = fnv1a(h, c->state, c->size);
+  uint32_t mask = c->nslot - 1;
+  uint32_t s = (uint32_t)(h ^ (h >> 32)) & mask;
+  for(; c->slot[s]; s = (s + 1) & mask){
+    const cycle_entry_t *e = &c->entry[c->slot[s] - 1];
+    if(e->hash != h || memcmp(&e->key, &key, sizeof(key)) != 0 ||
+       (c->size > 0 && memcmp(c->states + e->state, c->state, c->size) != 0))
+      continue;
+    if(ctx->timer == e->timer){
+      // Llamadas que no avanzan: las vigila sim_ctx_exec_beh()
+      c->off = 1;
+      return 0;
+    }
+    c->replay = 1;
+    c->first = c->next = c->slot[s] - 1;
+    c->period = ctx->timer - e->timer;
+    return cycle_replay(ctx);
+  }
+
+  if(cycle_grow(c) != 0){
+    c->off = 1;
+    return 0;
+  }
+  cycle_entry_t *e = &c->entry[c->n];
+  e->hash = h;
+  e->key = key;
+  e->state = (size_t)c->n * c->size;
+  e->pos = c->tape.len;
+  e->timer = ctx->timer;
+  if(c->size > 0)
+    memcpy(c->states + e->state, c->state, c->size);
+  c->slot[s] = ++c->n;
+  return 0;
+}
+
+/**
+ * @brief Libera el detector de un contexto
+ * @param ctx Contexto de simulación
+ */
+void sim_cycle_destroy(sim_ctx_t *ctx){
+  sim_cycle_t *c = ctx->cycle;
+  if(!c) return;
+  action_log_free(&c->tape);
+  free(c->entry);
+  free(c->states);
+  free(c->slot);
+  free(c);
+  ctx->cycle = NULL;
+}
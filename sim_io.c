@@ -1,17 +1,28 @@
 /**
  * @file sim_io.c
- * @brief Entrada/salida de archivos CSV
+ * @brief Entrada/salida de archivos CSV y trazas binarias
  *
  * Gestiona la escritura de logs y estadísticas en archivos CSV
- * en el directorio de trabajo actual.
+ * en el directorio de trabajo actual, la traza binaria log.bin, el
+ * registro de acciones actions.bin, las latencias de latency.csv y los
+ * mapas de calor de heatmap.bin.
  */
 
 #include "simula_internal.h"
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define STATS_FILE "stats.csv"    ///< Nombre del archivo de estadísticas
 #define LOG_FILE "log.csv"        ///< Nombre del archivo de log
+#define TRACE_FILE "log.bin"      ///< Nombre del archivo de traza binaria
+#define ACTIONS_FILE "actions.bin" ///< Nombre del registro de acciones
+#define LATENCY_FILE "latency.csv" ///< Nombre del archivo de latencias
+#define HEATMAP_FILE "heatmap.bin" ///< Nombre del archivo de mapas de calor
 #define RAD_TO_DEG (180.0 / M_PI) ///< Factor de conversión radianes a grados
+#define TRACE_RECORD_SIZE 20      ///< Bytes de un registro absoluto
+#define TRACE_DELTA_RECORD_SIZE 12 ///< Bytes de un registro TRACE_DELTA_XY
 
 /**
  * @brief Guarda el historial de posiciones en log.csv
@@ -33,11 +44,702 @@ void save_log(const sensor_t *hist, int len) {
     return;
   }
 
+  write_log_csv(file, hist, len);
+  fclose(file);
+}
+
+/**
+ * @brief Escribe un historial en formato CSV (el de log.csv)
+ * @param file Archivo de salida
+ * @param hist Array con el historial de estados del robot
+ * @param len Número de elementos en el historial
+ */
+void write_log_csv(FILE *file, const sensor_t *hist, int len) {
   fprintf(file, "y, x, head, bump, ifr, batt\n");
   for (int i = 0; i < len; i++)
     fprintf(file, "%d, %d, %.1f, %d, %d, %.1f\n", hist[i].y, hist[i].x,
             hist[i].heading * RAD_TO_DEG, hist[i].bumper, hist[i].infrared,
             hist[i].battery);
+}
+
+/* ============================================================================
+ * TRAZA BINARIA
+ * ============================================================================
+ */
+
+/**
+ * @brief Escribe un entero de 16 bits en little-endian
+ * @param p Destino
+ * @param v Valor
+ */
+static void put_u16(unsigned char *p, uint16_t v) {
+  p[0] = (unsigned char)v;
+  p[1] = (unsigned char)(v >> 8);
+}
+
+/**
+ * @brief Escribe un entero de 32 bits en little-endian
+ * @param p Destino
+ * @param v Valor
+ */
+static void put_u32(unsigned char *p, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    p[i] = (unsigned char)(v >> (8 * i));
+}
+
+/**
+ * @brief Escribe un float de 32 bits en little-endian
+ * @param p Destino
+ * @param f Valor
+ */
+static void put_f32(unsigned char *p, float f) {
+  uint32_t v;
+  memcpy(&v, &f, sizeof(v));
+  put_u32(p, v);
+}
+
+/**
+ * @brief Lee un entero de 16 bits en little-endian
+ * @param p Origen
+ * @return Valor
+ */
+static uint16_t get_u16(const unsigned char *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Lee un entero de 32 bits en little-endian
+ * @param p Origen
+ * @return Valor
+ */
+static uint32_t get_u32(const unsigned char *p) {
+  uint32_t v = 0;
+  for (int i = 3; i >= 0; i--)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+/**
+ * @brief Lee un float de 32 bits en little-endian
+ * @param p Origen
+ * @return Valor
+ */
+static float get_f32(const unsigned char *p) {
+  uint32_t v = get_u32(p);
+  float f;
+  memcpy(&f, &v, sizeof(f));
+  return f;
+}
+
+/**
+ * @brief Compone la cabecera de una traza
+ * @param hdr Buffer de TRACE_HEADER_SIZE bytes
+ * @param map_hash Hash del mapa
+ * @param flags Flags TRACE_*
+ * @param count Número de registros
+ * @param x0 Columna de referencia
+ * @param y0 Fila de referencia
+ */
+static void trace_header(unsigned char *hdr, uint64_t map_hash, int flags,
+                         uint32_t count, int x0, int y0) {
+  memset(hdr, 0, TRACE_HEADER_SIZE);
+  memcpy(hdr, TRACE_MAGIC, 8);
+  put_u16(hdr + 8, TRACE_VERSION);
+  put_u16(hdr + 10, (uint16_t)flags);
+  put_u32(hdr + 12, (flags & TRACE_DELTA_XY) ? TRACE_DELTA_RECORD_SIZE
+                                             : TRACE_RECORD_SIZE);
+  put_u32(hdr + 16, (uint32_t)map_hash);
+  put_u32(hdr + 20, (uint32_t)(map_hash >> 32));
+  put_u32(hdr + 24, count);
+  put_u32(hdr + 28, (uint32_t)x0);
+  put_u32(hdr + 32, (uint32_t)y0);
+}
+
+/**
+ * @brief Vuelca al archivo los registros acumulados en el buffer
+ * @param w Escritor
+ */
+static void trace_flush(trace_writer_t *w) {
+  if (w->used && fwrite(w->buf, 1, w->used, w->file) != w->used)
+    w->error = 1;
+  w->used = 0;
+}
+
+/**
+ * @brief Abre una traza binaria para escritura
+ * @param w Escritor a inicializar
+ * @param path Ruta del archivo
+ * @param map_hash Hash del mapa (sim_world_hash)
+ * @param flags Flags TRACE_*
+ * @param x0 Columna de referencia para TRACE_DELTA_XY
+ * @param y0 Fila de referencia para TRACE_DELTA_XY
+ * @return 0 si OK, -1 si error
+ *
+ * La cabecera se escribe con 0 registros y se completa en trace_close().
+ */
+int trace_open(trace_writer_t *w, const char *path, uint64_t map_hash,
+               int flags, int x0, int y0) {
+  unsigned char hdr[TRACE_HEADER_SIZE];
+  w->file = fopen(path, "wb");
+  if (!w->file) {
+    fprintf(stderr, "Error: Cannot open %s for writing\n", path);
+    return -1;
+  }
+  w->used = 0;
+  w->flags = flags;
+  w->count = 0;
+  w->last_x = x0;
+  w->last_y = y0;
+  w->error = 0;
+  trace_header(hdr, map_hash, flags, 0, x0, y0);
+  if (fwrite(hdr, 1, sizeof(hdr), w->file) != sizeof(hdr))
+    w->error = 1;
+  return 0;
+}
+
+/**
+ * @brief Añade un registro a la traza
+ * @param w Escritor abierto
+ * @param s Estado del robot a registrar
+ */
+void trace_write(trace_writer_t *w, const sensor_t *s) {
+  if (w->used + TRACE_RECORD_SIZE > sizeof(w->buf))
+    trace_flush(w);
+  unsigned char *p = w->buf + w->used;
+  if (w->flags & TRACE_DELTA_XY) {
+    int dx = s->x - w->last_x;
+    int dy = s->y - w->last_y;
+    if (dx < -128 || dx > 127 || dy < -128 || dy > 127)
+      w->error = 1;
+    p[0] = (unsigned char)(signed char)dx;
+    p[1] = (unsigned char)(signed char)dy;
+    p[2] = (unsigned char)s->bumper;
+    p[3] = (unsigned char)s->infrared;
+    put_f32(p + 4, s->heading);
+    put_f32(p + 8, s->battery);
+    w->used += TRACE_DELTA_RECORD_SIZE;
+  } else {
+    put_u32(p, (uint32_t)s->x);
+    put_u32(p + 4, (uint32_t)s->y);
+    put_f32(p + 8, s->heading);
+    put_f32(p + 12, s->battery);
+    p[16] = (unsigned char)s->bumper;
+    p[17] = (unsigned char)s->infrared;
+    p[18] = p[19] = 0;
+    w->used += TRACE_RECORD_SIZE;
+  }
+  w->last_x = s->x;
+  w->last_y = s->y;
+  w->count++;
+}
+
+/**
+ * @brief Vuelca el buffer, escribe el número de registros y cierra
+ * @param w Escritor abierto
+ * @return 0 si OK, -1 si hubo algún error
+ */
+int trace_close(trace_writer_t *w) {
+  unsigned char count[4];
+  trace_flush(w);
+  put_u32(count, w->count);
+  if (fseek(w->file, 24, SEEK_SET) != 0 ||
+      fwrite(count, 1, sizeof(count), w->file) != sizeof(count))
+    w->error = 1;
+  if (fclose(w->file) != 0)
+    w->error = 1;
+  w->file = NULL;
+  return w->error ? -1 : 0;
+}
+
+/**
+ * @brief Lee una traza binaria completa
+ * @param path Ruta del archivo
+ * @param hist Puntero donde guardar el historial (liberar con free)
+ * @param len Puntero donde guardar el número de registros
+ * @param map_hash Puntero donde guardar el hash del mapa (puede ser NULL)
+ * @return 0 si OK, -1 si error
+ */
+int trace_load(const char *path, sensor_t **hist, int *len,
+               uint64_t *map_hash) {
+  unsigned char hdr[TRACE_HEADER_SIZE];
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for reading\n", path);
+    return -1;
+  }
+  if (fread(hdr, 1, sizeof(hdr), file) != sizeof(hdr) ||
+      memcmp(hdr, TRACE_MAGIC, 8) != 0 || get_u16(hdr + 8) != TRACE_VERSION) {
+    fprintf(stderr, "Error: %s is not a roomba trace\n", path);
+    fclose(file);
+    return -1;
+  }
+  int flags = get_u16(hdr + 10);
+  size_t rec = get_u32(hdr + 12);
+  uint32_t count = get_u32(hdr + 24);
+  int x = (int)get_u32(hdr + 28);
+  int y = (int)get_u32(hdr + 32);
+  size_t expected = (flags & TRACE_DELTA_XY) ? TRACE_DELTA_RECORD_SIZE
+                                             : TRACE_RECORD_SIZE;
+  if (rec != expected || count > (uint32_t)INT_MAX) {
+    fprintf(stderr, "Error: Unsupported trace layout in %s\n", path);
+    fclose(file);
+    return -1;
+  }
+
+  unsigned char *raw = malloc(count * rec + 1);
+  sensor_t *h = calloc(count ? count : 1, sizeof(sensor_t));
+  if (!raw || !h || fread(raw, rec, count, file) != count) {
+    fprintf(stderr, "Error: Truncated trace %s\n", path);
+    free(raw);
+    free(h);
+    fclose(file);
+    return -1;
+  }
+  fclose(file);
+
+  for (uint32_t i = 0; i < count; i++) {
+    const unsigned char *p = raw + i * rec;
+    if (flags & TRACE_DELTA_XY) {
+      x += (signed char)p[0];
+      y += (signed char)p[1];
+      h[i].bumper = p[2];
+      h[i].infrared = p[3];
+      h[i].heading = get_f32(p + 4);
+      h[i].battery = get_f32(p + 8);
+    } else {
+      x = (int)get_u32(p);
+      y = (int)get_u32(p + 4);
+      h[i].heading = get_f32(p + 8);
+      h[i].battery = get_f32(p + 12);
+      h[i].bumper = p[16];
+      h[i].infrared = p[17];
+    }
+    h[i].x = x;
+    h[i].y = y;
+  }
+  free(raw);
+  if (map_hash)
+    *map_hash = (uint64_t)get_u32(hdr + 16) | (uint64_t)get_u32(hdr + 20) << 32;
+  *hist = h;
+  *len = (int)count;
+  return 0;
+}
+
+/**
+ * @brief Guarda el historial de posiciones en la traza binaria log.bin
+ * @param hist Array con el historial de estados del robot
+ * @param len Número de elementos en el historial
+ * @param map_hash Hash del mapa simulado
+ *
+ * Usa TRACE_DELTA_XY siempre que todos los pasos quepan en un byte, lo que
+ * ocurre siempre con el movimiento normal del robot (una celda por tick).
+ */
+void save_trace(const sensor_t *hist, int len, uint64_t map_hash) {
+  trace_writer_t *w;
+  if (!hist || len < 0) {
+    fprintf(stderr, "Error: Invalid parameters for save_trace\n");
+    return;
+  }
+  int flags = TRACE_DELTA_XY;
+  int x0 = len > 0 ? hist[0].x : 0;
+  int y0 = len > 0 ? hist[0].y : 0;
+  for (int i = 1; i < len && flags; i++) {
+    int dx = hist[i].x - hist[i - 1].x;
+    int dy = hist[i].y - hist[i - 1].y;
+    if (dx < -128 || dx > 127 || dy < -128 || dy > 127)
+      flags = 0;
+  }
+  // El buffer del escritor es demasiado grande para la pila de un atexit
+  w = malloc(sizeof(*w));
+  if (!w || trace_open(w, TRACE_FILE, map_hash, flags, x0, y0) != 0) {
+    free(w);
+    return;
+  }
+  for (int i = 0; i < len; i++)
+    trace_write(w, &hist[i]);
+  if (trace_close(w) != 0)
+    fprintf(stderr, "Error: Cannot write %s\n", TRACE_FILE);
+  free(w);
+}
+
+/* ============================================================================
+ * REGISTRO DE ACCIONES
+ * ============================================================================ */
+
+/**
+ * @brief Añade una acción a un registro
+ * @param log Registro activo
+ * @param action Código (FWD, TURN, CLEAN, LOAD o ACTION_AWAKE)
+ * @param alpha Ángulo (solo se guarda con TURN)
+ *
+ * El buffer crece al doble cuando se llena. Si no hay memoria el registro
+ * se marca como fallido y deja de crecer: no se puede reproducir.
+ */
+void action_log_push(action_log_t *log, int action, float alpha) {
+  size_t need = action == TURN ? 5 : 1;
+  if (log->failed)
+    return;
+  if (log->len + need > log->cap) {
+    size_t cap = log->cap ? log->cap * 2 : 4096;
+    unsigned char *buf = realloc(log->buf, cap);
+    if (!buf) {
+      log->failed = 1;
+      return;
+    }
+    log->buf = buf;
+    log->cap = cap;
+  }
+  log->buf[log->len] = (unsigned char)action;
+  if (action == TURN)
+    put_f32(log->buf + log->len + 1, alpha);
+  log->len += need;
+  log->count++;
+}
+
+/**
+ * @brief Lee la siguiente acción de un registro
+ * @param log Registro
+ * @param pos Posición en log->buf (entrada/salida; empieza en 0)
+ * @param alpha Ángulo de la acción si es TURN (salida)
+ * @return Código de la acción, o -1 al final o si el registro está dañado
+ */
+int action_log_next(const action_log_t *log, size_t *pos, float *alpha) {
+  if (*pos >= log->len)
+    return -1;
+  int action = log->buf[*pos];
+  if (action == TURN) {
+    if (*pos + 5 > log->len)
+      return -1;
+    *alpha = get_f32(log->buf + *pos + 1);
+    *pos += 5;
+    return action;
+  }
+  *pos += 1;
+  return action;
+}
+
+/**
+ * @brief Libera las acciones de un registro y lo desactiva
+ * @param log Registro
+ */
+void action_log_free(action_log_t *log) {
+  free(log->buf);
+  *log = (action_log_t){0};
+}
+
+/**
+ * @brief Escribe un registro de acciones
+ * @param log Registro con flags, exec_time, map_hash y seed rellenos
+ * @param path Ruta del archivo
+ * @return 0 si OK, -1 si error
+ */
+int action_log_write(const action_log_t *log, const char *path) {
+  unsigned char hdr[ACTIONS_HEADER_SIZE] = {0};
+  if (log->failed || log->len > UINT32_MAX) {
+    fprintf(stderr, "Error: Action log is incomplete, not saving %s\n", path);
+    return -1;
+  }
+  memcpy(hdr, ACTIONS_MAGIC, 8);
+  put_u16(hdr + 8, ACTIONS_VERSION);
+  put_u16(hdr + 10, (uint16_t)log->flags);
+  put_u32(hdr + 12, (uint32_t)log->exec_time);
+  put_u32(hdr + 16, (uint32_t)log->map_hash);
+  put_u32(hdr + 20, (uint32_t)(log->map_hash >> 32));
+  put_u32(hdr + 24, log->count);
+  put_u32(hdr + 28, (uint32_t)log->len);
+  put_u32(hdr + 32, (uint32_t)log->seed);
+  put_u32(hdr + 36, (uint32_t)(log->seed >> 32));
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for writing\n", path);
+    return -1;
+  }
+  int rc = fwrite(hdr, 1, sizeof(hdr), file) == sizeof(hdr) &&
+                   fwrite(log->buf, 1, log->len, file) == log->len
+               ? 0
+               : -1;
+  if (fclose(file) != 0)
+    rc = -1;
+  if (rc != 0)
+    fprintf(stderr, "Error: Cannot write %s\n", path);
+  return rc;
+}
+
+/**
+ * @brief Lee un registro de acciones completo
+ * @param path Ruta del archivo
+ * @param log Registro a rellenar (liberar con action_log_free)
+ * @return 0 si OK, -1 si error
+ */
+int action_log_load(const char *path, action_log_t *log) {
+  unsigned char hdr[ACTIONS_HEADER_SIZE];
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for reading\n", path);
+    return -1;
+  }
+  if (fread(hdr, 1, sizeof(hdr), file) != sizeof(hdr) ||
+      memcmp(hdr, ACTIONS_MAGIC, 8) != 0 ||
+      get_u16(hdr + 8) != ACTIONS_VERSION) {
+    fprintf(stderr, "Error: %s is not a roomba action log\n", path);
+    fclose(file);
+    return -1;
+  }
+  size_t len = get_u32(hdr + 28);
+  unsigned char *buf = malloc(len + 1);
+  if (!buf || fread(buf, 1, len, file) != len) {
+    fprintf(stderr, "Error: Truncated action log %s\n", path);
+    free(buf);
+    fclose(file);
+    return -1;
+  }
+  fclose(file);
+
+  *log = (action_log_t){0};
+  log->buf = buf;
+  log->len = log->cap = len;
+  log->flags = get_u16(hdr + 10);
+  log->exec_time = (int)get_u32(hdr + 12);
+  log->map_hash =
+      (uint64_t)get_u32(hdr + 16) | (uint64_t)get_u32(hdr + 20) << 32;
+  log->count = get_u32(hdr + 24);
+  log->seed = (uint64_t)get_u32(hdr + 32) | (uint64_t)get_u32(hdr + 36) << 32;
+  return 0;
+}
+
+/**
+ * @brief Guarda un registro de acciones en actions.bin
+ * @param log Registro con flags, exec_time, map_hash y seed rellenos
+ */
+void save_actions(const action_log_t *log) {
+  action_log_write(log, ACTIONS_FILE);
+}
+
+/**
+ * @brief Escribe un entero como varint LEB128
+ * @param p Destino (hasta 5 bytes)
+ * @param v Valor
+ * @return Bytes escritos
+ */
+static size_t put_varint(unsigned char *p, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (unsigned char)v;
+  return n;
+}
+
+/**
+ * @brief Lee un varint LEB128
+ * @param p Bytes
+ * @param len Bytes disponibles
+ * @param pos Posición (entrada/salida)
+ * @param v Valor leído (salida)
+ * @return 0 si OK, -1 si el varint está cortado o no cabe en 32 bits
+ */
+static int get_varint(const unsigned char *p, size_t len, size_t *pos,
+                      uint32_t *v) {
+  uint32_t r = 0;
+  for (int shift = 0; shift < 35 && *pos < len; shift += 7) {
+    unsigned char b = p[(*pos)++];
+    r |= (uint32_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      *v = r;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief Añade un registro a un archivo de mapas de calor
+ * @param path Ruta del archivo
+ * @param h Registro a escribir
+ * @return 0 si OK, -1 si error
+ */
+int heatmap_append(const char *path, const heatmap_t *h) {
+  unsigned char hdr[HEATMAP_HEADER_SIZE] = {0};
+  unsigned char buf[4096];
+  size_t cells = (size_t)h->nrow * h->ncol;
+  size_t name_len = strlen(h->name);
+
+  // Primera pasada: bytes de las celdas, que van en la cabecera
+  size_t len = 0;
+  uint32_t skip = 0;
+  for (size_t i = 0; i < cells; i++) {
+    if (h->visits[i] == 0) {
+      skip++;
+      continue;
+    }
+    len += put_varint(buf, skip) + put_varint(buf, h->visits[i]);
+    skip = 0;
+  }
+
+  memcpy(hdr, HEATMAP_MAGIC, 8);
+  put_u16(hdr + 8, HEATMAP_VERSION);
+  put_u16(hdr + 10, (uint16_t)name_len);
+  put_u32(hdr + 12, (uint32_t)h->nrow);
+  put_u32(hdr + 16, (uint32_t)h->ncol);
+  put_u32(hdr + 20, (uint32_t)h->map_hash);
+  put_u32(hdr + 24, (uint32_t)(h->map_hash >> 32));
+  put_u32(hdr + 28, h->ticks);
+  put_u32(hdr + 32, h->cell_visited);
+  put_u32(hdr + 36, (uint32_t)len);
+
+  FILE *file = fopen(path, "ab");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for appending\n", path);
+    return -1;
+  }
+  int rc = fwrite(hdr, 1, sizeof(hdr), file) == sizeof(hdr) &&
+                   fwrite(h->name, 1, name_len, file) == name_len
+               ? 0
+               : -1;
+  size_t n = 0;
+  skip = 0;
+  for (size_t i = 0; rc == 0 && i < cells; i++) {
+    if (h->visits[i] == 0) {
+      skip++;
+      continue;
+    }
+    n += put_varint(buf + n, skip);
+    n += put_varint(buf + n, h->visits[i]);
+    skip = 0;
+    if (n > sizeof(buf) - 10) {
+      rc = fwrite(buf, 1, n, file) == n ? 0 : -1;
+      n = 0;
+    }
+  }
+  if (rc == 0 && fwrite(buf, 1, n, file) != n)
+    rc = -1;
+  if (fclose(file) != 0)
+    rc = -1;
+  if (rc != 0)
+    fprintf(stderr, "Error: Cannot write %s\n", path);
+  return rc;
+}
+
+/**
+ * @brief Lee el siguiente registro de un archivo de mapas de calor
+ * @param file Archivo abierto en modo binario
+ * @param h Registro a rellenar; h->visits se reserva o amplía según el
+ *          tamaño del mapa (empezar con {0} y liberar con free())
+ * @return 1 si ha leído un registro, 0 al final del archivo, -1 si error
+ */
+int heatmap_read(FILE *file, heatmap_t *h) {
+  unsigned char hdr[HEATMAP_HEADER_SIZE];
+  size_t got = fread(hdr, 1, sizeof(hdr), file);
+  if (got == 0)
+    return 0;
+  if (got != sizeof(hdr) || memcmp(hdr, HEATMAP_MAGIC, 8) != 0 ||
+      get_u16(hdr + 8) != HEATMAP_VERSION)
+    return -1;
+  size_t name_len = get_u16(hdr + 10);
+  uint32_t nrow = get_u32(hdr + 12), ncol = get_u32(hdr + 16);
+  size_t len = get_u32(hdr + 36);
+  if (name_len >= sizeof(h->name) || nrow == 0 || ncol == 0 ||
+      (uint64_t)nrow * ncol > HEATMAP_MAX_CELLS)
+    return -1;
+  size_t cells = (size_t)nrow * ncol;
+  if (len > cells * 10)
+    return -1;
+  if (cells != (size_t)h->nrow * h->ncol || !h->visits) {
+    uint32_t *v = realloc(h->visits, cells * sizeof(uint32_t));
+    if (!v)
+      return -1;
+    h->visits = v;
+  }
+  h->nrow = (int)nrow;
+  h->ncol = (int)ncol;
+  h->map_hash =
+      (uint64_t)get_u32(hdr + 20) | (uint64_t)get_u32(hdr + 24) << 32;
+  h->ticks = get_u32(hdr + 28);
+  h->cell_visited = get_u32(hdr + 32);
+  if (fread(h->name, 1, name_len, file) != name_len)
+    return -1;
+  h->name[name_len] = '\0';
+
+  unsigned char *body = malloc(len + 1);
+  if (!body || fread(body, 1, len, file) != len) {
+    free(body);
+    return -1;
+  }
+  memset(h->visits, 0, cells * sizeof(uint32_t));
+  size_t pos = 0, cell = 0;
+  uint32_t skip, count;
+  while (pos < len) {
+    if (get_varint(body, len, &pos, &skip) != 0 ||
+        get_varint(body, len, &pos, &count) != 0 || skip >= cells - cell) {
+      free(body);
+      return -1;
+    }
+    cell += skip;
+    h->visits[cell++] = count;
+  }
+  free(body);
+  return 1;
+}
+
+/**
+ * @brief Añade el mapa de calor de la ejecución a heatmap.bin
+ * @param h Registro a escribir
+ *
+ * Como latency.csv, cada ejecución (también cada ronda del runner) añade
+ * un registro.
+ */
+void save_heatmap(const heatmap_t *h) {
+  heatmap_append(HEATMAP_FILE, h);
+}
+
+/**
+ * @brief Escribe una fila de estadísticas en el formato de stats.csv
+ * @param file Archivo de salida
+ * @param st Estadísticas
+ */
+static void write_stats_row(FILE *file, const struct _stat *st) {
+  fprintf(file, "%d, %d, %d, %d, %.1f, %.1f, %d, %d, %d, %d, %d, %d\n",
+          st->cell_total, st->cell_visited, st->dirt_total, st->dirt_cleaned,
+          st->bat_total, st->bat_mean, st->moves[FWD], st->moves[TURN],
+          st->moves[BUMP], st->moves[CLEAN], st->moves[LOAD], st->end);
+}
+
+/**
+ * @brief Guarda la latencia del comportamiento en latency.csv
+ * @param prof Medidas de la ejecución
+ *
+ * Columnas: llamadas, llamadas sin acción, media, p50, p99 y máximo en
+ * ns, y el histograma como pares "b:n" separados por ';' (n llamadas de
+ * entre 2^b y 2^(b+1) - 1 ns). Cada ejecución añade una fila, también
+ * las rondas del runner; la cabecera solo se escribe con el archivo vacío.
+ */
+void save_latency(const beh_prof_t *prof) {
+  FILE *file = fopen(LATENCY_FILE, "a");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for appending\n", LATENCY_FILE);
+    return;
+  }
+  fseek(file, 0, SEEK_END);
+  if (ftell(file) == 0)
+    fprintf(file,
+            "calls, idle_calls, mean_ns, p50_ns, p99_ns, max_ns, hist\n");
+  fprintf(file, "%llu, %llu, %llu, %llu, %llu, %llu, ",
+          (unsigned long long)prof->calls,
+          (unsigned long long)prof->idle_calls,
+          (unsigned long long)(prof->calls ? prof->total_ns / prof->calls : 0),
+          (unsigned long long)prof_percentile(prof, 50),
+          (unsigned long long)prof_percentile(prof, 99),
+          (unsigned long long)prof->max_ns);
+  const char *sep = "";
+  for (int b = 0; b < BEH_PROF_BUCKETS; b++) {
+    if (prof->bucket[b]) {
+      fprintf(file, "%s%d:%u", sep, b, (unsigned)prof->bucket[b]);
+      sep = ";";
+    }
+  }
+  fprintf(file, "\n");
   fclose(file);
 }
 
@@ -47,7 +749,7 @@ void save_log(const sensor_t *hist, int len) {
  *
  * Genera un archivo CSV con las métricas de la simulación:
  * celdas totales/visitadas, suciedad total/limpiada, batería total/media,
- * y contadores de movimientos por tipo.
+ * contadores de movimientos por tipo y motivo del final (enum sim_end).
  *
  * En modo competición, agrega líneas al archivo existente.
  * En modo normal, crea/sobrescribe el archivo con header.
@@ -67,10 +769,7 @@ void save_stats(const struct _stat *st) {
   }
 
   // Solo datos, sin header
-  fprintf(file, "%d, %d, %d, %d, %.1f, %.1f, %d, %d, %d, %d, %d\n",
-          st->cell_total, st->cell_visited, st->dirt_total, st->dirt_cleaned,
-          st->bat_total, st->bat_mean, st->moves[FWD], st->moves[TURN],
-          st->moves[BUMP], st->moves[CLEAN], st->moves[LOAD]);
+  write_stats_row(file, st);
 #else
   // Modo normal: crear/sobrescribir con header
   FILE *file = fopen(STATS_FILE, "w");
@@ -80,11 +779,55 @@ void save_stats(const struct _stat *st) {
   }
 
   fprintf(file, "cell_total, cell_visited, dirt_total, dirt_cleaned, "
-                "bat_total, bat_mean, forward, turn, bumps, clean, load\n");
-  fprintf(file, "%d, %d, %d, %d, %.1f, %.1f, %d, %d, %d, %d, %d\n",
-          st->cell_total, st->cell_visited, st->dirt_total, st->dirt_cleaned,
-          st->bat_total, st->bat_mean, st->moves[FWD], st->moves[TURN],
-          st->moves[BUMP], st->moves[CLEAN], st->moves[LOAD]);
+                "bat_total, bat_mean, forward, turn, bumps, clean, load, "
+                "end\n");
+  write_stats_row(file, st);
+#endif
+
+  fclose(file);
+}
+
+/**
+ * @brief Guarda las estadísticas de varios robots en stats.csv
+ * @param robots Estadísticas de cada robot
+ * @param n Número de robots
+ * @param fleet Estadísticas del conjunto
+ *
+ * Como save_stats(), y con la misma condición, añade una sola línea por
+ * ejecución (la del conjunto): el runner usa la biblioteca compilada sin
+ * -DCOMPETITION_MODE y lee stats.csv como el de un solo robot.
+ */
+void save_team_stats(const struct _stat *robots, int n,
+                     const struct _stat *fleet) {
+  if (!robots || !fleet) {
+    fprintf(stderr, "Error: Invalid parameters for save_team_stats\n");
+    return;
+  }
+
+#ifdef COMPETITION_MODE
+  (void)n;
+  FILE *file = fopen(STATS_FILE, "a");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for appending\n", STATS_FILE);
+    return;
+  }
+  write_stats_row(file, fleet);
+#else
+  FILE *file = fopen(STATS_FILE, "w");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for writing\n", STATS_FILE);
+    return;
+  }
+
+  fprintf(file, "robot, cell_total, cell_visited, dirt_total, dirt_cleaned, "
+                "bat_total, bat_mean, forward, turn, bumps, clean, load, "
+                "end\n");
+  for (int k = 0; k < n; k++) {
+    fprintf(file, "%d, ", k);
+    write_stats_row(file, &robots[k]);
+  }
+  fprintf(file, "fleet, ");
+  write_stats_row(file, fleet);
 #endif
 
   fclose(file);
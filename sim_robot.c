@@ -12,107 +12,212 @@
 #include <math.h>
 #include "simula_internal.h"
 
-#define LOAD_BATTERY_AMOUNT 10.0f     ///< Cantidad de batería por recarga
 #define FLOAT_EPSILON 0.0001f         ///< Tolerancia para comparación de floats
+#define STEP_LUT_MAX_ULPS 64          ///< Deriva máxima (ulps) cubierta por entrada
 
 /* ============================================================================
  * FUNCIONES AUXILIARES PRIVADAS
  * ============================================================================ */
 
 /**
- * @brief Guarda el estado actual del robot en una estructura sensor_t
- * @param state Puntero donde guardar el estado
+ * @brief Registra un tick en el historial
+ * @param ctx Contexto de simulación
+ * @param action Tipo de acción realizada
  */
-static void save_state(sensor_t *state){
-  state->x = rob->x;
-  state->y = rob->y;
-  state->heading = rob->heading;
-  state->bumper = rob->bumper;
-  state->infrared = rob->infrared;
-  state->battery = rob->battery;
+static void tick(sim_ctx_t *ctx, int action){
+  sim_log_tick(ctx, action);
 }
 
 /**
- * @brief Registra un tick en el historial
- * @param action Tipo de acción realizada
+ * @brief Cuenta una acción y la anota en el registro de acciones, si está activo
+ * @param ctx Contexto de simulación
+ * @param action Código de la acción (FWD, TURN, CLEAN, LOAD, ACTION_AWAKE)
+ * @param alpha Ángulo de giro (solo con TURN)
+ *
+ * La cuenta permite a sim_ctx_exec_beh() saber si una llamada al
+ * comportamiento no hizo nada. El detector de ciclos guarda también las
+ * acciones de cada llamada para poder repetirlas.
  */
-static void tick(int action){
-  sim_log_tick(action);
+static void record(sim_ctx_t *ctx, int action, float alpha){
+  ctx->prof.actions++;
+  if(ctx->actions.active)
+    action_log_push(&ctx->actions, action, alpha);
+  if(ctx->cycle)
+    sim_cycle_record(ctx, action, alpha);
 }
 
 /**
  * @brief Reduce la batería y actualiza estadísticas
+ * @param ctx Contexto de simulación
  * @param amount Cantidad de batería a consumir
  */
-static void apply_battery(float amount){
-  rob->battery -= amount;
-  stats_battery_consume(amount);
+static void apply_battery(sim_ctx_t *ctx, float amount){
+  ctx->robot.sensor.battery -= amount;
+  stats_battery_consume(ctx, amount);
 }
 
 /**
  * @brief Actualiza el sensor infrarrojo según la celda actual
+ * @param ctx Contexto de simulación
  */
-static void update_ifr_at_cell(){
-  rob->infrared = sim_world_cell_dirt(&map, rob->y, rob->x);
+static void update_ifr_at_cell(sim_ctx_t *ctx){
+  sensor_t *rob = &ctx->robot.sensor;
+  rob->infrared = sim_world_cell_dirt(&ctx->map, rob->y, rob->x);
 }
 
 /**
- * @brief Calcula los vectores de movimiento según la orientación
+ * @brief Verifica si un movimiento es diagonal
+ * @param dy Desplazamiento vertical
+ * @param dx Desplazamiento horizontal
+ * @return 1 si es diagonal, 0 si no
+ */
+static int is_diagonal_move(float dy, float dx){
+  return fabsf(dy * dx) >= FLOAT_EPSILON;
+}
+
+/* ============================================================================
+ * TABLA DE PASOS POR ORIENTACIÓN
+ * ============================================================================ */
+
+static step_lut_t step_lut[STEP_LUT_SIZE];
+
+/**
+ * @brief Calcula el desplazamiento exacto (trigonometría) de una orientación
  * @param heading Orientación en radianes
- * @param rx Puntero para almacenar nueva posición x entera
- * @param ry Puntero para almacenar nueva posición y entera
  * @param dx Puntero para almacenar desplazamiento x continuo
  * @param dy Puntero para almacenar desplazamiento y continuo
  */
-static void step_vectors(float heading, int *rx, int *ry, float *dx, float *dy){
+static void step_exact(float heading, float *dx, float *dy){
   *dy = rounda(sin(heading));
   *dx = rounda(cos(heading));
-  *rx = (int)(r.precise_x + *dx);
-  *ry = (int)(r.precise_y + *dy);
 }
 
 /**
- * @brief Gestiona una colisión contra un obstáculo
- * 
- * Activa el bumper, registra estadísticas y consume batería.
+ * @brief Comprueba si una orientación produce exactamente un paso dado
+ * @param heading Orientación en radianes
+ * @param e Entrada de la tabla
+ * @return 1 si dx y dy coinciden bit a bit, 0 si no
  */
-static void handle_collision(){
-  rob->bumper = 1;
-  stats_bump();
-  tick(-1);
-  apply_battery(COST_BUMP);
+static int step_matches(float heading, const step_lut_t *e){
+  float dx, dy;
+  step_exact(heading, &dx, &dy);
+  return memcmp(&dx, &e->dx, sizeof(dx)) == 0 &&
+         memcmp(&dy, &e->dy, sizeof(dy)) == 0;
 }
 
 /**
- * @brief Verifica si un movimiento es diagonal
- * @param dy Desplazamiento vertical
- * @param dx Desplazamiento horizontal
- * @return 1 si es diagonal, 0 si no
+ * @brief Rellena la tabla de pasos al cargar el simulador
+ *
+ * Se ejecuta antes de main() (o al hacer dlopen en modo batch), así que la
+ * tabla es de solo lectura durante la simulación y puede compartirse entre
+ * hilos.
  */
-static int is_diagonal_move(float dy, float dx){
-  return fabsf(dy * dx) >= FLOAT_EPSILON;
+__attribute__((constructor))
+static void step_lut_init(void){
+  for(int k = 0; k < STEP_LUT_SIZE; k++){
+    step_lut_t *e = &step_lut[k];
+    float h = (float)(k * M_PI_8);
+    step_exact(h, &e->dx, &e->dy);
+    e->diagonal = is_diagonal_move(e->dy, e->dx);
+    e->lo = e->hi = h;
+    for(int i = 0; i < STEP_LUT_MAX_ULPS; i++){
+      float next = nextafterf(e->lo, -INFINITY);
+      if(!step_matches(next, e)) break;
+      e->lo = next;
+    }
+    for(int i = 0; i < STEP_LUT_MAX_ULPS; i++){
+      float next = nextafterf(e->hi, INFINITY);
+      if(!step_matches(next, e)) break;
+      e->hi = next;
+    }
+  }
+}
+
+/**
+ * @brief Tabla de pasos por orientación
+ * @return Puntero a las STEP_LUT_SIZE entradas
+ */
+const step_lut_t* sim_robot_step_lut(void){
+  return step_lut;
+}
+
+/**
+ * @brief Desplazamiento de un paso hacia delante
+ * @param heading Orientación en radianes
+ * @param dx Puntero para almacenar desplazamiento x continuo
+ * @param dy Puntero para almacenar desplazamiento y continuo
+ * @return 1 si el paso es diagonal, 0 si no
+ *
+ * Las orientaciones cubiertas por step_lut salen de la tabla; el resto
+ * (ángulos fuera de la rejilla de M_PI_8) usa sin/cos.
+ */
+int sim_robot_step(float heading, float *dx, float *dy){
+  float q = heading * (float)(1.0 / M_PI_8);
+  const step_lut_t *e = NULL;
+  if(!signbit(q) && q < STEP_LUT_SIZE - 0.5f)
+    e = &step_lut[(int)(q + 0.5f)];
+  if(e && heading >= e->lo && heading <= e->hi){
+    *dx = e->dx;
+    *dy = e->dy;
+    return e->diagonal;
+  }
+  step_exact(heading, dx, dy);
+  return is_diagonal_move(*dy, *dx);
+}
+
+/**
+ * @brief Calcula los vectores de movimiento según la orientación
+ * @param r Estado interno del robot
+ * @param heading Orientación en radianes
+ * @param rx Puntero para almacenar nueva posición x entera
+ * @param ry Puntero para almacenar nueva posición y entera
+ * @param dx Puntero para almacenar desplazamiento x continuo
+ * @param dy Puntero para almacenar desplazamiento y continuo
+ * @return 1 si el paso es diagonal, 0 si no
+ */
+static int step_vectors(const robot_t *r, float heading, int *rx, int *ry,
+                        float *dx, float *dy){
+  int diagonal = sim_robot_step(heading, dx, dy);
+  *rx = (int)(r->precise_x + *dx);
+  *ry = (int)(r->precise_y + *dy);
+  return diagonal;
+}
+
+/**
+ * @brief Gestiona una colisión contra un obstáculo
+ * @param ctx Contexto de simulación
+ * 
+ * Activa el bumper, registra estadísticas y consume batería.
+ */
+static void handle_collision(sim_ctx_t *ctx){
+  ctx->robot.sensor.bumper = 1;
+  stats_bump(ctx);
+  tick(ctx, -1);
+  apply_battery(ctx, COST_BUMP);
 }
 
 /**
  * @brief Actualiza la posición del robot
+ * @param r Estado interno del robot
  * @param dx Desplazamiento horizontal continuo
  * @param dy Desplazamiento vertical continuo
  * @param rx Nueva posición x entera
  * @param ry Nueva posición y entera
  */
-static void update_position(float dx, float dy, int rx, int ry){
-  r.precise_x += dx;
-  r.precise_y += dy;
-  rob->x = rx;
-  rob->y = ry;
+static void update_position(robot_t *r, float dx, float dy, int rx, int ry){
+  r->precise_x += dx;
+  r->precise_y += dy;
+  r->sensor.x = rx;
+  r->sensor.y = ry;
 }
 
 /* ============================================================================
- * API PÚBLICA DEL ROBOT
+ * API DEL ROBOT CON CONTEXTO
  * ============================================================================ */
 
 /**
  * @brief Despierta al robot y lo coloca en la base
+ * @param ctx Contexto de simulación
  * @param x Puntero donde devolver la coordenada x inicial
  * @param y Puntero donde devolver la coordenada y inicial
  * @return 1 si OK, 0 si error
@@ -120,161 +225,256 @@ static void update_position(float dx, float dy, int rx, int ry){
  * Coloca al robot en la base del mapa (cargado o generado) y
  * establece su orientación inicial. Inicializa la batería al máximo.
  */
-int rmb_awake(int *x, int *y){
+int rmb_ctx_awake(sim_ctx_t *ctx, int *x, int *y){
+  map_t *map = &ctx->map;
+  sensor_t *rob = &ctx->robot.sensor;
   if(!x || !y) {
     fprintf(stderr, "Error: Invalid parameters for rmb_awake\n");
     return 0;
   }
+  record(ctx, ACTION_AWAKE, 0);
   
   DEBUG_PRINT("Awaking...\n");
-  DEBUG_PRINT("Map: %s\n", map.name);
-  if(map.name[0] != '\0'){
-    if(map.base_x >= 0 && map.base_y >= 0){
-      rob->heading = sim_world_put_base(&map, map.base_x, map.base_y);
-      *x = map.base_x;
-      *y = map.base_y;
+  DEBUG_PRINT("Map: %s\n", map->name);
+  if(map->name[0] != '\0'){
+    if(map->base_x >= 0 && map->base_y >= 0){
+      rob->heading = sim_world_put_base(map, map->base_x, map->base_y);
+      *x = map->base_x;
+      *y = map->base_y;
     } else {
-      sim_world_set_base_origin(&map, x, y, &rob->heading);
+      sim_world_set_base_origin(map, x, y, &rob->heading, &ctx->world_rng);
     }
   } else {
     DEBUG_PRINT("No map loaded\n");
-    sim_world_set_base_origin(&map, x, y, &rob->heading);
-    sim_world_save(&map);
+    sim_world_set_base_origin(map, x, y, &rob->heading, &ctx->world_rng);
+    sim_world_save(map);
   }
   
   // Initialize robot position and battery
-  r.precise_x = *x;
-  r.precise_y = *y;
+  if(ctx->team)
+    sim_team_move(ctx, *y, *x);
+  ctx->robot.precise_x = *x;
+  ctx->robot.precise_y = *y;
   rob->x = *x;
   rob->y = *y;
   rob->battery = MAXBAT;
   rob->bumper = 0;
-  tick(0);
+  tick(ctx, 0);
   return 1;
 }
 
 /**
  * @brief Gira el robot
+ * @param ctx Contexto de simulación
  * @param alpha Ángulo de giro en radianes (positivo = antihorario)
  * 
  * Modifica la orientación del robot y normaliza el ángulo al rango [0, 2π).
  * Consume batería y desactiva el bumper.
  */
-void rmb_turn(float alpha){
+void rmb_ctx_turn(sim_ctx_t *ctx, float alpha){
+  sensor_t *rob = &ctx->robot.sensor;
+  record(ctx, TURN, alpha);
   rob->heading += alpha;
   if(rob->heading < 0)
     rob->heading += 2 * M_PI;
-  rob->heading = fmod(rob->heading, 2 * M_PI);
+  // Dentro de [0, 2π) fmod devuelve el mismo valor: solo se llama fuera
+  if(rob->heading < 0 || rob->heading >= 2 * M_PI)
+    rob->heading = fmod(rob->heading, 2 * M_PI);
   rob->bumper = 0;
-  apply_battery(COST_TURN);
-  stats_move(TURN);
-  tick(0);
+  apply_battery(ctx, COST_TURN);
+  stats_move(ctx, TURN);
+  tick(ctx, 0);
 }
 
 /**
  * @brief Mueve el robot hacia adelante en la dirección actual
+ * @param ctx Contexto de simulación
  * 
  * Intenta mover el robot un paso en la dirección de su orientación.
- * Si hay un obstáculo, activa el bumper y no se mueve. Los movimientos
- * diagonales consumen más batería que los ortogonales.
+ * Si hay un obstáculo (o, con varios robots, otro robot fuera de la base)
+ * activa el bumper y no se mueve. Los movimientos diagonales consumen más
+ * batería que los ortogonales.
  */
-void rmb_forward(){
+void rmb_ctx_forward(sim_ctx_t *ctx){
+  sensor_t *rob = &ctx->robot.sensor;
   float dy, dx;
   int rx, ry;
-  step_vectors(rob->heading, &rx, &ry, &dx, &dy);
-  // Check for wall collision
-  if(sim_world_is_wall(&map, ry, rx)){
-    handle_collision();
+  record(ctx, FWD, 0);
+  int diagonal = step_vectors(&ctx->robot, rob->heading, &rx, &ry, &dx, &dy);
+  // Check for wall collision (or another robot sharing the map)
+  if(sim_world_is_wall(&ctx->map, ry, rx) ||
+     (ctx->team && sim_team_blocked(ctx, ry, rx))){
+    handle_collision(ctx);
     return;
   }
   // Move successful - update position
-  update_position(dx, dy, rx, ry);
-  update_ifr_at_cell();
+  if(ctx->team)
+    sim_team_move(ctx, ry, rx);
+  update_position(&ctx->robot, dx, dy, rx, ry);
+  update_ifr_at_cell(ctx);
   rob->bumper = 0;
   // Update stats
-  stats_move(FWD);
-  stats_visit_cell();
-  tick(rob->infrared);
+  stats_move(ctx, FWD);
+  stats_visit_cell(ctx);
+  tick(ctx, rob->infrared);
   // Apply battery cost (diagonal moves cost more)
-  float cost = is_diagonal_move(dy, dx) ? COST_MOVE_DIAG : COST_MOVE;
-  apply_battery(cost);
+  float cost = diagonal ? COST_MOVE_DIAG : COST_MOVE;
+  apply_battery(ctx, cost);
+}
+
+/**
+ * @brief Avanza varios pasos seguidos
+ * @param ctx Contexto de simulación
+ * @param until Condiciones de parada (RMB_UNTIL_BUMP, RMB_UNTIL_DIRT)
+ * @param n Número máximo de pasos
+ * @return Número de celdas avanzadas
+ *
+ * Cada paso es un rmb_ctx_forward() completo (tick, batería, estadísticas
+ * e historial), de modo que con un solo robot el resultado es idéntico a
+ * llamar a rmb_forward() una vez por ciclo de comportamiento. En
+ * sim_team_run() no lo es: la serie entera ocurre en el turno del robot y
+ * los demás no se mueven entre sus pasos. Un choque siempre termina la
+ * serie (el robot no puede seguir avanzando), y también se para, como
+ * run(), al agotar el tiempo o la batería.
+ */
+int rmb_ctx_forward_until(sim_ctx_t *ctx, int until, int n){
+  const sensor_t *rob = &ctx->robot.sensor;
+  int steps = 0;
+  while(steps < n && !ctx->should_stop && ctx->timer < ctx->config.exec_time){
+    rmb_ctx_forward(ctx);
+    if(rob->bumper)
+      break;
+    steps++;
+    if((until & RMB_UNTIL_DIRT) && rob->infrared > 0)
+      break;
+  }
+  return steps;
 }
 
 /**
  * @brief Limpia la celda actual
+ * @param ctx Contexto de simulación
  * 
  * Si la celda tiene suciedad, reduce su nivel en 1 y actualiza
  * el sensor infrarrojo. Consume batería solo si había suciedad.
  */
-void rmb_clean(){
-  int dirt = sim_world_cell_dirt(&map, rob->y, rob->x);
+void rmb_ctx_clean(sim_ctx_t *ctx){
+  sensor_t *rob = &ctx->robot.sensor;
+  record(ctx, CLEAN, 0);
+  int dirt = sim_world_cell_dirt(&ctx->map, rob->y, rob->x);
   if(dirt > 0){
     int before = dirt;
-    dirt = sim_world_clean_cell(&map, rob->y, rob->x);
-    apply_battery(COST_CLEAN);
+    dirt = sim_world_clean_cell(&ctx->map, rob->y, rob->x);
+    apply_battery(ctx, COST_CLEAN);
     rob->infrared = dirt;
-    stats_clean_action(before, dirt);
+    stats_clean_action(ctx, before, dirt);
   }
-  tick(dirt);
+  tick(ctx, dirt);
 }
 
 /**
  * @brief Recarga la batería si el robot está en la base
+ * @param ctx Contexto de simulación
  * @return 1 si estaba en la base y recargó, 0 si no
  * 
  * Incrementa la batería en LOAD_BATTERY_AMOUNT sin superar MAXBAT.
  */
-int rmb_load(){
-  if(sim_world_is_base(&map, rob->y, rob->x)){
+int rmb_ctx_load(sim_ctx_t *ctx){
+  sensor_t *rob = &ctx->robot.sensor;
+  record(ctx, LOAD, 0);
+  if(sim_world_is_base(&ctx->map, rob->y, rob->x)){
     rob->battery += LOAD_BATTERY_AMOUNT;
     if(rob->battery > MAXBAT)
       rob->battery = MAXBAT;
-    tick(0);
+    tick(ctx, 0);
     return 1;
   }
-  stats_move(LOAD);
+  stats_move(ctx, LOAD);
   return 0;
 }
 
 /**
  * @brief Obtiene una copia del estado actual de los sensores
+ * @param ctx Contexto de simulación
  * @return Estructura sensor_t con el estado actual
  */
-sensor_t rmb_state(){
-  sensor_t s;
-  save_state(&s);
-  return s;
+sensor_t rmb_ctx_state(const sim_ctx_t *ctx){
+  return ctx->robot.sensor;
 }
 
 /**
  * @brief Lee el estado del bumper
+ * @param ctx Contexto de simulación
  * @return 1 si hay colisión detectada, 0 si libre
  */
-int rmb_bumper(){
-  return rob->bumper;
+int rmb_ctx_bumper(const sim_ctx_t *ctx){
+  return ctx->robot.sensor.bumper;
 }
 
 /**
  * @brief Lee el sensor infrarrojo
+ * @param ctx Contexto de simulación
  * @return Nivel de suciedad en la celda actual (0 = limpio)
  */
-int rmb_ifr(){
-  return rob->infrared;
+int rmb_ctx_ifr(const sim_ctx_t *ctx){
+  return ctx->robot.sensor.infrared;
 }
 
 /**
  * @brief Lee el nivel de batería
+ * @param ctx Contexto de simulación
  * @return Batería disponible (0.0 a MAXBAT)
  */
-float rmb_battery(){
-  return rob->battery;
+float rmb_ctx_battery(const sim_ctx_t *ctx){
+  return ctx->robot.sensor.battery;
 }
 
 /**
  * @brief Verifica si el robot está en la base
+ * @param ctx Contexto de simulación
  * @return 1 si está en la base, 0 si no
  */
-int rmb_at_base(){
-  return sim_world_is_base(&map, rob->y, rob->x);
+int rmb_ctx_at_base(const sim_ctx_t *ctx){
+  return sim_world_is_base(&ctx->map, ctx->robot.sensor.y, ctx->robot.sensor.x);
 }
 
+/**
+ * @brief Número pseudoaleatorio para el comportamiento del robot
+ * @param ctx Contexto de simulación
+ * @return Valor uniforme en [0, 2^32)
+ *
+ * Usa el flujo SIM_RNG_ROBOT de la semilla del contexto, independiente del
+ * que genera el mapa, así que no altera el mapa ni la base.
+ */
+unsigned int rmb_ctx_rand(sim_ctx_t *ctx){
+  return sim_rng_next(&ctx->robot_rng);
+}
+
+/**
+ * @brief Índice del robot
+ * @param ctx Contexto de simulación
+ * @return 0 para el robot de configure(), 1, 2... para los de add_robot()
+ */
+int rmb_ctx_id(const sim_ctx_t *ctx){
+  return ctx->robot_id;
+}
+
+/* ============================================================================
+ * API PÚBLICA DEL ROBOT (contexto activo)
+ * ============================================================================ */
+
+int rmb_awake(int *x, int *y){ return rmb_ctx_awake(sim_ctx_current(), x, y); }
+void rmb_turn(float alpha){ rmb_ctx_turn(sim_ctx_current(), alpha); }
+void rmb_forward(){ rmb_ctx_forward(sim_ctx_current()); }
+int rmb_forward_n(int n){ return rmb_ctx_forward_until(sim_ctx_current(), RMB_UNTIL_BUMP, n); }
+int rmb_forward_until(int until, int n){ return rmb_ctx_forward_until(sim_ctx_current(), until, n); }
+void rmb_clean(){ rmb_ctx_clean(sim_ctx_current()); }
+int rmb_load(){ return rmb_ctx_load(sim_ctx_current()); }
+sensor_t rmb_state(){ sim_cycle_taint(sim_ctx_current()); return rmb_ctx_state(sim_ctx_current()); }
+int rmb_bumper(){ return rmb_ctx_bumper(sim_ctx_current()); }
+int rmb_ifr(){ return rmb_ctx_ifr(sim_ctx_current()); }
+float rmb_battery(){ sim_cycle_taint(sim_ctx_current()); return rmb_ctx_battery(sim_ctx_current()); }
+int rmb_at_base(){ return rmb_ctx_at_base(sim_ctx_current()); }
+unsigned int rmb_rand(){ sim_cycle_taint(sim_ctx_current()); return rmb_ctx_rand(sim_ctx_current()); }
+int rmb_id(){ return rmb_ctx_id(sim_ctx_current()); }
+int rmb_declare_state(void *state, int size){ return sim_cycle_declare(sim_ctx_current(), state, size); }
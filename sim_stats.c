@@ -2,18 +2,52 @@
  * @file sim_stats.c
  * @brief Módulo de estadísticas de simulación
  * 
- * Encapsula todas las métricas de la simulación en una estructura
- * estática, proporcionando una API limpia para actualizar y consultar
+ * Encapsula todas las métricas de la simulación en el contexto de
+ * simulación, proporcionando una API limpia para actualizar y consultar
  * estadísticas.
  */
 
 #include <stdio.h>
-#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include "simula_internal.h"
 
-// Stats is now exported for competition_ext.c access
-struct _stat stats = {0};     ///< Estadísticas globales
-static bool visited[WORLDSIZE][WORLDSIZE] = {0}; ///< Celdas visitadas
+/* ============================================================================
+ * FUNCIONES AUXILIARES PRIVADAS
+ * ============================================================================ */
+
+/**
+ * @brief Redimensiona y vacía la matriz de visitadas
+ * @param ctx Contexto de simulación
+ * @param len Número de celdas del mapa
+ *
+ * Vaciarla es pasar a la época siguiente: las marcas de la anterior dejan
+ * de contar sin tocar la memoria. Solo una matriz recién reservada o un
+ * contador que da la vuelta (cada 65535 ejecuciones) se ponen a cero. El
+ * contador de visitas, si está activo, sí se vacía entero.
+ */
+static void reset_visited(sim_ctx_t *ctx, size_t len){
+  if (len != ctx->visited_len) {
+    uint16_t *v = realloc(ctx->visited, len * sizeof(uint16_t));
+    if (v || len == 0) {
+      ctx->visited = v;
+      ctx->visited_len = len;
+      ctx->visit_epoch = 0;
+      free(ctx->visits);
+      ctx->visits = NULL;
+    }
+  }
+  if (ctx->visit_epoch == 0 || ++ctx->visit_epoch == 0) {
+    if (ctx->visited)
+      memset(ctx->visited, 0, ctx->visited_len * sizeof(uint16_t));
+    ctx->visit_epoch = 1;
+  }
+  if (ctx->count_visits && !ctx->visits && ctx->visited_len > 0)
+    ctx->visits = malloc(ctx->visited_len * sizeof(uint32_t));
+  if (ctx->visits)
+    memset(ctx->visits, 0, ctx->visited_len * sizeof(uint32_t));
+  ctx->stats.cell_visited = 0;
+}
 
 /* ============================================================================
  * API PÚBLICA DE ESTADÍSTICAS
@@ -21,104 +55,246 @@ static bool visited[WORLDSIZE][WORLDSIZE] = {0}; ///< Celdas visitadas
 
 /**
  * @brief Registra un movimiento en las estadísticas
+ * @param ctx Contexto de simulación
  * @param kind Tipo de movimiento (enum movement)
  */
-void stats_move(int kind){ 
-  stats.moves[kind]++; 
+void stats_move(sim_ctx_t *ctx, int kind){ 
+  ctx->stats.moves[kind]++; 
 }
 
 /**
  * @brief Incrementa el contador de celdas visitadas
+ * @param ctx Contexto de simulación
  */
-void stats_visit_cell(void){
-  int x = rob->x;
-  int y = rob->y;
-  if (x >= 0 && x < WORLDSIZE && y >= 0 && y < WORLDSIZE) {
-    if (!visited[y][x]) {
-      visited[y][x] = true;
-      stats.cell_visited++;
+void stats_visit_cell(sim_ctx_t *ctx){
+  int x = ctx->robot.sensor.x;
+  int y = ctx->robot.sensor.y;
+  if (x >= 0 && x < ctx->map.ncol && y >= 0 && y < ctx->map.nrow) {
+    size_t idx = (size_t)y * ctx->map.ncol + x;
+    if (idx >= ctx->visited_len)
+      return;
+    int first = ctx->visited[idx] != ctx->visit_epoch;
+    if (first) {
+      ctx->visited[idx] = ctx->visit_epoch;
+      ctx->stats.cell_visited++;
     }
+    if (ctx->visits)
+      ctx->visits[idx]++;
+    // Con contador, cada visita se registra para poder descontarla
+    if (ctx->visit_journal.active && (first || ctx->visits))
+      sim_journal_push(&ctx->visit_journal, idx, first);
+  }
+}
+
+/**
+ * @brief Indica si el robot ha pisado una celda en esta ejecución
+ * @param ctx Contexto de simulación
+ * @param idx Índice row-major de la celda
+ * @return 1 si está visitada, 0 si no
+ */
+int stats_is_visited(const sim_ctx_t *ctx, size_t idx){
+  return idx < ctx->visited_len && ctx->visited[idx] == ctx->visit_epoch;
+}
+
+/**
+ * @brief Activa o desactiva el contador de visitas por celda
+ * @param ctx Contexto de simulación
+ * @param on 1 para contar cada entrada del robot en cada celda
+ * @return 0 si OK, -1 si no hay memoria (el contador queda desactivado)
+ *
+ * Las visitas empiezan en cero; con un mapa de otro tamaño el contador se
+ * vuelve a reservar en reset_visited().
+ */
+int stats_count_visits(sim_ctx_t *ctx, int on){
+  ctx->count_visits = on;
+  free(ctx->visits);
+  ctx->visits = NULL;
+  if (!on || ctx->visited_len == 0)
+    return 0;
+  ctx->visits = calloc(ctx->visited_len, sizeof(uint32_t));
+  if (!ctx->visits) {
+    ctx->count_visits = 0;
+    return -1;
   }
+  return 0;
+}
+
+/**
+ * @brief Entradas en celdas ya visitadas
+ * @param ctx Contexto de simulación con el contador activo
+ * @return Visitas contadas menos celdas distintas visitadas (0 sin contador)
+ */
+uint64_t stats_revisits(const sim_ctx_t *ctx){
+  uint64_t total = 0;
+  if (!ctx->visits)
+    return 0;
+  for (size_t i = 0; i < ctx->visited_len; i++)
+    total += ctx->visits[i];
+  return total - (uint64_t)ctx->stats.cell_visited;
 }
 
 /**
  * @brief Registra una colisión (bumper)
+ * @param ctx Contexto de simulación
  */
-void stats_bump(void){ 
-  stats.moves[BUMP]++; 
+void stats_bump(sim_ctx_t *ctx){ 
+  ctx->stats.moves[BUMP]++; 
 }
 
 /**
  * @brief Registra una acción de limpieza
+ * @param ctx Contexto de simulación
  * @param before Nivel de suciedad antes de limpiar
  * @param after Nivel de suciedad después de limpiar
  * 
  * Incrementa el contador de acciones de limpieza. Si la celda
  * quedó completamente limpia (after == 0), incrementa dirt_cleaned.
  */
-void stats_clean_action(int before, int after){
-  stats.moves[CLEAN]++;
+void stats_clean_action(sim_ctx_t *ctx, int before, int after){
+  ctx->stats.moves[CLEAN]++;
   if(before > 0 && after == 0) 
-    stats.dirt_cleaned++;
+    ctx->stats.dirt_cleaned++;
 }
 
 /**
  * @brief Acumula consumo de batería
+ * @param ctx Contexto de simulación
  * @param amount Cantidad de batería consumida
  */
-void stats_battery_consume(float amount){ 
-  stats.bat_total += amount; 
+void stats_battery_consume(sim_ctx_t *ctx, float amount){ 
+  ctx->stats.bat_total += amount; 
 }
 
 /**
  * @brief Reconstruye estadísticas basándose en el estado del mapa
+ * @param ctx Contexto de simulación
  * @param m Puntero al mapa
  * 
  * Recalcula cell_total (celdas no-murales) y dirt_total
  * (suma de niveles de suciedad) a partir del mapa actual.
+ * La matriz de visitadas se redimensiona al tamaño del mapa.
  */
-void stats_rebuild_from_map(const map_t* m){
+void stats_rebuild_from_map(sim_ctx_t *ctx, const map_t* m){
   int cells = 0;
   int dirt_sum = 0;
-  // Reset visited matrix y contador de celdas visitadas
-  for(int i = 0; i < WORLDSIZE; i++)
-    for(int j = 0; j < WORLDSIZE; j++)
-      visited[i][j] = false;
-  stats.cell_visited = 0;
+  reset_visited(ctx, (size_t)m->nrow * m->ncol);
   for(int i = 0; i < m->nrow; i++){
     for(int j = 0; j < m->ncol; j++){
-      char c = m->cells[i][j];
-      if(c != WALL) cells++;
-      if(c != WALL && c != EMPTY && c != 'B') 
-        dirt_sum += (c - DIGIT_CHAR_BASE);
+      cell_t c = MAP_CELL(m, i, j);
+      if(!(c & CELL_WALL)) cells++;
+      dirt_sum += CELL_DIRT(c);
     }
   }
-  stats.cell_total = cells;
-  stats.dirt_total = dirt_sum;
+  ctx->stats.cell_total = cells;
+  ctx->stats.dirt_total = dirt_sum;
 }
 
 /**
- * @brief Establece la batería media por tick
- * @param mean Valor de batería media
+ * @brief Toma las estadísticas del mapa de otro contexto con el mismo mapa
+ * @param ctx Contexto de simulación
+ * @param owner Contexto cuyo mapa comparte ctx
+ *
+ * Equivale a stats_rebuild_from_map() sin recorrer las celdas: copia
+ * cell_total y dirt_total y deja vacía la matriz de visitadas.
  */
-void stats_set_mean_battery(float mean){
-  stats.bat_mean = mean;
+void stats_share_map(sim_ctx_t *ctx, const sim_ctx_t *owner){
+  reset_visited(ctx, owner->visited_len);
+  ctx->stats.cell_total = owner->stats.cell_total;
+  ctx->stats.dirt_total = owner->stats.dirt_total;
+}
+
+/**
+ * @brief Acumula la batería del tick recién registrado
+ * @param ctx Contexto de simulación (con timer ya incrementado)
+ * @param battery Batería del robot en ese tick
+ *
+ * La suma se hace en float y en orden de ticks, igual que el antiguo
+ * recorrido de hist[] al salir, así que bat_mean no cambia.
+ */
+void stats_tick(sim_ctx_t *ctx, float battery){
+  ctx->stats.bat_sum += battery;
+  ctx->stats.bat_mean = ctx->stats.bat_sum / (float)ctx->timer;
+}
+
+/**
+ * @brief Reinicia el acumulador de batería al empezar una ejecución
+ * @param ctx Contexto de simulación
+ */
+void stats_reset_battery(sim_ctx_t *ctx){
+  ctx->stats.bat_sum = 0.0f;
+  ctx->stats.bat_mean = 0.0f;
 }
 
 /**
  * @brief Obtiene las estadísticas actuales
+ * @param ctx Contexto de simulación
  * @return Puntero de solo lectura a la estructura de estadísticas
  */
-const struct _stat* stats_get(void){
-  return &stats;
+const struct _stat* stats_get(const sim_ctx_t *ctx){
+  return &ctx->stats;
 }
 
 /**
  * @brief Reinicia todas las estadísticas a cero
+ * @param ctx Contexto de simulación
  */
-void stats_reset(void){
-  stats = (struct _stat){0};
-  for(int i = 0; i < WORLDSIZE; i++)
-    for(int j = 0; j < WORLDSIZE; j++)
-      visited[i][j] = false;
+void stats_reset(sim_ctx_t *ctx){
+  ctx->stats = (struct _stat){0};
+  reset_visited(ctx, ctx->visited_len);
+}
+
+/* ============================================================================
+ * LATENCIA DEL COMPORTAMIENTO
+ * ============================================================================ */
+
+/**
+ * @brief Anota una llamada al comportamiento en el histograma
+ * @param prof Medidas del contexto
+ * @param ns Duración de la llamada en nanosegundos
+ * @param idle 1 si el robot no hizo ninguna acción
+ */
+void prof_record(beh_prof_t *prof, uint64_t ns, int idle){
+  int b = 0;
+  while(b < BEH_PROF_BUCKETS - 1 && (ns >> (b + 1)) != 0)
+    b++;
+  prof->bucket[b]++;
+  prof->calls++;
+  prof->idle_calls += idle != 0;
+  prof->total_ns += ns;
+  if(ns > prof->max_ns)
+    prof->max_ns = ns;
+}
+
+/**
+ * @brief Suma las medidas de otro robot
+ * @param dst Medidas acumuladas
+ * @param src Medidas a sumar
+ */
+void prof_merge(beh_prof_t *dst, const beh_prof_t *src){
+  for(int b = 0; b < BEH_PROF_BUCKETS; b++)
+    dst->bucket[b] += src->bucket[b];
+  dst->calls += src->calls;
+  dst->idle_calls += src->idle_calls;
+  dst->actions += src->actions;
+  dst->total_ns += src->total_ns;
+  if(src->max_ns > dst->max_ns)
+    dst->max_ns = src->max_ns;
+}
+
+/**
+ * @brief Percentil de la latencia a partir del histograma
+ * @param prof Medidas
+ * @param pct Percentil (1-100)
+ * @return Cota superior en ns de la cubeta del percentil (sin pasar de max_ns)
+ */
+uint64_t prof_percentile(const beh_prof_t *prof, int pct){
+  uint64_t need = (prof->calls * pct + 99) / 100, seen = 0;
+  for(int b = 0; b < BEH_PROF_BUCKETS; b++){
+    seen += prof->bucket[b];
+    if(seen >= need && seen > 0){
+      uint64_t upper = b < 63 ? ((uint64_t)2 << b) - 1 : UINT64_MAX;
+      return upper < prof->max_ns ? upper : prof->max_ns;
+    }
+  }
+  return 0;
 }
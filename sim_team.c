@@ -0,0 +1,267 @@
+/**
+ * @file sim_team.c
+ * @brief Varios robots limpiando un mismo mapa
+ *
+ * Cada robot añadido con add_robot() es un contexto de simulación propio
+ * que comparte las celdas del mapa del contexto por defecto. run() los
+ * ejecuta por turnos, en orden de índice. Una rejilla con el número de
+ * robots de cada celda, al día en cada rmb_awake() y cada avance, permite
+ * comprobar en O(1) si la celda de destino está ocupada.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simula_internal.h"
+
+/* ============================================================================
+ * FUNCIONES AUXILIARES PRIVADAS
+ * ============================================================================ */
+
+/**
+ * @brief Crea el equipo de un contexto con él como robot 0
+ * @param owner Contexto dueño del mapa
+ * @return Equipo, o NULL si no hay memoria
+ */
+static sim_team_t* team_get(sim_ctx_t *owner){
+  if(owner->team) return owner->team;
+  sim_team_t *t = calloc(1, sizeof(*t));
+  if(!t) return NULL;
+  t->robot[0] = owner;
+  t->n = 1;
+  owner->team = t;
+  owner->robot_id = 0;
+  return t;
+}
+
+/**
+ * @brief Prepara un robot añadido para empezar una ejecución
+ * @param owner Contexto dueño del mapa
+ * @param r Robot añadido
+ *
+ * El robot ve el mapa del dueño tal y como está ahora (incluida la base
+ * si ya la ha colocado otro robot) y parte de sus mismas estadísticas
+ * comunes.
+ */
+static void team_sync(const sim_ctx_t *owner, sim_ctx_t *r){
+  r->map = owner->map;
+  stats_share_map(r, owner);
+}
+
+/**
+ * @brief Prepara la rejilla de ocupación para el mapa del dueño
+ * @param t Equipo
+ * @param m Mapa del dueño
+ * @return 0 si OK, -1 si no hay memoria
+ */
+static int team_reset_occupied(sim_team_t *t, const map_t *m){
+  size_t len = (size_t)m->nrow * m->ncol;
+  if(len != t->occupied_len){
+    unsigned char *o = realloc(t->occupied, len);
+    if(!o && len > 0) return -1;
+    t->occupied = o;
+    t->occupied_len = len;
+  }
+  if(t->occupied)
+    memset(t->occupied, 0, t->occupied_len);
+  return 0;
+}
+
+/* ============================================================================
+ * API DEL EQUIPO
+ * ============================================================================ */
+
+/**
+ * @brief Añade un robot que comparte el mapa de otro contexto
+ * @param owner Contexto ya configurado dueño del mapa
+ * @param start Función de inicialización (puede ser NULL)
+ * @param beh Función de comportamiento (obligatoria)
+ * @param stop Función de finalización (puede ser NULL)
+ * @return Índice del robot, o -1 si error
+ */
+int sim_team_add(sim_ctx_t *owner, void (*start)(), void (*beh)(),
+                 void (*stop)()){
+  if(!beh || !owner->config.exec_beh){
+    fprintf(stderr, "Error: add_robot needs a behavior and a previous configure()\n");
+    return -1;
+  }
+  if(owner->team && owner->team->n >= SIM_TEAM_MAX){
+    fprintf(stderr, "Error: Too many robots (max %d)\n", SIM_TEAM_MAX);
+    return -1;
+  }
+  sim_team_t *t = team_get(owner);
+  sim_ctx_t *r = sim_ctx_create();
+  if(!t || !r){
+    free(r);
+    fprintf(stderr, "Error: Cannot allocate robot\n");
+    return -1;
+  }
+
+  r->config = owner->config;
+  r->config.on_start = start;
+  r->config.exec_beh = beh;
+  r->config.on_stop = stop;
+#if SIM_TRACE_LEVEL == SIM_TRACE_FULL
+  r->hist = calloc(r->config.exec_time, sizeof(sensor_t));
+  if(!r->hist){
+    fprintf(stderr, "Error: Cannot allocate memory for history\n");
+    free(r);
+    return -1;
+  }
+#endif
+  // Misma semilla que el dueño; rmb_rand() con un flujo por robot
+  sim_ctx_seed(r, owner->seed);
+  sim_rng_seed(&r->robot_rng, owner->seed, SIM_RNG_ROBOT + t->n);
+  sim_ctx_profile(r, owner->prof.active);
+  stats_count_visits(r, owner->count_visits);
+
+  r->team = t;
+  r->robot_id = t->n;
+  t->robot[t->n] = r;
+  return t->n++;
+}
+
+/**
+ * @brief Libera los robots añadidos y el equipo de un contexto
+ * @param owner Contexto dueño del mapa
+ *
+ * Las celdas del mapa son del dueño: los robots añadidos sueltan su copia
+ * de la cabecera del mapa antes de destruirse.
+ */
+void sim_team_destroy(sim_ctx_t *owner){
+  sim_team_t *t = owner->team;
+  if(!t) return;
+  for(int k = 1; k < t->n; k++){
+    sim_ctx_t *r = t->robot[k];
+    r->map = (map_t){0};
+    r->team = NULL;
+    sim_ctx_destroy(r);
+  }
+  free(t->occupied);
+  free(t);
+  owner->team = NULL;
+  owner->robot_id = 0;
+}
+
+/**
+ * @brief Ejecuta todos los robots del equipo hasta que terminen
+ * @param owner Contexto dueño del mapa
+ *
+ * Un robot que todavía no ha hecho su primer tick (timer == 0) no ocupa
+ * ninguna celda. Los on_start se ejecutan en orden y cada robot se
+ * despierta en la base que haya colocado el anterior.
+ */
+void sim_team_run(sim_ctx_t *owner){
+  sim_team_t *t = owner->team;
+  if(team_reset_occupied(t, &owner->map) != 0){
+    fprintf(stderr, "Error: Cannot allocate occupancy grid\n");
+    return;
+  }
+  for(int k = 0; k < t->n; k++){
+    sim_ctx_t *r = t->robot[k];
+    r->timer = 0;
+    r->should_stop = 0;
+    r->stall = 0;
+    r->stats.end = SIM_END_TIME;
+    stats_reset_battery(r);
+  }
+  for(int k = 0; k < t->n; k++){
+    sim_ctx_t *r = t->robot[k];
+    if(r != owner) team_sync(owner, r);
+    sim_ctx_bind(r);
+    if(r->config.on_start)
+      r->config.on_start();
+    // rmb_awake() puede haber colocado la base en la copia del robot
+    owner->map.base_x = r->map.base_x;
+    owner->map.base_y = r->map.base_y;
+  }
+
+  int active;
+  do{
+    active = 0;
+    for(int k = 0; k < t->n; k++){
+      sim_ctx_t *r = t->robot[k];
+      if(r->should_stop || r->timer >= r->config.exec_time)
+        continue;
+      sim_ctx_bind(r);
+      sim_ctx_exec_beh(r);
+      active++;
+    }
+  } while(active);
+}
+
+/**
+ * @brief Comprueba si otro robot del equipo ocupa una celda
+ * @param ctx Contexto del robot que se mueve
+ * @param y Fila (dentro del mapa)
+ * @param x Columna (dentro del mapa)
+ * @return 1 si la celda está ocupada, 0 si no
+ *
+ * Un paso corto puede acabar en la misma celda del robot, que entonces
+ * no se cuenta a sí mismo.
+ */
+int sim_team_blocked(const sim_ctx_t *ctx, int y, int x){
+  const sim_team_t *t = ctx->team;
+  size_t idx = (size_t)y * ctx->map.ncol + x;
+  if(!t || idx >= t->occupied_len)
+    return 0;
+  const sensor_t *rob = &ctx->robot.sensor;
+  int self = ctx->timer > 0 && rob->x == x && rob->y == y;
+  return t->occupied[idx] > self && !sim_world_is_base(&ctx->map, y, x);
+}
+
+/**
+ * @brief Anota en el equipo que un robot se coloca en una celda
+ * @param ctx Contexto del robot
+ * @param y Fila de destino
+ * @param x Columna de destino
+ */
+void sim_team_move(sim_ctx_t *ctx, int y, int x){
+  sim_team_t *t = ctx->team;
+  const sensor_t *rob = &ctx->robot.sensor;
+  size_t ncol = ctx->map.ncol;
+  size_t from = (size_t)rob->y * ncol + rob->x;
+  size_t to = (size_t)y * ncol + x;
+  if(!t || to >= t->occupied_len)
+    return;
+  if(ctx->timer > 0 && from < t->occupied_len)
+    t->occupied[from]--;
+  t->occupied[to]++;
+}
+
+/**
+ * @brief Estadísticas del conjunto de robots
+ * @param owner Contexto dueño del mapa
+ * @param st Estructura a rellenar
+ */
+void sim_team_stats(const sim_ctx_t *owner, struct _stat *st){
+  const sim_team_t *t = owner->team;
+  int ticks = 0;
+  *st = (struct _stat){0};
+  st->cell_total = owner->stats.cell_total;
+  st->dirt_total = owner->stats.dirt_total;
+  for(int k = 0; k < t->n; k++){
+    const sim_ctx_t *r = t->robot[k];
+    st->dirt_cleaned += r->stats.dirt_cleaned;
+    st->bat_total += r->stats.bat_total;
+    st->bat_sum += r->stats.bat_sum;
+    for(int i = 0; i < 5; i++)
+      st->moves[i] += r->stats.moves[i];
+    // El motivo más grave de los robots (enum sim_end va de menos a más)
+    if(r->stats.end > st->end)
+      st->end = r->stats.end;
+    ticks += r->timer;
+  }
+  st->bat_mean = ticks > 0 ? st->bat_sum / (float)ticks : 0.0f;
+
+  // Celdas pisadas por al menos un robot
+  for(size_t i = 0; i < owner->visited_len; i++){
+    for(int k = 0; k < t->n; k++){
+      const sim_ctx_t *r = t->robot[k];
+      if(stats_is_visited(r, i)){
+        st->cell_visited++;
+        break;
+      }
+    }
+  }
+}
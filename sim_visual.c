@@ -14,11 +14,42 @@
 #include <math.h>
 #include <time.h>
 #include <signal.h>
+#include <errno.h>
 #include "simula_internal.h"
 
 #define RAD_TO_DEG (180.0 / M_PI)           ///< Conversión radianes a grados
 #define VISUALIZATION_DELAY_MS 100          ///< Retardo entre frames (ms)
 #define COMPASS_BUF_SIZE 4                  ///< Tamaño buffer para puntos cardinales
+#define STATUS_BUF_SIZE 256                 ///< Tamaño buffer para el estado del robot
+#define VIS_STATUS_ROWS 7                   ///< Filas del estado bajo el mapa
+#define VIS_HELP "[Espacio]=pausa, S=siguiente, A=anterior, q=salir" ///< Teclas
+#define VIS_NO_CELL ((size_t)-1)            ///< Posición fuera del mapa
+
+/// Celda (y, x) de un buffer de visualización con la geometría del mapa
+#define VIEW_CELL(map, view, y, x) ((view)[(size_t)(y) * (map)->ncol + (x)])
+
+/**
+ * @brief Pantalla del visualizador animado
+ *
+ * Guarda lo que ya está escrito en el terminal y, para cada celda, el
+ * primer tick en que la pisa el robot. El fotograma de t ticks solo se
+ * diferencia del de t-1 o t+1 en la celda del tick que entra o sale y en
+ * las marcas B y o, así que avanzar o retroceder un tick cuesta O(1) y solo
+ * se escriben las celdas que cambian.
+ */
+typedef struct {
+  const map_t *map;       ///< Mapa de la simulación
+  const sensor_t *hist;   ///< Historial de posiciones
+  char *base;             ///< Vista con la suciedad inicial
+  char *shown;            ///< Celdas ya escritas en el terminal
+  int *first;             ///< Primer tick en cada celda (timer si ninguno)
+  int len;                ///< Ticks mostrados (-1 si no hay nada dibujado)
+  char status[STATUS_BUF_SIZE]; ///< Estado ya escrito bajo el mapa
+  int row, col;           ///< Posición del cursor (row < 0 si desconocida)
+  char *out;              ///< Salida del fotograma en curso
+  size_t out_len;         ///< Bytes en out
+  size_t out_cap;         ///< Capacidad de out (cabe un fotograma completo)
+} vis_term_t;
 
 /**
  * @brief Genera una barra de progreso ASCII
@@ -55,77 +86,92 @@ static char *compass(float angle){
 }
 
 /**
- * @brief Imprime el mapa en formato ASCII
- * @param view Matriz de caracteres a mostrar
+ * @brief Celda del mapa en la que estaba el robot en un tick
+ * @param map Mapa de la simulación
+ * @param h Historial de posiciones
+ * @param i Tick
+ * @return Índice de la celda, o VIS_NO_CELL si está fuera del mapa
  */
-static void print_map_ascii(char view[WORLDSIZE][WORLDSIZE]){
-  int max_width = map.ncol > PROGBARLEN ? map.ncol : PROGBARLEN;
-  for(int i = 0; i < map.nrow; i++){
-    int j = 0;
-    for(; j < map.ncol; j++)
-      printf("%c", view[i][j]);
-    for(; j < max_width; j++)
-      printf(" ");
-    printf("\n");
-  }
+static size_t hist_cell(const map_t *map, const sensor_t h[], int i){
+  if(h[i].y < 0 || h[i].y >= map->nrow || h[i].x < 0 || h[i].x >= map->ncol)
+    return VIS_NO_CELL;
+  return (size_t)h[i].y * map->ncol + h[i].x;
 }
 
 /**
- * @brief Anota la suciedad en el mapa de visualización
- * @param view Matriz de caracteres a modificar
+ * @brief Construye la vista del mapa con la suciedad inicial
+ * @param map Mapa de la simulación (estado final)
+ * @param base Buffer de nrow*ncol caracteres a rellenar
+ * @param first Buffer de nrow*ncol enteros: primer tick en cada celda
+ * @param h Historial de posiciones
+ * @param len Longitud del historial
+ *
+ * El mapa solo conserva la suciedad que queda tras la ejecución. El nivel
+ * inicial de las celdas limpiadas se recupera del historial: el infrarrojo
+ * registrado al llegar a una celda es su suciedad antes de limpiarla.
  */
-static void annotate_dirt_to_map(char view[WORLDSIZE][WORLDSIZE]){
-  for(int i = 0; i < map.ndirt; i++){
-    dirt_t d = map.dirt[i];
-    if(d.y >= 0 && d.y < map.nrow && d.x >= 0 && d.x < map.ncol){
-      view[d.y][d.x] = (char)(DIGIT_CHAR_BASE + d.depth);
-    }
+static void build_initial_view(const map_t *map, char *base, int *first,
+                               sensor_t h[], int len){
+  size_t ncell = (size_t)map->nrow * map->ncol;
+  for(size_t k = 0; k < ncell; k++){
+    base[k] = sim_world_cell_char(map->cells[k]);
+    first[k] = len;
+  }
+  for(int i = 0; i < len; i++){
+    size_t k = hist_cell(map, h, i);
+    if(k == VIS_NO_CELL) continue;
+    if(first[k] == len) first[k] = i;
+    if(h[i].infrared <= 0) continue;
+    int depth = (base[k] == EMPTY) ? 0 : base[k] - DIGIT_CHAR_BASE;
+    if(h[i].infrared > depth)
+      base[k] = (char)(DIGIT_CHAR_BASE + h[i].infrared);
   }
 }
 
 /**
- * @brief Dibuja el recorrido del robot sobre el mapa
- * @param view Matriz de caracteres a modificar
- * @param h Historial de posiciones
- * @param len Longitud del historial
+ * @brief Carácter de una celda tras len ticks
+ * @param v Pantalla
+ * @param k Celda
+ * @param len Ticks recorridos
+ * @return Carácter: o (robot), B (base), . (recorrido) o el del mapa
  */
-static void overlay_path_on_map(char view[WORLDSIZE][WORLDSIZE], sensor_t h[], int len){
-  for(int i = 0; i < len; i++){
-    if(h[i].y >= 0 && h[i].y < map.nrow && h[i].x >= 0 && h[i].x < map.ncol){
-      view[h[i].y][h[i].x] = '.';
-    }
-  }
+static char vis_cell(const vis_term_t *v, size_t k, int len){
+  if(len > 0 && k == hist_cell(v->map, v->hist, len - 1)) return 'o';
+  if(len > 0 && k == hist_cell(v->map, v->hist, 0)) return 'B';
+  if(v->first[k] < len) return '.';
+  return v->base[k];
 }
 
 /**
- * @brief Marca la base y el final del recorrido en el mapa
- * @param view Matriz de caracteres a modificar
- * @param h Historial de posiciones
- * @param len Longitud del historial
+ * @brief Imprime el mapa en formato ASCII
+ * @param map Mapa de la simulación
+ * @param view Celdas a mostrar
  */
-static void mark_base_and_end(char view[WORLDSIZE][WORLDSIZE], sensor_t h[], int len){
-  if(len > 0){
-    if(h[0].y >= 0 && h[0].y < map.nrow && h[0].x >= 0 && h[0].x < map.ncol){
-      view[h[0].y][h[0].x] = 'B';
-    }
-    if(h[len-1].y >= 0 && h[len-1].y < map.nrow && h[len-1].x >= 0 && h[len-1].x < map.ncol){
-      view[h[len-1].y][h[len-1].x] = 'o';
-    }
+static void print_map_ascii(const map_t *map, char *view){
+  int max_width = map->ncol > PROGBARLEN ? map->ncol : PROGBARLEN;
+  for(int i = 0; i < map->nrow; i++){
+    int j = 0;
+    for(; j < map->ncol; j++)
+      printf("%c", VIEW_CELL(map, view, i, j));
+    for(; j < max_width; j++)
+      printf(" ");
+    printf("\n");
   }
 }
 
 /**
- * @brief Imprime el estado actual del robot (batería, posición, sensores)
+ * @brief Escribe el estado actual del robot (batería, posición, sensores)
  * @param s Puntero a la estructura de sensores actual
+ * @param buf Buffer de salida
+ * @param size Tamaño de buf
  */
-static void print_status_line(sensor_t *s){
+static void format_status(const sensor_t *s, char *buf, size_t size){
   int bat = s->battery / MAXBAT * 100;
-  printf("\nBATT: %s %d%%", ascii_progress(bat), bat);
-  if (bat < 20 && bat > 0.1)
-    printf(" WARNING!");
-  printf("\n\nPOS (y:%2d,x:%2d)\t\tHEAD: %s (%d)\n",
-    s->y, s->x, compass(s->heading), (int)(s->heading * RAD_TO_DEG));
-  printf("\nBUMPER: %c\t\t IFR: %c%s\n",
+  snprintf(buf, size,
+    "\nBATT: %s %d%%%s\n\nPOS (y:%2d,x:%2d)\t\tHEAD: %s (%d)\n"
+    "\nBUMPER: %c\t\t IFR: %c%s\n",
+    ascii_progress(bat), bat, (bat < 20 && bat > 0.1) ? " WARNING!" : "",
+    s->y, s->x, compass(s->heading), (int)(s->heading * RAD_TO_DEG),
     s->bumper ? 'D' : ' ',
     s->infrared > 0 ? s->infrared + DIGIT_CHAR_BASE : ' ',
     s->infrared > 0 ? "...cleaning" : " ");
@@ -143,32 +189,212 @@ static void sigint_vis_handler(int signo){
 }
 
 /**
- * @brief Imprime el mapa con el recorrido y estado actual
- * @param view Matriz de caracteres a mostrar
- * @param h Historial de posiciones
- * @param len Longitud del historial
+ * @brief Imprime el mapa con el recorrido y estado tras len ticks
+ * @param v Pantalla (su buffer shown se reutiliza como vista)
+ * @param len Ticks recorridos
  */
-static void print_path(char view[WORLDSIZE][WORLDSIZE], sensor_t h[], int len){
-  annotate_dirt_to_map(view);
-  overlay_path_on_map(view, h, len);
-  mark_base_and_end(view, h, len);
-  print_map_ascii(view);
+static void print_path(vis_term_t *v, int len){
+  size_t ncell = (size_t)v->map->nrow * v->map->ncol;
+  for(size_t k = 0; k < ncell; k++)
+    v->shown[k] = vis_cell(v, k, len);
+  print_map_ascii(v->map, v->shown);
   if(len > 0){
-    print_status_line(&h[len-1]);
+    format_status(&v->hist[len-1], v->status, sizeof(v->status));
+    fputs(v->status, stdout);
+  }
+}
+
+/* ============================================================================
+ * PANTALLA INCREMENTAL
+ * ============================================================================ */
+
+/**
+ * @brief Escribe en el terminal la salida acumulada con un solo write()
+ * @param v Pantalla
+ */
+static void vis_flush(vis_term_t *v){
+  size_t done = 0;
+  while(done < v->out_len){
+    ssize_t n = write(STDOUT_FILENO, v->out + done, v->out_len - done);
+    if(n > 0) done += n;
+    else if(n < 0 && errno == EINTR) continue;
+    else break;
   }
+  v->out_len = 0;
 }
 
 /**
- * @brief Visualiza la simulación paso a paso en consola
+ * @brief Añade bytes a la salida del fotograma
+ * @param v Pantalla
+ * @param s Bytes
+ * @param n Número de bytes
+ *
+ * out tiene sitio para un fotograma completo: solo se vacía antes de
+ * tiempo si un fotograma no cabe, lo que no debería pasar.
+ */
+static void vis_put(vis_term_t *v, const char *s, size_t n){
+  while(n > 0){
+    if(v->out_len == v->out_cap) vis_flush(v);
+    size_t room = v->out_cap - v->out_len;
+    size_t k = n < room ? n : room;
+    memcpy(v->out + v->out_len, s, k);
+    v->out_len += k;
+    s += k;
+    n -= k;
+  }
+}
+
+/**
+ * @brief Mueve el cursor, si no está ya allí
+ * @param v Pantalla
+ * @param row Fila (desde 1)
+ * @param col Columna (desde 1)
+ */
+static void vis_goto(vis_term_t *v, int row, int col){
+  char esc[32];
+  if(v->row == row && v->col == col) return;
+  int n = snprintf(esc, sizeof(esc), "\033[%d;%dH", row, col);
+  vis_put(v, esc, n);
+  v->row = row;
+  v->col = col;
+}
+
+/**
+ * @brief Escribe una celda si ha cambiado desde el último fotograma
+ * @param v Pantalla
+ * @param k Celda (VIS_NO_CELL se ignora)
+ */
+static void vis_update_cell(vis_term_t *v, size_t k){
+  if(k == VIS_NO_CELL) return;
+  char c = vis_cell(v, k, v->len);
+  if(c == v->shown[k]) return;
+  vis_goto(v, k / v->map->ncol + 1, k % v->map->ncol + 1);
+  vis_put(v, &c, 1);
+  v->shown[k] = c;
+  v->col++;
+}
+
+/**
+ * @brief Escribe el estado bajo el mapa si ha cambiado
+ * @param v Pantalla
+ * @param force Escribirlo aunque no haya cambiado
+ *
+ * Cada línea se termina borrando el resto de la fila y los tabuladores se
+ * escriben como espacios (un tabulador solo mueve el cursor), de modo que
+ * no quedan restos del estado anterior.
+ */
+static void vis_update_status(vis_term_t *v, int force){
+  char text[STATUS_BUF_SIZE] = "";
+  if(v->len > 0)
+    format_status(&v->hist[v->len-1], text, sizeof(text));
+  if(!force && strcmp(text, v->status) == 0) return;
+  memcpy(v->status, text, sizeof(text));
+
+  vis_goto(v, v->map->nrow + 1, 1);
+  int rows = 1, col = 0;
+  for(const char *p = text; ; p++){
+    if(*p == '\n' || *p == '\0'){
+      vis_put(v, "\033[K", 3);
+      if(*p == '\0') break;
+      vis_put(v, "\n", 1);
+      rows++;
+      col = 0;
+    }
+    else if(*p == '\t'){
+      do{ vis_put(v, " ", 1); } while(++col % 8);
+    }
+    else{
+      vis_put(v, p, 1);
+      col++;
+    }
+  }
+  for(; rows < VIS_STATUS_ROWS; rows++)
+    vis_put(v, "\n\033[K", 4);
+  v->row = -1;
+}
+
+/**
+ * @brief Dibuja la pantalla completa tras len ticks
+ * @param v Pantalla
+ * @param len Ticks recorridos
+ */
+static void vis_redraw(vis_term_t *v, int len){
+  const map_t *map = v->map;
+  v->len = len;
+  vis_put(v, "\033[2J\033[H", 7);
+  for(int i = 0; i < map->nrow; i++){
+    for(int j = 0; j < map->ncol; j++){
+      size_t k = (size_t)i * map->ncol + j;
+      v->shown[k] = vis_cell(v, k, len);
+    }
+    vis_put(v, v->shown + (size_t)i * map->ncol, map->ncol);
+    vis_put(v, "\n", 1);
+  }
+  v->row = -1;
+  vis_update_status(v, 1);
+  vis_goto(v, map->nrow + VIS_STATUS_ROWS + 1, 1);
+  vis_put(v, VIS_HELP, strlen(VIS_HELP));
+  v->row = -1;
+}
+
+/**
+ * @brief Muestra el fotograma de len ticks
+ * @param v Pantalla
+ * @param len Ticks recorridos
+ *
+ * Desde el fotograma anterior solo pueden cambiar las celdas de los ticks
+ * que entran o salen y las de las marcas B y o: con pasos de un tick el
+ * coste no depende ni del tamaño del mapa ni de la longitud del historial.
+ */
+static void vis_show(vis_term_t *v, int len){
+  if(v->len < 0){
+    vis_redraw(v, len);
+  }else if(len != v->len){
+    int old = v->len;
+    int lo = old < len ? old : len;
+    int hi = old < len ? len : old;
+    v->len = len;
+    for(int i = lo; i < hi; i++)
+      vis_update_cell(v, hist_cell(v->map, v->hist, i));
+    if(old > 0) vis_update_cell(v, hist_cell(v->map, v->hist, old - 1));
+    if(len > 0) vis_update_cell(v, hist_cell(v->map, v->hist, len - 1));
+    vis_update_cell(v, hist_cell(v->map, v->hist, 0));
+    vis_update_status(v, 0);
+  }
+  vis_flush(v);
+}
+
+/**
+ * @brief Visualiza la simulación de un contexto paso a paso en consola
+ * @param ctx Contexto de simulación
  *
  * Muestra el mapa, el recorrido y el estado del robot en modo animado.
  * Requiere que ENABLE_VISUALIZATION esté activado.
  */
-void visualize(){
+void sim_ctx_visualize(sim_ctx_t *ctx){
+  const map_t *map = &ctx->map;
+  sensor_t *hist = ctx->hist;
+  int timer = ctx->timer;
   if(!hist){
     printf("No history available for visualization\n");
     return;
   }
+  size_t ncell = (size_t)map->nrow * map->ncol;
+  vis_term_t v = { .map = map, .hist = hist, .len = -1, .row = -1 };
+  // Un fotograma completo: celdas, saltos de línea, estado y ayuda
+  v.out_cap = ncell + map->nrow + STATUS_BUF_SIZE + 4 * VIS_STATUS_ROWS + 256;
+  v.base = malloc(2 * ncell);
+  v.first = malloc(ncell * sizeof(int));
+  v.out = malloc(v.out_cap);
+  if(!v.base || !v.first || !v.out){
+    fprintf(stderr, "Error: Cannot allocate visualization buffer\n");
+    free(v.base);
+    free(v.first);
+    free(v.out);
+    return;
+  }
+  v.shown = v.base + ncell;
+  build_initial_view(map, v.base, v.first, hist, timer);
   g_stop_vis = 0;
   void (*prev)(int) = signal(SIGINT, sigint_vis_handler);
   // Configurar terminal en modo no canónico
@@ -180,22 +406,14 @@ void visualize(){
   int oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
   fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
 
-  printf("\033[?1049h\033[?25l\033[2J");
+  // A partir de aquí la pantalla se escribe con write(): vaciar stdio antes
+  printf("\033[?1049h\033[?25l");
   fflush(stdout);
   int t = 0;
   int paused = 0;
-    printf("\n[Espacio]=pausa, S=siguiente, A=anterior, q=salir\n");
   while (t < timer && !g_stop_vis) {
     if (!paused) {
-      printf("\033[2J");
-      printf("\033[H");
-      char view[WORLDSIZE][WORLDSIZE];
-      for(int i = 0; i < map.nrow; i++)
-        for(int j = 0; j < map.ncol; j++)
-          view[i][j] = map.cells[i][j];
-      print_path(view, hist, t);
-      printf("\n[Espacio]=pausa, S=siguiente, A=anterior, q=salir\n");
-      fflush(stdout);
+      vis_show(&v, t);
       const long ms = VISUALIZATION_DELAY_MS;
       struct timespec ts = { ms/1000, (ms%1000)*1000000L };
       nanosleep(&ts, NULL);
@@ -209,15 +427,7 @@ void visualize(){
       int redraw = 1;
       while (paused && !g_stop_vis) {
         if (redraw) {
-          printf("\033[2J");
-          printf("\033[H");
-          char view[WORLDSIZE][WORLDSIZE];
-          for(int i = 0; i < map.nrow; i++)
-            for(int j = 0; j < map.ncol; j++)
-              view[i][j] = map.cells[i][j];
-          print_path(view, hist, t);
-          printf("\n[Espacio]=pausa, S=siguiente, A=anterior, q=salir\n");
-          fflush(stdout);
+          vis_show(&v, t);
           redraw = 0;
         }
         int c = getchar();
@@ -236,12 +446,8 @@ void visualize(){
   // Restaurar terminal
   tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
   fcntl(STDIN_FILENO, F_SETFL, oldf);
-  // Antes de restaurar el buffer normal, guardar el último frame
+  // Último fotograma, que queda en el buffer normal
   int last_tick = (timer < 1) ? 0 : (timer-1);
-  char view[WORLDSIZE][WORLDSIZE];
-  for(int i = 0; i < map.nrow; i++)
-    for(int j = 0; j < map.ncol; j++)
-      view[i][j] = map.cells[i][j];
 
   // Restaurar buffer normal y cursor
   printf("\033[?25h\033[?1049l");
@@ -249,9 +455,19 @@ void visualize(){
   signal(SIGINT, prev);
 
   // Imprimir el último frame en el buffer normal
-  print_path(view, hist, last_tick);
+  print_path(&v, last_tick);
   printf("\n--- Simulación finalizada ---\n");
-  printf("\n[Espacio]=pausa, S=siguiente, A=anterior, q=salir\n");
+  printf("\n" VIS_HELP "\n");
   fflush(stdout);
+  free(v.base);
+  free(v.first);
+  free(v.out);
+}
+
+/**
+ * @brief Visualiza la simulación del contexto activo
+ */
+void visualize(){
+  sim_ctx_visualize(sim_ctx_current());
 }
 /* --- FIN DEL ARCHIVO ORIGINAL --- */
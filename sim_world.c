@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stddef.h>
+#include <sys/stat.h>
 #include "simula_internal.h"
 
 #define PGM_WALL_VALUE 128            ///< Valor de gris para obstáculos en PGM
@@ -17,14 +19,34 @@
 #define PGM_BASE_VALUE 0              ///< Valor de gris para la base en PGM
 #define BORDER_MARGIN 2               ///< Margen desde el borde para generar obstáculos
 #define WALL_MIN_OFFSET 4             ///< Offset mínimo para posicionar muros
-#define LINE_BUFFER_SIZE 256          ///< Tamaño del buffer para leer líneas
+#define MAP_CACHE_SIZE 16             ///< Número de mapas que guarda la caché
 
 /* ============================================================================
  * FUNCIONES AUXILIARES PRIVADAS
  * ============================================================================ */
 
 // Forward declarations
-static void place_base_randomly(map_t* m);
+static void place_base_randomly(map_t* m, sim_rng_t *rng);
+
+/**
+ * @brief Descarta el índice de suciedad del mapa
+ * @param m Puntero al mapa
+ */
+static void drop_dirt_index(map_t* m){
+  free(m->dirt);
+  m->dirt = NULL;
+  m->ndirt = 0;
+}
+
+/**
+ * @brief Codifica un nivel de suciedad dentro de los bits de la celda
+ * @param depth Nivel de suciedad
+ * @return Nivel saturado a CELL_DIRT_MASK
+ */
+static cell_t dirt_bits(int depth){
+  if(depth <= 0) return 0;
+  return depth > CELL_DIRT_MASK ? CELL_DIRT_MASK : (cell_t)depth;
+}
 
 /**
  * @brief Calcula la orientación apropiada para la base según su posición
@@ -33,7 +55,7 @@ static void place_base_randomly(map_t* m);
  * @param y Fila de la base
  * @return Ángulo en radianes (apunta hacia el centro del mapa)
  */
-static float base_heading(const map_t* m, int x, int y){
+float sim_world_base_heading(const map_t* m, int x, int y){
   // En sistema de coordenadas donde y crece hacia abajo:
   // - y=1 (arriba) debe apuntar hacia abajo (3π/2 = 270°)
   // - y=nrow-2 (abajo) debe apuntar hacia arriba (π/2 = 90°)
@@ -49,6 +71,115 @@ static float base_heading(const map_t* m, int x, int y){
  * API PÚBLICA DE MUNDO
  * ============================================================================ */
 
+/**
+ * @brief Reserva las celdas de un mapa de nrow x ncol
+ * @param m Puntero al mapa
+ * @param nrow Número de filas
+ * @param ncol Número de columnas
+ * @return 0 si OK, -1 si las dimensiones no son válidas o no hay memoria
+ */
+int sim_world_alloc(map_t* m, int nrow, int ncol){
+  if(nrow <= 0 || ncol <= 0 || nrow > MAX_WORLDSIZE || ncol > MAX_WORLDSIZE){
+    fprintf(stderr, "Error: Invalid map size (%dx%d)\n", nrow, ncol);
+    return -1;
+  }
+  if(!m->cells || m->nrow != nrow || m->ncol != ncol){
+    cell_t *cells = realloc(m->cells, (size_t)nrow * ncol);
+    if(!cells){
+      fprintf(stderr, "Error: Cannot allocate %dx%d map\n", nrow, ncol);
+      return -1;
+    }
+    m->cells = cells;
+  }
+  m->nrow = nrow;
+  m->ncol = ncol;
+  drop_dirt_index(m);
+  return 0;
+}
+
+/**
+ * @brief Libera la memoria dinámica de un mapa
+ * @param m Puntero al mapa
+ */
+void sim_world_free(map_t* m){
+  free(m->cells);
+  m->cells = NULL;
+  m->nrow = m->ncol = 0;
+  drop_dirt_index(m);
+}
+
+/**
+ * @brief Construye el índice disperso de celdas sucias
+ * @param m Puntero al mapa
+ * @return Número de celdas sucias, o -1 si no hay memoria
+ */
+int sim_world_dirt_index(map_t* m){
+  size_t len = (size_t)m->nrow * m->ncol;
+  int n = 0;
+  for(size_t k = 0; k < len; k++)
+    if(CELL_DIRT(m->cells[k])) n++;
+  drop_dirt_index(m);
+  if(n == 0) return 0;
+  m->dirt = malloc((size_t)n * sizeof(dirt_t));
+  if(!m->dirt) return -1;
+  for(size_t k = 0; k < len; k++){
+    int depth = CELL_DIRT(m->cells[k]);
+    if(!depth) continue;
+    m->dirt[m->ndirt].x = (int)(k % m->ncol);
+    m->dirt[m->ndirt].y = (int)(k / m->ncol);
+    m->dirt[m->ndirt].depth = depth;
+    m->ndirt++;
+  }
+  return n;
+}
+
+/**
+ * @brief Memoria ocupada por un mapa
+ * @param m Puntero al mapa
+ * @return Bytes de la estructura, las celdas y el índice de suciedad
+ */
+size_t sim_world_footprint(const map_t* m){
+  size_t bytes = sizeof(map_t);
+  if(m->cells) bytes += (size_t)m->nrow * m->ncol * sizeof(cell_t);
+  if(m->dirt) bytes += (size_t)m->ndirt * sizeof(dirt_t);
+  return bytes;
+}
+
+/**
+ * @brief Hash FNV-1a de 64 bits de las dimensiones y celdas de un mapa
+ * @param m Puntero al mapa
+ * @return Hash del mapa
+ *
+ * Identifica el mapa sobre el que se grabó una traza.
+ */
+uint64_t sim_world_hash(const map_t* m){
+  uint64_t h = 14695981039346656037ULL;
+  int dims[2] = { m->nrow, m->ncol };
+  for(int d = 0; d < 2; d++)
+    for(int b = 0; b < 4; b++){
+      h ^= (unsigned char)(dims[d] >> (8 * b));
+      h *= 1099511628211ULL;
+    }
+  size_t len = m->cells ? (size_t)m->nrow * m->ncol : 0;
+  for(size_t k = 0; k < len; k++){
+    h ^= m->cells[k];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/**
+ * @brief Carácter ASCII con el que se representa una celda
+ * @param c Celda codificada
+ * @return WALL, EMPTY, 'B' o el dígito de su nivel de suciedad
+ */
+char sim_world_cell_char(cell_t c){
+  if(c & CELL_WALL) return WALL;
+  if(c & CELL_BASE) return 'B';
+  if(CELL_DIRT(c)) return (char)(DIGIT_CHAR_BASE + CELL_DIRT(c));
+  return EMPTY;
+}
+
 /**
  * @brief Coloca la base en una posición específica del mapa
  * @param m Puntero al mapa
@@ -57,10 +188,12 @@ static float base_heading(const map_t* m, int x, int y){
  * @return Orientación apropiada en radianes
  */
 float sim_world_put_base(map_t* m, int x, int y){
-  m->cells[y][x] = 'B';
+  if(m->journal)
+    sim_journal_push(m->journal, (size_t)y * m->ncol + x, MAP_CELL(m, y, x));
+  MAP_CELL(m, y, x) = CELL_BASE;
   m->base_x = x;
   m->base_y = y;
-  return base_heading(m, x, y);
+  return sim_world_base_heading(m, x, y);
 }
 
 /**
@@ -69,11 +202,13 @@ float sim_world_put_base(map_t* m, int x, int y){
  * @param x Puntero donde guardar la columna inicial
  * @param y Puntero donde guardar la fila inicial
  * @param h Puntero donde guardar la orientación inicial
+ * @param rng Generador para colocar la base si el mapa no tiene
  * 
  * Si el mapa ya tiene una base definida (base_x, base_y > 0), usa esa posición.
  * Si no, coloca la base aleatoriamente en una pared con orientación perpendicular.
  */
-void sim_world_set_base_origin(map_t* m, int *x, int *y, float *h){
+void sim_world_set_base_origin(map_t* m, int *x, int *y, float *h,
+                               sim_rng_t *rng){
   if(!x || !y || !h){
     fprintf(stderr, "Error: Invalid parameters for sim_world_set_base_origin\n");
     return;
@@ -83,43 +218,84 @@ void sim_world_set_base_origin(map_t* m, int *x, int *y, float *h){
   if(m->base_x > 0 && m->base_y > 0){
     *x = m->base_x;
     *y = m->base_y;
-    *h = base_heading(m, *x, *y);
+    *h = sim_world_base_heading(m, *x, *y);
   } else {
     // Si no hay base definida, colocarla aleatoriamente
-    place_base_randomly(m);
+    place_base_randomly(m, rng);
     *x = m->base_x;
     *y = m->base_y;
-    *h = base_heading(m, *x, *y);
+    *h = sim_world_base_heading(m, *x, *y);
   }
 }
 
 /**
- * @brief Guarda el mapa actual en formato PGM
+ * @brief Valor de gris PGM de una celda
+ * @param c Celda codificada
+ * @return 128 obstáculo, 0 base, nivel de suciedad o 255 si vacía
+ */
+static int cell_pgm_value(cell_t c){
+  if(c & CELL_WALL) return PGM_WALL_VALUE;
+  if(c & CELL_BASE) return PGM_BASE_VALUE;
+  if(CELL_DIRT(c)) return CELL_DIRT(c);
+  return PGM_EMPTY_VALUE;
+}
+
+/**
+ * @brief Escribe un mapa en un archivo PGM
  * @param m Puntero al mapa
- * 
- * Genera un archivo map.pgm en el directorio actual con el estado
- * del mapa: obstáculos (128), celdas vacías (255), base (0),
- * y suciedad (1-MAXDIRT).
+ * @param filename Ruta del archivo destino
+ * @param binary 0 para P2 (texto), distinto de 0 para P5 (binario)
+ * @return 0 si OK, -1 si error
+ *
+ * Cada fila se compone en un buffer y se escribe con una sola llamada.
  */
-void sim_world_save(const map_t* m){
-  FILE *fd = fopen("map.pgm","w");
+int sim_world_write_pgm(const map_t* m, const char *filename, int binary){
+  FILE *fd = fopen(filename, binary ? "wb" : "w");
   if(!fd){
-    fprintf(stderr, "Error: Cannot open map.pgm for writing\n");
-    return;
+    fprintf(stderr, "Error: Cannot open %s for writing\n", filename);
+    return -1;
   }
-  fprintf(fd,"P2\n#roomba map\n%d %d\n%d\n", m->ncol, m->nrow, PGM_EMPTY_VALUE);
+  // P2: hasta 4 caracteres por celda ("255 ") más el salto de línea
+  char *row = malloc((size_t)m->ncol * 4 + 1);
+  if(!row){
+    fclose(fd);
+    return -1;
+  }
+  fprintf(fd, "%s\n#roomba map\n%d %d\n%d\n", binary ? "P5" : "P2",
+          m->ncol, m->nrow, PGM_EMPTY_VALUE);
   for(int i = 0; i < m->nrow; i++){
+    const cell_t *cells = &MAP_CELL(m, i, 0);
+    size_t n = 0;
     for(int j = 0; j < m->ncol; j++){
-      switch(m->cells[i][j]){
-        case WALL: fprintf(fd,"%d ", PGM_WALL_VALUE); break;
-        case EMPTY: fprintf(fd,"%d ", PGM_EMPTY_VALUE); break;
-        case 'B': fprintf(fd,"%d ", PGM_BASE_VALUE); break;
-        default: fprintf(fd,"%d ", m->cells[i][j]-DIGIT_CHAR_BASE);
+      int v = cell_pgm_value(cells[j]);
+      if(binary){
+        row[n++] = (char)v;
+        continue;
       }
+      if(v >= 100) row[n++] = (char)('0' + v / 100);
+      if(v >= 10) row[n++] = (char)('0' + v / 10 % 10);
+      row[n++] = (char)('0' + v % 10);
+      row[n++] = ' ';
     }
-    fprintf(fd,"\n");
+    if(!binary) row[n++] = '\n';
+    fwrite(row, 1, n, fd);
   }
-  fclose(fd);
+  free(row);
+  int rc = ferror(fd) ? -1 : 0;
+  if(fclose(fd) != 0) rc = -1;
+  return rc;
+}
+
+/**
+ * @brief Guarda el mapa actual en formato PGM
+ * @param m Puntero al mapa
+ * 
+ * Genera un archivo map.pgm (P2) en el directorio actual con el estado
+ * del mapa: obstáculos (128), celdas vacías (255), base (0),
+ * y suciedad (1-MAXDIRT).
+ */
+void sim_world_save(const map_t* m){
+  sim_world_write_pgm(m, "map.pgm", 0);
 }
 
 /**
@@ -132,7 +308,7 @@ void sim_world_save(const map_t* m){
 int sim_world_is_wall(const map_t* m, int y, int x){
   if(y < 0 || y >= m->nrow || x < 0 || x >= m->ncol)
     return 1; // Out of bounds treated as wall
-  return m->cells[y][x] == WALL;
+  return (MAP_CELL(m, y, x) & CELL_WALL) != 0;
 }
 
 /**
@@ -145,7 +321,7 @@ int sim_world_is_wall(const map_t* m, int y, int x){
 int sim_world_is_base(const map_t* m, int y, int x){
   if(y < 0 || y >= m->nrow || x < 0 || x >= m->ncol)
     return 0;
-  return m->cells[y][x] == 'B';
+  return (MAP_CELL(m, y, x) & CELL_BASE) != 0;
 }
 
 /**
@@ -158,9 +334,7 @@ int sim_world_is_base(const map_t* m, int y, int x){
 int sim_world_cell_dirt(const map_t* m, int y, int x){
   if(y < 0 || y >= m->nrow || x < 0 || x >= m->ncol)
     return 0;
-  char c = m->cells[y][x];
-  if(c == 'B' || c == WALL || c == EMPTY) return 0;
-  return c - DIGIT_CHAR_BASE;
+  return CELL_DIRT(MAP_CELL(m, y, x));
 }
 
 /**
@@ -173,8 +347,10 @@ int sim_world_cell_dirt(const map_t* m, int y, int x){
 void sim_world_set_cell_dirt(map_t* m, int y, int x, int dirt){
   if(y < 0 || y >= m->nrow || x < 0 || x >= m->ncol)
     return;
-  if(dirt <= 0) m->cells[y][x] = EMPTY;
-  else m->cells[y][x] = (char)(DIGIT_CHAR_BASE + dirt);
+  cell_t *c = &MAP_CELL(m, y, x);
+  if(m->journal)
+    sim_journal_push(m->journal, (size_t)y * m->ncol + x, *c);
+  *c = (cell_t)((*c & ~CELL_DIRT_MASK) | dirt_bits(dirt));
 }
 
 /**
@@ -193,6 +369,102 @@ int sim_world_clean_cell(map_t* m, int y, int x){
   return d;
 }
 
+/* ============================================================================
+ * DIARIO DE CAMBIOS
+ * ============================================================================ */
+
+/**
+ * @brief Añade un cambio a un diario
+ * @param j Diario activo
+ * @param idx Índice row-major de la celda
+ * @param old Valor anterior de la celda
+ *
+ * Si no hay memoria el diario se marca como fallido (j->failed).
+ */
+void sim_journal_push(journal_t *j, size_t idx, cell_t old){
+  if(j->len == j->cap){
+    size_t cap = j->cap ? 2 * j->cap : 1024;
+    journal_entry_t *e = realloc(j->entries, cap * sizeof(*e));
+    if(!e){
+      j->failed = 1;
+      return;
+    }
+    j->entries = e;
+    j->cap = cap;
+  }
+  j->entries[j->len].idx = (uint32_t)idx;
+  j->entries[j->len].old = old;
+  j->len++;
+}
+
+/**
+ * @brief Libera un diario y lo desactiva
+ * @param j Diario
+ *
+ * Cambia la generación para que las instantáneas anteriores dejen de ser
+ * válidas.
+ */
+void sim_journal_reset(journal_t *j){
+  free(j->entries);
+  j->entries = NULL;
+  j->len = j->cap = 0;
+  j->active = 0;
+  j->failed = 0;
+  j->gen++;
+}
+
+/* ============================================================================
+ * GENERADOR PSEUDOALEATORIO
+ * ============================================================================ */
+
+/**
+ * @brief Inicializa un generador PCG32
+ * @param rng Generador
+ * @param seed Semilla
+ * @param stream Flujo (SIM_RNG_*); flujos distintos son independientes
+ */
+void sim_rng_seed(sim_rng_t *rng, uint64_t seed, uint64_t stream){
+  rng->state = 0;
+  rng->inc = (stream << 1) | 1u;
+  sim_rng_next(rng);
+  rng->state += seed;
+  sim_rng_next(rng);
+}
+
+/**
+ * @brief Siguiente número de 32 bits (PCG-XSH-RR)
+ * @param rng Generador
+ * @return Valor uniforme en [0, 2^32)
+ */
+uint32_t sim_rng_next(sim_rng_t *rng){
+  uint64_t old = rng->state;
+  rng->state = old * 6364136223846793005ULL + rng->inc;
+  uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+  uint32_t rot = (uint32_t)(old >> 59);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+/**
+ * @brief Entero uniforme en [0, n)
+ * @param rng Generador
+ * @param n Límite superior (> 0)
+ * @return Valor en [0, n)
+ *
+ * Escala el valor de 32 bits en lugar de usar el módulo (sin división).
+ */
+int sim_rng_below(sim_rng_t *rng, int n){
+  return (int)(((uint64_t)sim_rng_next(rng) * (uint32_t)n) >> 32);
+}
+
+/**
+ * @brief Real uniforme en [0, 1)
+ * @param rng Generador
+ * @return Valor en [0, 1)
+ */
+float sim_rng_unit(sim_rng_t *rng){
+  return (sim_rng_next(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
 /* ============================================================================
  * GENERACIÓN DE MAPAS ALEATORIOS
  * ============================================================================ */
@@ -200,41 +472,44 @@ int sim_world_clean_cell(map_t* m, int y, int x){
 /**
  * @brief Crea un muro vertical aleatorio
  * @param m Puntero al mapa
+ * @param rng Generador pseudoaleatorio
  */
-static void create_vertical_wall(map_t* m){
+static void create_vertical_wall(map_t* m, sim_rng_t *rng){
   // Longitud máxima que cabe sin tocar paredes (dejando margen superior e inferior)
   int max_len = m->nrow - 2*BORDER_MARGIN - 2;
-  int len = rand()%(max_len/2) + max_len/4;  // Entre 1/4 y 3/4 del espacio disponible
-  int init = rand()%(m->nrow - len - 2*BORDER_MARGIN) + BORDER_MARGIN;
-  int col = rand()%(m->ncol-2*BORDER_MARGIN-1)+BORDER_MARGIN;
+  int len = sim_rng_below(rng, max_len/2) + max_len/4;  // Entre 1/4 y 3/4 del espacio disponible
+  int init = sim_rng_below(rng, m->nrow - len - 2*BORDER_MARGIN) + BORDER_MARGIN;
+  int col = sim_rng_below(rng, m->ncol-2*BORDER_MARGIN-1)+BORDER_MARGIN;
   for(int i = 0; i < len; i++)
-    m->cells[init + i][col] = WALL;
+    MAP_CELL(m, init + i, col) = CELL_WALL;
 }
 
 /**
  * @brief Crea un muro horizontal aleatorio
  * @param m Puntero al mapa
+ * @param rng Generador pseudoaleatorio
  */
-static void create_horiz_wall(map_t* m){
+static void create_horiz_wall(map_t* m, sim_rng_t *rng){
   // Longitud máxima que cabe sin tocar paredes (dejando margen izquierdo y derecho)
   int max_len = m->ncol - 2*BORDER_MARGIN - 2;
-  int len = rand()%(max_len/2) + max_len/4;  // Entre 1/4 y 3/4 del espacio disponible
-  int init = rand()%(m->ncol - len - 2*BORDER_MARGIN) + BORDER_MARGIN;
-  int row = rand()%(m->nrow-2*BORDER_MARGIN-1)+BORDER_MARGIN;
+  int len = sim_rng_below(rng, max_len/2) + max_len/4;  // Entre 1/4 y 3/4 del espacio disponible
+  int init = sim_rng_below(rng, m->ncol - len - 2*BORDER_MARGIN) + BORDER_MARGIN;
+  int row = sim_rng_below(rng, m->nrow-2*BORDER_MARGIN-1)+BORDER_MARGIN;
   for(int i = 0; i < len; i++)
-    m->cells[row][init + i] = WALL;
+    MAP_CELL(m, row, init + i) = CELL_WALL;
 }
 
 /**
  * @brief Crea obstáculos aleatorios dispersos
  * @param m Puntero al mapa
  * @param prop Proporción de celdas que serán obstáculos (0.0 a 1.0)
+ * @param rng Generador pseudoaleatorio
  */
-static void create_random_obstacles(map_t* m, float prop){
-  for(int i = BORDER_MARGIN; i < WORLDSIZE-BORDER_MARGIN; i++)
-    for(int j = BORDER_MARGIN; j < WORLDSIZE-BORDER_MARGIN; j++)
-      if(rand()/(float)RAND_MAX < prop){
-        m->cells[i][j] = WALL;
+static void create_random_obstacles(map_t* m, float prop, sim_rng_t *rng){
+  for(int i = BORDER_MARGIN; i < m->nrow-BORDER_MARGIN; i++)
+    for(int j = BORDER_MARGIN; j < m->ncol-BORDER_MARGIN; j++)
+      if(sim_rng_unit(rng) < prop){
+        MAP_CELL(m, i, j) = CELL_WALL;
       }
 }
 
@@ -243,13 +518,13 @@ static void create_random_obstacles(map_t* m, float prop){
  * @param m Puntero al mapa
  * @param nrow Número de filas
  * @param ncol Número de columnas
+ * @return 0 si OK, -1 si no se pudo reservar el mapa
  */
-static void init_empty_world(map_t* m, int nrow,int ncol){
-  m->nrow = nrow;
-  m->ncol = ncol;
-  for(int i = 0; i < WORLDSIZE; i++)
-    for(int j = 0; j < WORLDSIZE; j++)
-      m->cells[i][j] = EMPTY;
+static int init_empty_world(map_t* m, int nrow,int ncol){
+  if(sim_world_alloc(m, nrow, ncol) != 0)
+    return -1;
+  memset(m->cells, CELL_EMPTY, (size_t)nrow * ncol);
+  return 0;
 }
 
 /**
@@ -258,12 +533,12 @@ static void init_empty_world(map_t* m, int nrow,int ncol){
  */
 static void add_border_walls(map_t* m){
   for(int i = 0; i < m->nrow; i++){
-    m->cells[i][0] = WALL;
-    m->cells[i][m->ncol-1] = WALL;
+    MAP_CELL(m, i, 0) = CELL_WALL;
+    MAP_CELL(m, i, m->ncol-1) = CELL_WALL;
   }
   for(int i = 0; i < m->ncol; i++){
-    m->cells[0][i] = WALL;
-    m->cells[m->nrow-1][i] = WALL;
+    MAP_CELL(m, 0, i) = CELL_WALL;
+    MAP_CELL(m, m->nrow-1, i) = CELL_WALL;
   }
 }
 
@@ -271,49 +546,51 @@ static void add_border_walls(map_t* m){
  * @brief Añade obstáculos al mapa según densidad
  * @param m Puntero al mapa
  * @param nobs Densidad de obstáculos (>1 = número de muros, <1 = proporción)
+ * @param rng Generador pseudoaleatorio
  */
-static void add_obstacles(map_t* m, float nobs){
+static void add_obstacles(map_t* m, float nobs, sim_rng_t *rng){
   if(nobs >= 1){
     int numobs = (int)nobs;
     // Decidir orientación una sola vez: todos verticales o todos horizontales
-    int vertical = rand()%2;
+    int vertical = sim_rng_below(rng, 2);
     while(numobs-- > 0){
-      if(vertical) create_vertical_wall(m);
-      else create_horiz_wall(m);
+      if(vertical) create_vertical_wall(m, rng);
+      else create_horiz_wall(m, rng);
     }
   } else if(nobs > 0) {
-    create_random_obstacles(m, nobs);
+    create_random_obstacles(m, nobs, rng);
   }
 }
 
 /**
  * @brief Coloca la base aleatoriamente en una pared del mapa
  * @param m Puntero al mapa
+ * @param rng Generador pseudoaleatorio
  * 
  * Selecciona aleatoriamente una pared (norte, sur, este u oeste) y
  * coloca la base en una posición aleatoria de esa pared (excluyendo esquinas).
  */
-static void place_base_randomly(map_t* m){
+static void place_base_randomly(map_t* m, sim_rng_t *rng){
   // Seleccionar una pared aleatoria: 0=Norte, 1=Sur, 2=Este, 3=Oeste
-  int wall = rand() % 4;
+  int wall = sim_rng_below(rng, 4);
   int x, y;
   
   switch(wall){
     case 0: // Pared Norte (y=1)
       y = 1;
-      x = rand() % (m->ncol - 4) + 2;  // Evitar esquinas
+      x = sim_rng_below(rng, m->ncol - 4) + 2;  // Evitar esquinas
       break;
     case 1: // Pared Sur (y=nrow-2)
       y = m->nrow - 2;
-      x = rand() % (m->ncol - 4) + 2;
+      x = sim_rng_below(rng, m->ncol - 4) + 2;
       break;
     case 2: // Pared Este (x=ncol-2)
       x = m->ncol - 2;
-      y = rand() % (m->nrow - 4) + 2;  // Evitar esquinas
+      y = sim_rng_below(rng, m->nrow - 4) + 2;  // Evitar esquinas
       break;
     case 3: // Pared Oeste (x=1)
       x = 1;
-      y = rand() % (m->nrow - 4) + 2;
+      y = sim_rng_below(rng, m->nrow - 4) + 2;
       break;
     default:
       x = 1;
@@ -327,19 +604,16 @@ static void place_base_randomly(map_t* m){
  * @brief Coloca celdas sucias aleatoriamente en el mapa
  * @param m Puntero al mapa
  * @param num_dirty Número de celdas a ensuciar
+ * @param rng Generador pseudoaleatorio
  */
-static void place_dirt(map_t* m, int num_dirty){
-  m->ndirt = num_dirty;
+static void place_dirt(map_t* m, int num_dirty, sim_rng_t *rng){
   for(int i = 0; i < num_dirty; i++){
     int row, col;
     do{
-      row = rand()%(m->nrow-2) + 1;
-      col = rand()%(m->ncol-2) + 1;
-    }while(m->cells[row][col] != EMPTY);
-    m->dirt[i].x = col;
-    m->dirt[i].y = row;
-    m->dirt[i].depth = rand()%MAXDIRT + 1;
-    m->cells[row][col] = DIGIT_CHAR_BASE + m->dirt[i].depth;
+      row = sim_rng_below(rng, m->nrow-2) + 1;
+      col = sim_rng_below(rng, m->ncol-2) + 1;
+    }while(MAP_CELL(m, row, col) != CELL_EMPTY);
+    MAP_CELL(m, row, col) = dirt_bits(sim_rng_below(rng, MAXDIRT) + 1);
   }
 }
 
@@ -350,16 +624,18 @@ static void place_dirt(map_t* m, int num_dirty){
  * @param ncol Número de columnas
  * @param num_dirty Número de celdas sucias
  * @param nobs Densidad de obstáculos
+ * @param rng Generador pseudoaleatorio
  * @return 0 si OK, -1 si dimensiones inválidas
  */
-int sim_world_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs){
-  if(nrow > WORLDSIZE || ncol > WORLDSIZE)
+int sim_world_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs,
+                       sim_rng_t *rng){
+  if(init_empty_world(m, nrow, ncol) != 0)
     return -1;
-  init_empty_world(m, nrow, ncol);
   add_border_walls(m);
-  place_base_randomly(m);  // Coloca la base aleatoriamente en una pared
-  add_obstacles(m, nobs);
-  place_dirt(m, num_dirty);
+  place_base_randomly(m, rng);  // Coloca la base aleatoriamente en una pared
+  add_obstacles(m, nobs, rng);
+  place_dirt(m, num_dirty, rng);
+  m->hash = sim_world_hash(m);
   return 0;
 }
 
@@ -368,25 +644,113 @@ int sim_world_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs){
  * ============================================================================ */
 
 /**
- * @brief Lee la cabecera de un archivo PGM
- * @param fd File descriptor abierto
+ * @brief Cursor sobre el contenido de un archivo PGM en memoria
+ */
+typedef struct {
+  const unsigned char *p;         ///< Posición actual
+  const unsigned char *end;       ///< Fin del buffer
+} pgm_scan_t;
+
+/**
+ * @brief Lee un archivo completo en memoria
+ * @param filename Ruta del archivo
+ * @param len Puntero donde guardar el tamaño leído
+ * @return Buffer reservado con malloc, o NULL si error
+ */
+static unsigned char *read_whole_file(const char *filename, size_t *len){
+  FILE *fd = fopen(filename, "rb");
+  if(!fd){
+    fprintf(stderr, "Error: Cannot open %s for reading\n", filename);
+    return NULL;
+  }
+  unsigned char *buf = NULL;
+  long size = -1;
+  if(fseek(fd, 0, SEEK_END) == 0) size = ftell(fd);
+  if(size >= 0 && fseek(fd, 0, SEEK_SET) == 0)
+    buf = malloc((size_t)size + 1);
+  if(buf && fread(buf, 1, (size_t)size, fd) != (size_t)size){
+    free(buf);
+    buf = NULL;
+  }
+  fclose(fd);
+  if(!buf){
+    fprintf(stderr, "Error: Cannot read %s\n", filename);
+    return NULL;
+  }
+  *len = (size_t)size;
+  return buf;
+}
+
+/**
+ * @brief Avanza el cursor sobre espacios en blanco y comentarios '#'
+ * @param s Cursor
+ */
+static void skip_blanks(pgm_scan_t *s){
+  while(s->p < s->end){
+    unsigned char c = *s->p;
+    if(c == '#'){
+      while(s->p < s->end && *s->p != '\n') s->p++;
+    } else if(c == ' ' || c == '\n' || c == '\r' || c == '\t' ||
+              c == '\v' || c == '\f'){
+      s->p++;
+    } else {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Lee un entero decimal no negativo
+ * @param s Cursor
+ * @param v Puntero donde guardar el valor
+ * @return 0 si OK, -1 si no hay un número en la posición actual
+ */
+static int scan_int(pgm_scan_t *s, int *v){
+  skip_blanks(s);
+  if(s->p >= s->end || *s->p < '0' || *s->p > '9')
+    return -1;
+  int n = 0;
+  while(s->p < s->end && *s->p >= '0' && *s->p <= '9'){
+    if(n < MAX_WORLDSIZE) n = n * 10 + (*s->p - '0');
+    s->p++;
+  }
+  *v = n;
+  return 0;
+}
+
+/**
+ * @brief Lee la cabecera de un archivo PGM (P2 o P5)
+ * @param s Cursor al inicio del archivo
  * @param nrow Puntero donde guardar número de filas
  * @param ncol Puntero donde guardar número de columnas
+ * @param binary Puntero donde guardar si el formato es P5
  * @return 0 si OK, -1 si error
+ *
+ * Deja el cursor al principio de los datos de las celdas.
  */
-static int read_pgm_header(FILE *fd, int *nrow, int *ncol){
-  char line[LINE_BUFFER_SIZE];
-  int aux;
-  
-  (void)fgets(line, LINE_BUFFER_SIZE, fd);  // P2
-  (void)fgets(line, LINE_BUFFER_SIZE, fd);  // comment
-  (void)fscanf(fd, "%d%d", ncol, nrow);
-  (void)fscanf(fd, "%d", &aux);
-  
-  if(*nrow > WORLDSIZE || *ncol > WORLDSIZE){
-    fprintf(stderr, "Error: Map size (%dx%d) exceeds WORLDSIZE\n", *nrow, *ncol);
+static int read_pgm_header(pgm_scan_t *s, int *nrow, int *ncol, int *binary){
+  int maxval;
+  if(s->end - s->p < 2 || s->p[0] != 'P' || (s->p[1] != '2' && s->p[1] != '5')){
+    fprintf(stderr, "Error: Not a P2/P5 PGM file\n");
     return -1;
   }
+  *binary = s->p[1] == '5';
+  s->p += 2;
+  if(scan_int(s, ncol) != 0 || scan_int(s, nrow) != 0 || scan_int(s, &maxval) != 0){
+    fprintf(stderr, "Error: Invalid PGM header\n");
+    return -1;
+  }
+  if(*binary){
+    if(maxval > 255){
+      fprintf(stderr, "Error: 16-bit PGM files are not supported\n");
+      return -1;
+    }
+    if(s->p >= s->end){
+      fprintf(stderr, "Error: Truncated PGM data\n");
+      return -1;
+    }
+    s->p++;  // Un único separador antes de los datos binarios
+  }
   return 0;
 }
 
@@ -396,84 +760,209 @@ static int read_pgm_header(FILE *fd, int *nrow, int *ncol){
  * @param cell Valor de gris de la celda
  * @param i Fila
  * @param j Columna
- * @param dc Puntero al contador de celdas sucias
  */
-static void process_cell(map_t *m, int cell, int i, int j, int *dc){
+static void process_cell(map_t *m, int cell, int i, int j){
   switch(cell){
     case PGM_WALL_VALUE: 
-      m->cells[i][j] = WALL; 
+      MAP_CELL(m, i, j) = CELL_WALL; 
       break;
     case PGM_EMPTY_VALUE: 
-      m->cells[i][j] = EMPTY; 
+      MAP_CELL(m, i, j) = CELL_EMPTY; 
       break;
     case PGM_BASE_VALUE: 
       sim_world_put_base(m, j, i); 
       break;
     default:
-      m->dirt[*dc].x = j;
-      m->dirt[*dc].y = i;
-      m->dirt[*dc].depth = cell;
-      (*dc)++;
-      m->cells[i][j] = cell + DIGIT_CHAR_BASE;
-      m->ndirt++;
+      MAP_CELL(m, i, j) = dirt_bits(cell);
       break;
   }
 }
 
 /**
- * @brief Lee y parsea todas las celdas del mapa desde el archivo
- * @param fd File descriptor abierto
+ * @brief Decodifica todas las celdas del mapa desde el buffer
+ * @param s Cursor al inicio de los datos
  * @param m Puntero al mapa donde guardar los datos
- * @return 0 si OK
+ * @param binary 1 si los datos son P5 (un byte por celda)
+ * @return 0 si OK, -1 si faltan datos
  */
-static int parse_map_cells(FILE *fd, map_t *m){
-  char line[LINE_BUFFER_SIZE];
-  int dc = 0;
-  
+static int parse_map_cells(pgm_scan_t *s, map_t *m, int binary){
+  if(binary && s->end - s->p < (ptrdiff_t)m->nrow * m->ncol){
+    fprintf(stderr, "Error: Truncated PGM data\n");
+    return -1;
+  }
   for(int i = 0; i < m->nrow; i++){
     for(int j = 0; j < m->ncol; j++){
       int cell;
-      (void)fscanf(fd, "%d", &cell);
-      process_cell(m, cell, i, j, &dc);
+      if(binary){
+        cell = *s->p++;
+      } else if(scan_int(s, &cell) != 0){
+        fprintf(stderr, "Error: Truncated PGM data\n");
+        return -1;
+      }
+      process_cell(m, cell, i, j);
     }
-    (void)fgets(line, LINE_BUFFER_SIZE, fd);
   }
   return 0;
 }
 
 /**
- * @brief Carga un mapa desde un archivo PGM
+ * @brief Parsea un archivo PGM sobre un mapa, sin mensajes de progreso
  * @param m Puntero al mapa
  * @param filename Ruta del archivo PGM
  * @return 0 si OK, -1 si error
- * 
- * Lee un archivo en formato PGM (P2) con el mapa de obstáculos,
- * suciedad y base. Actualiza la estructura del mapa con los datos.
+ *
+ * Lee un archivo en formato PGM, texto (P2) o binario (P5), con el mapa
+ * de obstáculos, suciedad y base. El archivo se lee de una vez en memoria
+ * y se decodifica sin pasar por stdio.
  */
-int sim_world_load(map_t* m, char *filename){
-  int nrow, ncol;
+static int parse_map_file(map_t* m, const char *filename){
+  int nrow, ncol, binary;
+  size_t len;
   
-  DEBUG_PRINT("Loading map %s\n", filename);
-  FILE *fd = fopen(filename, "r");
-  if(!fd){
-    fprintf(stderr, "Error: Cannot open %s for reading\n", filename);
+  unsigned char *buf = read_whole_file(filename, &len);
+  if(!buf)
     return -1;
-  }
   
-  m->ndirt = 0;
+  pgm_scan_t scan = { buf, buf + len };
   m->base_x = -1;
   m->base_y = -1;
-  if(read_pgm_header(fd, &nrow, &ncol) != 0){
-    fclose(fd);
+  int rc = -1;
+  if(read_pgm_header(&scan, &nrow, &ncol, &binary) == 0 &&
+     sim_world_alloc(m, nrow, ncol) == 0)
+    rc = parse_map_cells(&scan, m, binary);
+  free(buf);
+  if(rc != 0)
     return -1;
-  }
-  m->nrow = nrow;
-  m->ncol = ncol;  
-  parse_map_cells(fd, m);
-  fclose(fd);  
-  if(filename)
-    snprintf(m->name, sizeof(m->name), "%s", filename);
-  else
-    m->name[0] = '\0';
+  m->hash = sim_world_hash(m);
+  snprintf(m->name, sizeof(m->name), "%s", filename);
   return 0;
 }
+
+/**
+ * @brief Carga un mapa desde un archivo PGM
+ * @param m Puntero al mapa
+ * @param filename Ruta del archivo PGM
+ * @return 0 si OK, -1 si error
+ * 
+ * Actualiza la estructura del mapa con los datos del archivo (ver
+ * parse_map_file()).
+ */
+int sim_world_load(map_t* m, char *filename){
+  DEBUG_PRINT("Loading map %s\n", filename);
+  return parse_map_file(m, filename);
+}
+
+/* ============================================================================
+ * CACHÉ DE MAPAS
+ * ============================================================================ */
+
+/**
+ * @brief Entrada de la caché: plantilla inmutable de un mapa ya parseado
+ */
+typedef struct {
+  char path[256];                 ///< Ruta con la que se cargó
+  time_t mtime;                   ///< Fecha de modificación del archivo
+  off_t size;                     ///< Tamaño del archivo
+  ino_t ino;                      ///< Nodo del archivo
+  map_t tmpl;                     ///< Mapa parseado (no se modifica)
+} map_cache_entry_t;
+
+static map_cache_entry_t map_cache[MAP_CACHE_SIZE];
+static int map_cache_next = 0;    ///< Siguiente entrada a reemplazar
+
+/**
+ * @brief Copia un mapa sobre otro reutilizando su memoria
+ * @param dst Mapa destino
+ * @param src Mapa origen
+ * @return 0 si OK, -1 si no hay memoria
+ *
+ * Las celdas se copian con un único memcpy; el índice de suciedad
+ * del destino se descarta.
+ */
+int sim_world_copy(map_t* dst, const map_t* src){
+  if(sim_world_alloc(dst, src->nrow, src->ncol) != 0)
+    return -1;
+  memcpy(dst->cells, src->cells, (size_t)src->nrow * src->ncol);
+  dst->base_x = src->base_x;
+  dst->base_y = src->base_y;
+  dst->hash = src->hash;
+  snprintf(dst->name, sizeof(dst->name), "%s", src->name);
+  return 0;
+}
+
+/**
+ * @brief Busca o carga la plantilla de un mapa en la caché
+ * @param filename Ruta del archivo PGM
+ * @return Plantilla del mapa, o NULL si no se pudo cargar
+ *
+ * Una entrada es válida mientras el archivo conserve la fecha de
+ * modificación, el tamaño y el nodo con que se parseó.
+ */
+static const map_t *cache_lookup(const char *filename){
+  struct stat st;
+  if(stat(filename, &st) != 0 || strlen(filename) >= sizeof(map_cache[0].path))
+    return NULL;
+  map_cache_entry_t *e = NULL;
+  for(int i = 0; i < MAP_CACHE_SIZE; i++){
+    if(map_cache[i].tmpl.cells && strcmp(map_cache[i].path, filename) == 0){
+      e = &map_cache[i];
+      break;
+    }
+  }
+  if(e && e->mtime == st.st_mtime && e->size == st.st_size && e->ino == st.st_ino)
+    return &e->tmpl;
+  if(!e){
+    e = &map_cache[map_cache_next];
+    map_cache_next = (map_cache_next + 1) % MAP_CACHE_SIZE;
+  }
+  if(parse_map_file(&e->tmpl, filename) != 0){
+    sim_world_free(&e->tmpl);
+    return NULL;
+  }
+  snprintf(e->path, sizeof(e->path), "%s", filename);
+  e->mtime = st.st_mtime;
+  e->size = st.st_size;
+  e->ino = st.st_ino;
+  return &e->tmpl;
+}
+
+/**
+ * @brief Carga un mapa usando la caché de plantillas
+ * @param m Puntero al mapa
+ * @param filename Ruta del archivo PGM
+ * @return 0 si OK, -1 si error
+ *
+ * La primera carga de un archivo lo parsea y guarda una plantilla; las
+ * siguientes solo restauran las celdas desde la plantilla. La caché no
+ * es segura entre hilos.
+ */
+int sim_world_load_cached(map_t* m, const char *filename){
+  DEBUG_PRINT("Loading map %s\n", filename);
+  const map_t *tmpl = cache_lookup(filename);
+  if(!tmpl)
+    return parse_map_file(m, filename);
+  return sim_world_copy(m, tmpl);
+}
+
+/**
+ * @brief Parsea un mapa y lo deja en la caché sin cargarlo
+ * @param filename Ruta del archivo PGM
+ * @return 0 si OK, -1 si error
+ *
+ * No escribe nada en stdout: el runner precarga así todos los mapas
+ * en el proceso del equipo antes de la primera ronda.
+ */
+int sim_world_cache_preload(const char *filename){
+  return cache_lookup(filename) ? 0 : -1;
+}
+
+/**
+ * @brief Libera todas las plantillas de la caché
+ */
+void sim_world_cache_clear(void){
+  for(int i = 0; i < MAP_CACHE_SIZE; i++){
+    sim_world_free(&map_cache[i].tmpl);
+    map_cache[i].path[0] = '\0';
+  }
+  map_cache_next = 0;
+}
@@ -25,6 +25,9 @@
 /**
  * @brief Crea un nuevo mapa vacío
  * @return Puntero al mapa creado, o NULL si hay error de memoria
+ *
+ * Solo reserva la cabecera (map_footprint() devuelve sizeof(map_t));
+ * las celdas se reservan al generar o cargar el mapa.
  */
 map_t* map_create(void){
     map_t* m = (map_t*)calloc(1, sizeof(map_t));
@@ -35,9 +38,25 @@ map_t* map_create(void){
 /**
  * @brief Libera la memoria de un mapa
  * @param m Puntero al mapa a destruir
+ *
+ * Libera la cabecera, las celdas y el índice de suciedad, es decir,
+ * los map_footprint() bytes que ocupaba el mapa.
  */
 void map_destroy(map_t* m){
-    if(m) free(m);
+    if(!m) return;
+    sim_world_free(m);
+    free(m);
+}
+
+
+/**
+ * @brief Memoria ocupada por un mapa
+ * @param m Puntero al mapa
+ * @return Bytes ocupados (0 si m es NULL)
+ */
+size_t map_footprint(const map_t* m){
+    if(!m) return 0;
+    return sim_world_footprint(m);
 }
 
 
@@ -51,8 +70,11 @@ void map_destroy(map_t* m){
  * @return 0 si OK, -1 si error
  */
 int map_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs){
+    sim_rng_t rng;
     if(!m) return -1;
-    return sim_world_generate(m, nrow, ncol, num_dirty, nobs);
+    // La semilla sale de rand(): srand() sigue controlando la generación
+    sim_rng_seed(&rng, ((uint64_t)rand() << 31) ^ (uint64_t)rand(), SIM_RNG_WORLD);
+    return sim_world_generate(m, nrow, ncol, num_dirty, nobs, &rng);
 }
 
 
@@ -64,25 +86,19 @@ int map_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs){
  */
 int map_save(const map_t* m, const char* filename){
     if(!m || !filename) return -1;
-    FILE *fd = fopen(filename, "w");
-    if(!fd){
-        fprintf(stderr, "Error: Cannot create %s\n", filename);
-        return -1;
-    }
-    fprintf(fd, "P2\n#roomba map\n%d %d\n%d\n", m->ncol, m->nrow, 255);
-    for(int i = 0; i < m->nrow; i++){
-        for(int j = 0; j < m->ncol; j++){
-            switch(m->cells[i][j]){
-                case WALL: fprintf(fd, "%d ", 128); break;
-                case EMPTY: fprintf(fd, "%d ", 255); break;
-                case 'B': fprintf(fd, "%d ", 0); break;
-                default: fprintf(fd, "%d ", m->cells[i][j] - DIGIT_CHAR_BASE);
-            }
-        }
-        fprintf(fd, "\n");
-    }
-    fclose(fd);
-    return 0;
+    return sim_world_write_pgm(m, filename, 0);
+}
+
+
+/**
+ * @brief Guarda un mapa en un archivo PGM binario (P5)
+ * @param m Puntero al mapa a guardar
+ * @param filename Nombre del archivo destino
+ * @return 0 si OK, -1 si error
+ */
+int map_save_binary(const map_t* m, const char* filename){
+    if(!m || !filename) return -1;
+    return sim_world_write_pgm(m, filename, 1);
 }
 
 
@@ -107,7 +123,7 @@ void map_display(const map_t* m){
     printf("\n");
     for(int i = 0; i < m->nrow; i++){
         for(int j = 0; j < m->ncol; j++){
-            char c = m->cells[i][j];
+            char c = sim_world_cell_char(MAP_CELL(m, i, j));
             switch(c){
                 case WALL:  printf("#"); break;
                 case EMPTY: printf(" "); break;
@@ -9,11 +9,13 @@
  * mapas sin exponer detalles internos del simulador.
  */
 
+#include <stddef.h>
+
 /* ============================================================================
  * CONSTANTES PÚBLICAS
  * ============================================================================ */
 
-#define WORLDSIZE 50              ///< Tamaño máximo del mundo (filas y columnas)
+#define WORLDSIZE 50              ///< Tamaño por defecto del mundo (filas y columnas)
 
 /* ============================================================================
  * TIPOS OPACOS
@@ -45,17 +47,27 @@ map_t* map_create(void);
  */
 void map_destroy(map_t* m);
 
+/**
+ * @brief Memoria ocupada por un mapa
+ * @param m Puntero al mapa
+ * @return Bytes ocupados: cabecera más un byte por celda
+ *
+ * Un mapa de 50x50 ocupa unos 2,8 KB.
+ */
+size_t map_footprint(const map_t* m);
+
 /**
  * @brief Genera un mapa aleatorio completo
  * @param m Puntero al mapa
- * @param nrow Número de filas (máximo WORLDSIZE)
- * @param ncol Número de columnas (máximo WORLDSIZE)
+ * @param nrow Número de filas
+ * @param ncol Número de columnas
  * @param num_dirty Número de celdas con suciedad
  * @param nobs Densidad de obstáculos:
  *             - >= 1: número de muros (todos de la misma orientación)
  *             - < 1: densidad de obstáculos dispersos (0.0 a 1.0)
  * @return 0 si OK, -1 si error
  * 
+ * Las celdas se reservan en memoria dinámica con el tamaño pedido.
  * Genera un mapa completo con:
  * - Bordes perimetrales
  * - Base aleatoria en una pared (orientación perpendicular)
@@ -78,10 +90,21 @@ int map_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs);
  */
 int map_save(const map_t* m, const char* filename);
 
+/**
+ * @brief Guarda el mapa en formato PGM binario (P5)
+ * @param m Puntero al mapa
+ * @param filename Nombre del archivo
+ * @return 0 si OK, -1 si error
+ *
+ * Mismos valores que map_save(), un byte por celda. Es el formato más
+ * rápido de cargar para mapas grandes.
+ */
+int map_save_binary(const map_t* m, const char* filename);
+
 /**
  * @brief Carga un mapa desde un archivo PGM
  * @param m Puntero al mapa
- * @param filename Nombre del archivo a cargar
+ * @param filename Nombre del archivo a cargar (P2 o P5)
  * @return 0 si OK, -1 si error
  */
 int map_load(map_t* m, const char* filename);
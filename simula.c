@@ -17,52 +17,112 @@
 #include <time.h>
 #include <unistd.h>
 
-#define MIN_BATTERY_THRESHOLD                                                  \
-  0.1f ///< Umbral mínimo de batería para detener simulación
 #define MAX_OBSTACLE_DENSITY 0.05f ///< Densidad máxima de obstáculos aleatorios
 #define DEFAULT_DIRT_CELLS 100     ///< Número por defecto de celdas sucias
 #define MAX_EXEC_TIME 100000       ///< Tiempo máximo de ejecución (ticks)
 
 /* ============================================================================
- * ESTADO GLOBAL
+ * CONTEXTOS DE SIMULACIÓN
  * ============================================================================
  */
 
 /**
- * @var map_t map
- * @brief Mapa global de la simulación
+ * @var sim_ctx_t default_ctx
+ * @brief Contexto por defecto usado por la API pública de simula.h
  */
-map_t map = {0}; ///< Mapa del mundo
+static sim_ctx_t default_ctx;
 /**
- * @var robot_t r
- * @brief Estado interno del robot
+ * @var sim_ctx_t* current_ctx
+ * @brief Contexto activo del hilo (NULL = contexto por defecto)
  */
-robot_t r; ///< Estado interno del robot
+static _Thread_local sim_ctx_t *current_ctx = NULL;
 /**
- * @var sensor_t* hist
- * @brief Historial de posiciones del robot (dinámico)
+ * @var int batch_mode
+ * @brief En modo batch configure() no registra manejadores atexit()
  */
-sensor_t *hist = NULL; ///< Historial de posiciones (memoria dinámica)
+static int batch_mode = 0;
+
+/**
+ * @brief Crea un contexto de simulación vacío
+ * @return Puntero al contexto, o NULL si no hay memoria
+ */
+sim_ctx_t *sim_ctx_create(void) {
+  sim_ctx_t *ctx = (sim_ctx_t *)calloc(1, sizeof(sim_ctx_t));
+  if (ctx)
+    sim_ctx_seed(ctx, 0);
+  return ctx;
+}
+
+/**
+ * @brief Fija la semilla de un contexto
+ * @param ctx Contexto de simulación
+ * @param seed Semilla
+ *
+ * El mapa/base y rmb_rand() usan flujos distintos de la misma semilla: lo
+ * que haga el comportamiento con rmb_rand() no cambia el mapa generado.
+ */
+void sim_ctx_seed(sim_ctx_t *ctx, uint64_t seed) {
+  ctx->seed = seed;
+  sim_rng_seed(&ctx->world_rng, seed, SIM_RNG_WORLD);
+  sim_rng_seed(&ctx->robot_rng, seed, SIM_RNG_ROBOT);
+}
+
+/**
+ * @brief Libera el mapa y la matriz de visitadas de un contexto
+ * @param ctx Contexto de simulación
+ */
+static void release_world(sim_ctx_t *ctx) {
+  sim_snapshot_drop(ctx);
+  sim_world_free(&ctx->map);
+  free(ctx->visited);
+  free(ctx->visits);
+  ctx->visited = NULL;
+  ctx->visits = NULL;
+  ctx->visited_len = 0;
+  ctx->visit_epoch = 0;
+}
+
 /**
- * @var config_t config
- * @brief Configuración de la simulación
+ * @brief Libera un contexto de simulación, su historial y su mapa
+ * @param ctx Contexto a liberar
  */
-config_t config; ///< Configuración de la simulación
+void sim_ctx_destroy(sim_ctx_t *ctx) {
+  if (!ctx || ctx == &default_ctx)
+    return;
+  if (current_ctx == ctx)
+    current_ctx = NULL;
+  sim_team_destroy(ctx);
+  sim_cycle_destroy(ctx);
+  free(ctx->hist);
+  action_log_free(&ctx->actions);
+  release_world(ctx);
+  free(ctx);
+}
+
 /**
- * @var int timer
- * @brief Contador de ticks de simulación
+ * @brief Devuelve el contexto por defecto
+ * @return Puntero al contexto por defecto
  */
-int timer; ///< Contador de ticks
+sim_ctx_t *sim_ctx_default(void) { return &default_ctx; }
+
 /**
- * @var struct sensor* rob
- * @brief Puntero público a los sensores del robot
+ * @brief Devuelve el contexto activo del hilo actual
+ * @return Contexto activo
  */
-struct sensor *rob = (struct sensor *)&r.sensor; ///< Puntero público a sensores
+sim_ctx_t *sim_ctx_current(void) {
+  return current_ctx ? current_ctx : &default_ctx;
+}
+
 /**
- * @var int sim_should_stop
- * @brief Flag para solicitar la detención de la simulación
+ * @brief Enlaza un contexto como activo
+ * @param ctx Contexto a activar (NULL = contexto por defecto)
+ * @return Contexto activo antes de la llamada
  */
-int sim_should_stop = 0; ///< Flag de detención
+sim_ctx_t *sim_ctx_bind(sim_ctx_t *ctx) {
+  sim_ctx_t *prev = sim_ctx_current();
+  current_ctx = (ctx == &default_ctx) ? NULL : ctx;
+  return prev;
+}
 
 /* ============================================================================
  * CONTROL DE SIMULACIÓN
@@ -71,33 +131,122 @@ int sim_should_stop = 0; ///< Flag de detención
 
 /**
  * @brief Solicita la detención de la simulación
+ * @param ctx Contexto de simulación
  *
- * Establece el flag sim_should_stop para que el bucle principal
+ * Establece el flag should_stop para que el bucle principal
  * termine en la siguiente iteración.
  */
-void sim_request_stop(void) { sim_should_stop = 1; }
+void sim_request_stop(sim_ctx_t *ctx) { ctx->should_stop = 1; }
+
+/* ============================================================================
+ * INSTANTÁNEAS
+ * ============================================================================
+ */
+
+/**
+ * @brief Toma una instantánea del estado de la simulación
+ * @param ctx Contexto de simulación
+ * @param snap Instantánea a rellenar
+ *
+ * Copia el estado pequeño y anota la longitud de los diarios; a partir de
+ * aquí sim_world_set_cell_dirt() y stats_visit_cell() registran lo que
+ * cambian.
+ */
+void sim_snapshot(sim_ctx_t *ctx, sim_snapshot_t *snap) {
+  ctx->cell_journal.active = 1;
+  ctx->visit_journal.active = 1;
+  ctx->map.journal = &ctx->cell_journal;
+
+  snap->cell_mark = ctx->cell_journal.len;
+  snap->visit_mark = ctx->visit_journal.len;
+  snap->gen = ctx->cell_journal.gen;
+  snap->robot = ctx->robot;
+  snap->timer = ctx->timer;
+  snap->should_stop = ctx->should_stop;
+  snap->stats = ctx->stats;
+  snap->world_rng = ctx->world_rng;
+  snap->robot_rng = ctx->robot_rng;
+  snap->base_x = ctx->map.base_x;
+  snap->base_y = ctx->map.base_y;
+}
+
+/**
+ * @brief Vuelve al estado de una instantánea
+ * @param ctx Contexto de simulación
+ * @param snap Instantánea tomada con sim_snapshot() sobre el mismo contexto
+ * @return 0 si OK, -1 si la instantánea ya no es válida
+ *
+ * Recorre los diarios hacia atrás hasta la marca de la instantánea, de modo
+ * que cada celda recupera el valor que tenía al tomarla.
+ */
+int sim_restore(sim_ctx_t *ctx, const sim_snapshot_t *snap) {
+  journal_t *cj = &ctx->cell_journal;
+  journal_t *vj = &ctx->visit_journal;
+  if (!cj->active || snap->gen != cj->gen || cj->failed || vj->failed ||
+      snap->cell_mark > cj->len || snap->visit_mark > vj->len)
+    return -1;
+
+  while (cj->len > snap->cell_mark) {
+    const journal_entry_t *e = &cj->entries[--cj->len];
+    ctx->map.cells[e->idx] = e->old;
+  }
+  while (vj->len > snap->visit_mark) {
+    const journal_entry_t *e = &vj->entries[--vj->len];
+    if (e->old)
+      ctx->visited[e->idx] = 0;
+    if (ctx->visits)
+      ctx->visits[e->idx]--;
+  }
+
+  ctx->robot = snap->robot;
+  ctx->timer = snap->timer;
+  ctx->should_stop = snap->should_stop;
+  ctx->stats = snap->stats;
+  ctx->world_rng = snap->world_rng;
+  ctx->robot_rng = snap->robot_rng;
+  ctx->map.base_x = snap->base_x;
+  ctx->map.base_y = snap->base_y;
+  // Las llamadas vigiladas ya no describen lo que ha pasado
+  sim_cycle_taint(ctx);
+  return 0;
+}
+
+/**
+ * @brief Descarta todas las instantáneas y desactiva el registro de cambios
+ * @param ctx Contexto de simulación
+ */
+void sim_snapshot_drop(sim_ctx_t *ctx) {
+  ctx->map.journal = NULL;
+  sim_journal_reset(&ctx->cell_journal);
+  sim_journal_reset(&ctx->visit_journal);
+  // Una sola generación para ambos diarios (la que comprueba sim_restore)
+  ctx->visit_journal.gen = ctx->cell_journal.gen;
+}
 
 /**
  * @brief Registra un tick en el historial
+ * @param ctx Contexto de simulación
  * @param action Tipo de acción realizada (-1 para no incrementar timer)
  *
  * Guarda el estado actual del robot en el historial y verifica si
  * la batería está por debajo del umbral crítico.
  */
-void sim_log_tick(int action) {
-  if (timer < config.exec_time) {
-    hist[timer].x = rob->x;
-    hist[timer].y = rob->y;
-    hist[timer].heading = rob->heading;
-    hist[timer].bumper = rob->bumper;
-    hist[timer].infrared = rob->infrared;
-    hist[timer].battery = rob->battery;
-
-    if (action != -1)
-      ++timer;
+void sim_log_tick(sim_ctx_t *ctx, int action) {
+  const sensor_t *rob = &ctx->robot.sensor;
+  if (ctx->timer < ctx->config.exec_time) {
+#if SIM_TRACE_LEVEL == SIM_TRACE_FULL
+    ctx->hist[ctx->timer] = *rob;
+#endif
+
+    if (action != -1) {
+      ++ctx->timer;
+      stats_tick(ctx, rob->battery);
+    }
+  }
+  if (rob->battery < MIN_BATTERY_THRESHOLD) {
+    ctx->stats.end = SIM_END_BATTERY;
+    sim_request_stop(ctx);
   }
-  if (rob->battery < MIN_BATTERY_THRESHOLD)
-    sim_request_stop();
 }
 
 /* ============================================================================
@@ -105,32 +254,104 @@ void sim_log_tick(int action) {
  * ============================================================================
  */
 
+#if SIM_TRACE_LEVEL == SIM_TRACE_FULL
 /**
  * @brief Wrapper para guardar el log al finalizar
  *
  * Función registrada con atexit() para asegurar que el log
  * se guarda incluso si el programa termina abruptamente.
+ * Con ROOMBA_LOG=bin se escribe la traza binaria log.bin en lugar de
+ * log.csv (ver tools/log2csv para convertirla), y con ROOMBA_LOG=actions
+ * el registro de acciones actions.bin (ver tools/replay). Con varios
+ * robots solo se escribe log.csv.
  */
 static void _save_log_wrapper(void) {
-  if (!hist)
+  action_log_t *actions = &default_ctx.actions;
+  if (!default_ctx.hist)
     return;
-  save_log(hist, timer);
+  const char *format = getenv("ROOMBA_LOG");
+  if (format && strcmp(format, "bin") == 0)
+    save_trace(default_ctx.hist, default_ctx.timer, default_ctx.map.hash);
+  else if (actions->active && !default_ctx.team) {
+    actions->flags = default_ctx.map.name[0] ? ACTIONS_MAP_FILE : 0;
+    actions->exec_time = default_ctx.config.exec_time;
+    actions->map_hash = default_ctx.map.hash;
+    actions->seed = default_ctx.seed;
+    save_actions(actions);
+  } else
+    save_log(default_ctx.hist, default_ctx.timer);
+}
+#endif
+
+/**
+ * @brief Añade el mapa de calor del contexto por defecto a heatmap.bin
+ * @param ctx Contexto por defecto, con el contador de visitas activo
+ *
+ * Con varios robots suma las visitas de todos; las celdas distintas son
+ * las de la fila fleet de stats.csv.
+ */
+static void _save_heatmap(sim_ctx_t *ctx) {
+  heatmap_t h = {0};
+  snprintf(h.name, sizeof(h.name), "%s", ctx->map.name);
+  h.nrow = ctx->map.nrow;
+  h.ncol = ctx->map.ncol;
+  h.map_hash = ctx->map.hash;
+  h.ticks = (uint32_t)ctx->timer;
+  h.cell_visited = (uint32_t)ctx->stats.cell_visited;
+  h.visits = ctx->visits;
+  if (ctx->team) {
+    struct _stat fleet;
+    h.visits = malloc(ctx->visited_len * sizeof(uint32_t));
+    if (!h.visits) {
+      fprintf(stderr, "Error: Cannot allocate heatmap\n");
+      return;
+    }
+    memcpy(h.visits, ctx->visits, ctx->visited_len * sizeof(uint32_t));
+    for (int k = 1; k < ctx->team->n; k++) {
+      const sim_ctx_t *r = ctx->team->robot[k];
+      for (size_t i = 0; r->visits && i < ctx->visited_len; i++)
+        h.visits[i] += r->visits[i];
+      h.ticks += (uint32_t)r->timer;
+    }
+    sim_team_stats(ctx, &fleet);
+    h.cell_visited = (uint32_t)fleet.cell_visited;
+  }
+  save_heatmap(&h);
+  if (h.visits != ctx->visits)
+    free(h.visits);
 }
 
 /**
  * @brief Wrapper para guardar estadísticas al finalizar
  *
- * Calcula la batería media y guarda las estadísticas finales.
- * Registrada con atexit().
+ * Guarda las estadísticas finales (bat_mean ya está al día, ver
+ * stats_tick()), con ROOMBA_PROFILE=1 latency.csv y con ROOMBA_HEATMAP=1
+ * heatmap.bin. Registrada con atexit(). Con SIM_TRACE_NONE solo escribe
+ * latency.csv y heatmap.bin.
  */
 static void _save_stats_wrapper(void) {
-  if (!hist)
+  sim_ctx_t *ctx = &default_ctx;
+  if (!ctx->config.exec_beh)
+    return;
+  if (ctx->visits)
+    _save_heatmap(ctx);
+  if (ctx->prof.active) {
+    beh_prof_t prof = ctx->prof;
+    for (int k = 1; ctx->team && k < ctx->team->n; k++)
+      prof_merge(&prof, &ctx->team->robot[k]->prof);
+    save_latency(&prof);
+  }
+#if SIM_TRACE_LEVEL >= SIM_TRACE_STATS
+  if (ctx->team) {
+    struct _stat robots[SIM_TEAM_MAX], fleet;
+    for (int k = 0; k < ctx->team->n; k++)
+      robots[k] = *stats_get(ctx->team->robot[k]);
+    sim_team_stats(ctx, &fleet);
+    save_team_stats(robots, ctx->team->n, &fleet);
     return;
-  float sum = 0.0f;
-  for (int i = 0; i < timer; i++)
-    sum += hist[i].battery;
-  stats_set_mean_battery((timer > 0) ? sum / (float)timer : 0.0f);
-  save_stats(stats_get());
+  }
+  save_stats(stats_get(ctx));
+#endif
 }
 
 /**
@@ -140,10 +361,12 @@ static void _save_stats_wrapper(void) {
  * dinámica del historial al finalizar el programa.
  */
 static void _cleanup_hist(void) {
-  if (hist) {
-    free(hist);
-    hist = NULL;
+  if (default_ctx.hist) {
+    free(default_ctx.hist);
+    default_ctx.hist = NULL;
   }
+  action_log_free(&default_ctx.actions);
+  sim_cycle_destroy(&default_ctx);
 }
 
 /* ============================================================================
@@ -152,97 +375,375 @@ static void _cleanup_hist(void) {
  */
 
 /**
- * @brief Configura el simulador antes de ejecutar
+ * @brief Configura un contexto de simulación
+ * @param ctx Contexto a configurar
  * @param start Función de inicialización (puede ser NULL)
  * @param beh Función de comportamiento cíclico (obligatoria)
  * @param stop Función de finalización (puede ser NULL)
  * @param exec_time Tiempo máximo de ejecución en ticks
+ * @return 0 si OK, -1 si error
  *
- * Esta función debe llamarse antes de run(). Reserva memoria para el
- * historial, genera un mapa si no hay uno cargado, y registra las
- * funciones de limpieza.
+ * Reserva memoria para el historial (solo con SIM_TRACE_FULL) y genera
+ * un mapa si el contexto no tiene uno cargado.
  */
-void configure(void (*start)(), void (*beh)(), void (*stop)(), int exec_time) {
+int sim_ctx_configure(sim_ctx_t *ctx, void (*start)(), void (*beh)(),
+                      void (*stop)(), int exec_time) {
   float density;
   if (!beh) {
     fprintf(stderr, "Error: Behavior function cannot be NULL\n");
-    exit(1);
+    return -1;
   }
 
-  // Use clock_gettime for nanosecond precision seeding
-  struct timespec ts;
-  // CLOCK_MONOTONIC is preferred for time intervals, but for seeding
-  // CLOCK_REALTIME or MONOTONIC works as long as it changes rapidly.
-  clock_gettime(CLOCK_MONOTONIC, &ts);
-  srand((unsigned int)(ts.tv_nsec ^ ts.tv_sec));
-
-  config.on_start = start;
-  config.exec_beh = beh;
-  config.on_stop = stop;
+  ctx->config.on_start = start;
+  ctx->config.exec_beh = beh;
+  ctx->config.on_stop = stop;
 #if COMPETITION_MODE
-  config.exec_time = COMPETITION_EXEC_TIME;
+  (void)exec_time;
+  ctx->config.exec_time = COMPETITION_EXEC_TIME;
 #else
   // if exec_time is out of bounds, set a default value
-  config.exec_time = (exec_time > 0 && exec_time <= MAX_EXEC_TIME)
-                         ? exec_time
-                         : WORLDSIZE * WORLDSIZE;
+  ctx->config.exec_time = (exec_time > 0 && exec_time <= MAX_EXEC_TIME)
+                              ? exec_time
+                              : WORLDSIZE * WORLDSIZE;
 #endif
+  ctx->config.stall_limit = SIM_STALL_LIMIT;
 
+#if SIM_TRACE_LEVEL == SIM_TRACE_FULL
   // Reserve memory for history
-  if (hist)
-    free(hist);
-  hist = (sensor_t *)calloc(config.exec_time, sizeof(sensor_t));
-  if (!hist) {
+  free(ctx->hist);
+  ctx->hist = (sensor_t *)calloc(ctx->config.exec_time, sizeof(sensor_t));
+  if (!ctx->hist) {
     fprintf(stderr, "Error: Cannot allocate memory for history\n");
-    exit(1);
+    ctx->config.exec_beh = NULL;
+    return -1;
+  }
+#endif
+
+  // Generar variedad de obstáculos:
+  // 50% de probabilidad: muros (1-4 muros aleatorios)
+  // 50% de probabilidad: obstáculos dispersos (densidad 0-5%)
+  if (sim_rng_below(&ctx->world_rng, 2) == 0) {
+    density = sim_rng_below(&ctx->world_rng, 4) + 1; // 1 a 4 muros
+  } else {
+    density = sim_rng_unit(&ctx->world_rng) * MAX_OBSTACLE_DENSITY; // 0 a 0.05
+  }
+
+  if (ctx->map.name[0] == '\0') {
+    sim_snapshot_drop(ctx);
+    sim_world_generate(&ctx->map, WORLDSIZE, WORLDSIZE, DEFAULT_DIRT_CELLS,
+                       density, &ctx->world_rng);
+    stats_rebuild_from_map(ctx, &ctx->map);
+  }
+  return 0;
+}
+
+/**
+ * @brief Ejecuta la simulación de un contexto
+ * @param ctx Contexto previamente configurado
+ * @return 0 si OK, -1 si el contexto no está configurado
+ *
+ * Llama a on_start una vez y después a exec_beh repetidamente hasta que
+ * se alcance el tiempo límite o se solicite detención. Durante la
+ * ejecución el contexto queda enlazado como activo. Si el contexto tiene
+ * robots añadidos con sim_team_add(), los ejecuta todos (sim_team_run).
+ */
+int sim_ctx_run(sim_ctx_t *ctx) {
+  if (!ctx->config.exec_beh) {
+    fprintf(stderr, "Error: Must call configure() before run()\n");
+    return -1;
+  }
+
+  sim_ctx_t *prev = sim_ctx_bind(ctx);
+  if (ctx->team) {
+    sim_team_run(ctx);
+    sim_ctx_bind(prev);
+    return 0;
+  }
+  ctx->timer = 0;
+  stats_reset_battery(ctx);
+  ctx->should_stop = 0;
+  ctx->stall = 0;
+  ctx->stats.end = SIM_END_TIME;
+  sim_cycle_reset(ctx);
+  if (ctx->config.on_start)
+    ctx->config.on_start();
+  while (!ctx->should_stop && ctx->timer < ctx->config.exec_time)
+    sim_ctx_exec_beh(ctx);
+  sim_ctx_bind(prev);
+  return 0;
+}
+
+/**
+ * @brief Instante actual en nanosegundos
+ * @return Nanosegundos de un reloj monótono
+ *
+ * CLOCK_MONOTONIC_RAW no lo corrige NTP, así que los intervalos cortos no
+ * se estiran ni se encogen durante un ajuste.
+ */
+static uint64_t now_ns(void) {
+  struct timespec ts;
+#ifdef CLOCK_MONOTONIC_RAW
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Activa o desactiva la medida de latencia del comportamiento
+ * @param ctx Contexto de simulación
+ * @param on 1 para medir cada llamada a exec_beh, 0 para no medir
+ */
+void sim_ctx_profile(sim_ctx_t *ctx, int on) {
+  ctx->prof = (beh_prof_t){0};
+  ctx->prof.active = on;
+}
+
+/**
+ * @brief Llama una vez al comportamiento del contexto
+ * @param ctx Contexto enlazado como activo
+ *
+ * Con la medida activa, una llamada es "sin acción" si el robot no hizo
+ * ningún rmb_awake/turn/forward/clean/load.
+ *
+ * Si el comportamiento ha declarado su estado y ha entrado en un ciclo, el
+ * detector repite la llamada en su lugar (y no se mide).
+ *
+ * El vigilante cuenta las llamadas seguidas que no avanzan timer: leer
+ * sensores, rmb_load() fuera de la base o chocar no lo hacen, y un
+ * comportamiento que solo hace eso dejaría el bucle girando para siempre.
+ */
+void sim_ctx_exec_beh(sim_ctx_t *ctx) {
+  beh_prof_t *prof = &ctx->prof;
+  int timer = ctx->timer;
+  if (ctx->cycle && sim_cycle_step(ctx)) {
+    // Llamada repetida por el detector de ciclos
+  } else if (!prof->active) {
+    ctx->config.exec_beh();
+  } else {
+    uint64_t actions = prof->actions;
+    uint64_t t0 = now_ns();
+    ctx->config.exec_beh();
+    prof_record(prof, now_ns() - t0, prof->actions == actions);
+  }
+
+  if (ctx->timer != timer) {
+    ctx->stall = 0;
+  } else if (ctx->config.stall_limit > 0 &&
+             ++ctx->stall >= ctx->config.stall_limit) {
+    fprintf(stderr,
+            "Warning: Behavior made no progress in %d calls, stopping at "
+            "tick %d\n",
+            ctx->stall, ctx->timer);
+    if (ctx->actions.active)
+      action_log_push(&ctx->actions, ACTION_STALL, 0);
+    ctx->stats.end = SIM_END_STALL;
+    sim_request_stop(ctx);
+  }
+}
+
+/**
+ * @brief Comportamiento vacío para configurar un contexto de reproducción
+ */
+static void replay_beh(void) {}
+
+/**
+ * @brief Aplica una acción registrada con su función rmb_ctx_*
+ * @param ctx Contexto de simulación
+ * @param action Código (FWD, TURN, CLEAN, LOAD, ACTION_AWAKE, ACTION_STALL)
+ * @param alpha Ángulo (solo con TURN)
+ * @return 0 si OK, -1 si el código no es válido
+ */
+int sim_apply_action(sim_ctx_t *ctx, int action, float alpha) {
+  int x, y;
+  switch (action) {
+  case ACTION_AWAKE:
+    rmb_ctx_awake(ctx, &x, &y);
+    break;
+  case TURN:
+    rmb_ctx_turn(ctx, alpha);
+    break;
+  case FWD:
+    rmb_ctx_forward(ctx);
+    break;
+  case CLEAN:
+    rmb_ctx_clean(ctx);
+    break;
+  case LOAD:
+    rmb_ctx_load(ctx);
+    break;
+  case ACTION_STALL:
+    ctx->stats.end = SIM_END_STALL;
+    sim_request_stop(ctx);
+    break;
+  default:
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Empieza a registrar las acciones del robot de un contexto
+ * @param ctx Contexto de simulación
+ */
+void sim_ctx_record_actions(sim_ctx_t *ctx) {
+  action_log_free(&ctx->actions);
+  ctx->actions.active = 1;
+}
+
+/**
+ * @brief Reproduce un registro de acciones en un contexto
+ * @param ctx Contexto nuevo (con el mapa ya cargado si ACTIONS_MAP_FILE)
+ * @param log Registro leído con action_log_load()
+ * @return 0 si OK, -1 si el mapa no coincide o el registro está dañado
+ *
+ * Repite los mismos pasos que configure() y run() con la semilla del
+ * registro, de modo que el mapa generado y la base salen iguales, y aplica
+ * las acciones en orden sin ejecutar el código del equipo.
+ */
+int sim_ctx_replay(sim_ctx_t *ctx, const action_log_t *log) {
+  float alpha = 0;
+  size_t pos = 0;
+  uint32_t n = 0;
+  sim_ctx_seed(ctx, log->seed);
+  if (sim_ctx_configure(ctx, NULL, replay_beh, NULL, log->exec_time) != 0)
+    return -1;
+  if (ctx->map.hash != log->map_hash) {
+    fprintf(stderr, "Error: Map does not match the action log\n");
+    return -1;
+  }
+  // Sin nombre, rmb_awake() guardaría el mapa generado en map.pgm; con
+  // nombre y sin base coloca la base igual, con el mismo generador
+  if (ctx->map.name[0] == '\0')
+    snprintf(ctx->map.name, sizeof(ctx->map.name), "replay");
+
+  sim_ctx_t *prev = sim_ctx_bind(ctx);
+  ctx->timer = 0;
+  stats_reset_battery(ctx);
+  ctx->should_stop = 0;
+  ctx->stats.end = SIM_END_TIME;
+  for (int action; (action = action_log_next(log, &pos, &alpha)) >= 0; n++)
+    if (sim_apply_action(ctx, action, alpha) != 0)
+      pos = log->len + 1;
+  sim_ctx_bind(prev);
+  if (pos != log->len || n != log->count) {
+    fprintf(stderr, "Error: Corrupt action log\n");
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Carga un mapa en un contexto
+ * @param ctx Contexto destino
+ * @param filename Ruta del archivo PGM
+ * @return 0 si OK, -1 si error
+ *
+ * Carga el mapa a través de la caché de mapas (cada archivo se parsea una
+ * vez por proceso) y reconstruye las estadísticas basándose en su contenido.
+ */
+int sim_ctx_load_map(sim_ctx_t *ctx, char *filename) {
+  sim_snapshot_drop(ctx);
+  sim_cycle_reset(ctx);
+  int rc = sim_world_load_cached(&ctx->map, filename);
+  if (rc == 0)
+    stats_rebuild_from_map(ctx, &ctx->map);
+  return rc;
+}
+
+/* ============================================================================
+ * API PÚBLICA
+ * ============================================================================
+ */
+
+/**
+ * @brief Configura el simulador antes de ejecutar
+ * @param start Función de inicialización (puede ser NULL)
+ * @param beh Función de comportamiento cíclico (obligatoria)
+ * @param stop Función de finalización (puede ser NULL)
+ * @param exec_time Tiempo máximo de ejecución en ticks
+ *
+ * Esta función debe llamarse antes de run(). Configura el contexto por
+ * defecto y registra las funciones de limpieza. La semilla de la
+ * simulación se toma de ROOMBA_SEED (el runner la fija para cada mapa y
+ * repetición) o, si no está definida, del reloj; con ella se inicializan
+ * los generadores del contexto y también srand() para los equipos que usan
+ * rand(). Con ROOMBA_PROFILE=1 se mide cada llamada al comportamiento y
+ * al terminar se escribe latency.csv junto a stats.csv. ROOMBA_STALL_LIMIT
+ * cambia el límite de llamadas sin avanzar el tiempo (0 = sin límite). Con
+ * ROOMBA_HEATMAP=1 se cuentan las visitas a cada celda y al terminar se
+ * añaden a heatmap.bin (ver tools/heatmap).
+ */
+void configure(void (*start)(), void (*beh)(), void (*stop)(), int exec_time) {
+  uint64_t seed;
+  const char *env = getenv("ROOMBA_SEED");
+  if (env && env[0]) {
+    seed = strtoull(env, NULL, 0);
+  } else {
+    // Use clock_gettime for nanosecond precision seeding
+    struct timespec ts;
+    // CLOCK_MONOTONIC is preferred for time intervals, but for seeding
+    // CLOCK_REALTIME or MONOTONIC works as long as it changes rapidly.
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    seed = (uint64_t)ts.tv_nsec ^ (uint64_t)ts.tv_sec;
   }
+  srand((unsigned int)seed);
+  sim_ctx_seed(&default_ctx, seed);
+
+  if (sim_ctx_configure(&default_ctx, start, beh, stop, exec_time) != 0)
+    exit(1);
+  env = getenv("ROOMBA_PROFILE");
+  sim_ctx_profile(&default_ctx, env && atoi(env) > 0);
+  env = getenv("ROOMBA_HEATMAP");
+  stats_count_visits(&default_ctx, env && atoi(env) > 0);
+  env = getenv("ROOMBA_STALL_LIMIT");
+  if (env && env[0])
+    default_ctx.config.stall_limit = atoi(env);
+  if (batch_mode)
+    return;
+#if SIM_TRACE_LEVEL == SIM_TRACE_FULL
+  env = getenv("ROOMBA_LOG");
+  if (env && strcmp(env, "actions") == 0)
+    sim_ctx_record_actions(&default_ctx);
+#endif
 
   // Register cleanup handlers (LIFO order - last registered executes first)
   // _cleanup_hist must be registered BEFORE stop so it executes AFTER
   atexit(_cleanup_hist);
+#if SIM_TRACE_LEVEL == SIM_TRACE_FULL
   atexit(_save_log_wrapper);
+#endif
   atexit(_save_stats_wrapper);
 #ifndef COMPETITION_MODE
   if (stop != NULL)
     atexit(stop);
 #endif
-
-  // Generar variedad de obstáculos:
-  // 50% de probabilidad: muros (1-4 muros aleatorios)
-  // 50% de probabilidad: obstáculos dispersos (densidad 0-5%)
-  if (rand() % 2 == 0) {
-    density = (rand() % 4) + 1; // 1 a 4 muros
-  } else {
-    density = rand() / (float)RAND_MAX * MAX_OBSTACLE_DENSITY; // 0 a 0.05
-  }
-
-  if (map.name[0] == '\0')
-    sim_world_generate(&map, WORLDSIZE, WORLDSIZE, DEFAULT_DIRT_CELLS, density);
-  if (map.name[0] == '\0')
-    stats_rebuild_from_map(&map);
 }
 
 /**
  * @brief Ejecuta la simulación
  *
- * Ejecuta el bucle principal de simulación. Llama a la función on_start
- * una vez, luego ejecuta exec_beh repetidamente hasta que se alcance el
- * tiempo límite o se solicite detención.
+ * Ejecuta el bucle principal de simulación sobre el contexto por defecto.
  *
  * @note Debe llamarse después de configure()
  */
 void run() {
-  if (!hist) {
-    fprintf(stderr, "Error: Must call configure() before run()\n");
+  if (sim_ctx_run(&default_ctx) != 0)
     exit(1);
-  }
+}
 
-  timer = 0;
-  sim_should_stop = 0;
-  if (config.on_start)
-    config.on_start();
-  while (!sim_should_stop && timer < config.exec_time)
-    config.exec_beh();
+/**
+ * @brief Añade otro robot a la simulación
+ * @param start Función de inicialización del robot (puede ser NULL)
+ * @param beh Función de comportamiento del robot (obligatoria)
+ * @param stop Función de finalización del robot (puede ser NULL)
+ * @return Índice del robot (1, 2...), o -1 si error
+ *
+ * Wrapper de sim_team_add() sobre el contexto por defecto.
+ */
+int add_robot(void (*start)(), void (*beh)(), void (*stop)()) {
+  return sim_team_add(&default_ctx, start, beh, stop);
 }
 
 /**
@@ -250,12 +751,36 @@ void run() {
  * @param filename Ruta del archivo PGM
  * @return 0 si OK, -1 si error
  *
- * Wrapper de la API pública que carga un mapa y reconstruye
- * las estadísticas basándose en su contenido.
+ * Wrapper de la API pública sobre el contexto por defecto.
  */
 int load_map(char *filename) {
-  int rc = sim_world_load(&map, filename);
-  if (rc == 0)
-    stats_rebuild_from_map(&map);
-  return rc;
+  return sim_ctx_load_map(&default_ctx, filename);
+}
+
+/* ============================================================================
+ * MODO BATCH
+ * ============================================================================
+ */
+
+/**
+ * @brief Activa el modo batch
+ *
+ * El runner carga el código del equipo una sola vez y llama a su main()
+ * en cada repetición. En este modo configure() no registra manejadores
+ * atexit(); las estadísticas se guardan con sim_batch_finish_run().
+ */
+void sim_batch_enable(void) { batch_mode = 1; }
+
+/**
+ * @brief Cierra una ejecución en modo batch
+ *
+ * Hace el trabajo de los manejadores atexit() de configure() sobre el
+ * contexto por defecto: añade la línea de estadísticas a stats.csv y
+ * libera el historial y el mapa. No escribe log.csv.
+ */
+void sim_batch_finish_run(void) {
+  _save_stats_wrapper();
+  sim_team_destroy(&default_ctx);
+  _cleanup_hist();
+  release_world(&default_ctx);
 }
@@ -10,6 +10,8 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <math.h>
 #include "simula.h"
 
@@ -30,11 +32,30 @@
 #define DEBUG_PRINT(...) printf(__VA_ARGS__)
 #endif
 
+/**
+ * @brief Niveles de traza, fijados al compilar con -DSIM_TRACE_LEVEL=...
+ *
+ * - SIM_TRACE_NONE: sin historial ni archivos; las estadísticas solo
+ *   quedan en memoria (stats_get).
+ * - SIM_TRACE_STATS: sin historial; al terminar se guarda stats.csv.
+ * - SIM_TRACE_FULL: historial por tick, log.csv y visualize() (por defecto).
+ *
+ * Sin historial, sim_log_tick() no escribe en memoria por tick; bat_mean
+ * sale en todos los niveles del acumulador de stats_tick().
+ */
+#define SIM_TRACE_NONE 0
+#define SIM_TRACE_STATS 1
+#define SIM_TRACE_FULL 2
+#ifndef SIM_TRACE_LEVEL
+#define SIM_TRACE_LEVEL SIM_TRACE_FULL
+#endif
+
 /* ============================================================================
  * CONSTANTES DEL MUNDO
  * ============================================================================ */
 
-#define WORLDSIZE 50              ///< Tamaño máximo del mundo (filas y columnas)
+#define WORLDSIZE 50              ///< Tamaño por defecto del mundo generado (filas y columnas)
+#define MAX_WORLDSIZE 65536       ///< Límite de cordura para las dimensiones de un mapa
 #define WALL '#'                  ///< Carácter que representa un obstáculo
 #define EMPTY ' '                 ///< Carácter que representa una celda vacía
 #define MAXDIRT 5                 ///< Nivel máximo de suciedad por celda
@@ -55,6 +76,31 @@
 #define COST_MOVE_DIAG 1.4f       ///< Coste de mover en diagonal
 #define COST_BUMP 0.5f            ///< Coste de colisión
 #define COST_CLEAN 0.5f           ///< Coste de limpiar
+#define MIN_BATTERY_THRESHOLD 0.1f ///< Umbral mínimo de batería para detener simulación
+#define LOAD_BATTERY_AMOUNT 10.0f ///< Cantidad de batería por recarga
+
+/// Llamadas seguidas al comportamiento sin avanzar el tiempo antes de parar
+/// la ejecución (ROOMBA_STALL_LIMIT). Chocar siempre contra una pared agota
+/// la batería en MAXBAT / COST_BUMP = 2000 llamadas, antes de llegar aquí.
+#define SIM_STALL_LIMIT 10000
+
+/* ============================================================================
+ * CODIFICACIÓN DE CELDAS
+ * ============================================================================ */
+
+/**
+ * @brief Celda del mapa codificada en un byte
+ *
+ * Bit 7: obstáculo, bit 6: base, bits 0-5: nivel de suciedad.
+ * Una celda libre y limpia vale CELL_EMPTY.
+ */
+typedef unsigned char cell_t;
+
+#define CELL_EMPTY 0x00           ///< Celda libre y limpia
+#define CELL_DIRT_MASK 0x3F       ///< Bits del nivel de suciedad
+#define CELL_BASE 0x40            ///< Bit de la base del robot
+#define CELL_WALL 0x80            ///< Bit de obstáculo
+#define CELL_DIRT(c) ((c) & CELL_DIRT_MASK)  ///< Nivel de suciedad de una celda
 
 /* ============================================================================
  * ESTRUCTURAS DE DATOS
@@ -68,18 +114,106 @@ typedef struct _dirt{
   int depth;                      ///< Nivel de suciedad (1-MAXDIRT)
 } dirt_t;
 
+/**
+ * @brief Entrada del diario de cambios (ver sim_snapshot)
+ */
+typedef struct {
+  uint32_t idx;                   ///< Índice row-major de la celda
+  cell_t old;                     ///< Valor anterior de la celda
+} journal_entry_t;
+
+/**
+ * @brief Diario de cambios para volver a una instantánea
+ *
+ * Solo registra mientras active != 0, es decir, desde el primer
+ * sim_snapshot() hasta sim_snapshot_drop().
+ */
+typedef struct {
+  journal_entry_t *entries;       ///< Cambios en orden cronológico
+  size_t len, cap;                ///< Entradas usadas / reservadas
+  int active;                     ///< 1 si se están registrando cambios
+  int failed;                     ///< 1 si se perdió algún cambio (sin memoria)
+  unsigned gen;                   ///< Generación; cambia al descartar el diario
+} journal_t;
+
+/**
+ * @brief Registro de las acciones del robot (ver actions.bin en sim_io.c)
+ *
+ * Con el mismo mapa y la misma semilla, la secuencia de acciones
+ * determina toda la simulación: sim_ctx_replay() la reproduce sin
+ * ejecutar el código del equipo. Cada acción ocupa un byte (código) más,
+ * en los giros, el ángulo en float.
+ */
+typedef struct {
+  unsigned char *buf;             ///< Acciones codificadas
+  size_t len, cap;                ///< Bytes usados / reservados
+  uint32_t count;                 ///< Número de acciones
+  int active;                     ///< 1 si se están registrando acciones
+  int failed;                     ///< 1 si se perdió alguna acción (sin memoria)
+  int flags;                      ///< Flags ACTIONS_* (al guardar o cargar)
+  int exec_time;                  ///< Ticks máximos de la ejecución
+  uint64_t map_hash;              ///< sim_world_hash() del mapa inicial
+  uint64_t seed;                  ///< Semilla de la simulación
+} action_log_t;
+
+#define BEH_PROF_BUCKETS 64       ///< Cubetas del histograma de latencias
+
+/**
+ * @brief Tiempos de las llamadas al comportamiento (ROOMBA_PROFILE=1)
+ *
+ * La cubeta b cuenta las llamadas a exec_beh que tardaron entre 2^b y
+ * 2^(b+1) - 1 ns, así que p50 y p99 se conocen con un error de como
+ * mucho un factor 2 sin guardar cada tiempo.
+ */
+typedef struct {
+  int active;                     ///< 1 si se miden las llamadas
+  uint64_t calls;                 ///< Llamadas medidas
+  uint64_t idle_calls;            ///< Llamadas sin ninguna acción rmb_*
+  uint64_t actions;               ///< Acciones rmb_* hechas (sim_robot.c)
+  uint64_t total_ns;              ///< Suma de los tiempos
+  uint64_t max_ns;                ///< Llamada más lenta
+  uint32_t bucket[BEH_PROF_BUCKETS]; ///< Histograma logarítmico
+} beh_prof_t;
+
 /**
  * @brief Estructura principal que representa el mapa del mundo
+ *
+ * Las celdas se reservan en memoria dinámica según el tamaño del mapa
+ * (sim_world_alloc) y se guardan en orden row-major, un byte cell_t por
+ * celda; se accede a ellas con MAP_CELL(). La lista de celdas sucias es
+ * un índice opcional que solo existe tras sim_world_dirt_index(). La
+ * memoria se libera con sim_world_free().
  */
 typedef struct _map{
-  char cells[WORLDSIZE][WORLDSIZE];  ///< Matriz de celdas (WALL o EMPTY)
+  cell_t *cells;                     ///< Celdas nrow*ncol codificadas (CELL_*)
   int nrow, ncol;                    ///< Dimensiones reales del mapa
-  dirt_t dirt[WORLDSIZE*WORLDSIZE];  ///< Lista de celdas sucias
-  int ndirt;                         ///< Número de celdas sucias
+  dirt_t *dirt;                      ///< Índice de celdas sucias (NULL si no se ha construido)
+  int ndirt;                         ///< Número de entradas del índice
   char name[256];                    ///< Nombre del archivo del mapa
   int base_x, base_y;                ///< Coordenadas de la base
+  uint64_t hash;                     ///< sim_world_hash() del mapa recién cargado o generado
+  journal_t *journal;                ///< Diario de cambios de celdas (NULL = sin registro)
 } map_t;
 
+/**
+ * @brief Celda (y, x) de un mapa
+ */
+#define MAP_CELL(m, y, x) ((m)->cells[(size_t)(y) * (m)->ncol + (x)])
+
+/**
+ * @brief Generador pseudoaleatorio PCG32 (16 bytes de estado)
+ *
+ * Cada simulación tiene los suyos, así que las ejecuciones son
+ * reproducibles a partir de una semilla y no comparten el rand() de libc.
+ */
+typedef struct {
+  uint64_t state;                 ///< Estado interno
+  uint64_t inc;                   ///< Incremento (impar); selecciona el flujo
+} sim_rng_t;
+
+#define SIM_RNG_WORLD 0           ///< Flujo del generador del mapa
+#define SIM_RNG_ROBOT 1           ///< Flujo de rmb_rand()
+
 /**
  * @brief Configuración de la simulación
  */
@@ -89,6 +223,7 @@ typedef struct _config{
   void (*on_stop)();              ///< Función de finalización
   FILE *output;                   ///< Stream de salida para logs
   int exec_time;                  ///< Tiempo máximo de ejecución (ticks)
+  int stall_limit;                ///< Llamadas sin avanzar antes de parar (0 = sin límite)
 } config_t;
 
 /**
@@ -104,6 +239,15 @@ typedef struct _robot{
  */
 enum movement {FWD, TURN, BUMP, CLEAN, LOAD};
 
+/**
+ * @brief Motivo del final de una ejecución (columna end de stats.csv)
+ */
+enum sim_end {
+  SIM_END_TIME,                   ///< Se agotó el tiempo (o sigue en marcha)
+  SIM_END_BATTERY,                ///< La batería bajó de MIN_BATTERY_THRESHOLD
+  SIM_END_STALL                   ///< El comportamiento dejó de avanzar el tiempo
+};
+
 /**
  * @brief Estadísticas de la simulación
  */
@@ -113,40 +257,252 @@ struct _stat{
   int dirt_total;                 ///< Total de suciedad inicial
   int dirt_cleaned;               ///< Total de suciedad limpiada
   float bat_total;                ///< Batería total consumida
-  float bat_mean;                 ///< Batería media por tick
+  float bat_mean;                 ///< Batería media por tick (al día en cada tick)
+  float bat_sum;                  ///< Suma de la batería de los ticks registrados
   int moves[5];                   ///< Contador de movimientos por tipo
+  int end;                        ///< Motivo del final (enum sim_end)
 };
 
-/* ============================================================================
- * ESTADO GLOBAL (definido en simula.c)
- * ============================================================================ */
+/**
+ * @brief Contexto de simulación
+ *
+ * Agrupa todo el estado mutable de una simulación (mapa, robot, historial,
+ * configuración y estadísticas). Cada contexto es independiente, lo que
+ * permite ejecutar varias simulaciones dentro del mismo proceso.
+ */
+typedef struct _sim_ctx{
+  map_t map;                      ///< Mapa del mundo
+  robot_t robot;                  ///< Estado interno del robot
+  sensor_t *hist;                 ///< Historial de posiciones (memoria dinámica)
+  config_t config;                ///< Configuración de la simulación
+  int timer;                      ///< Contador de ticks
+  int should_stop;                ///< Flag de detención
+  int stall;                      ///< Llamadas seguidas al comportamiento sin avanzar timer
+  struct _stat stats;             ///< Estadísticas de la simulación
+  uint16_t *visited;              ///< Época de la última visita de cada celda (nrow*ncol, row-major)
+  size_t visited_len;             ///< Número de celdas de visited
+  uint16_t visit_epoch;           ///< Época actual: visitada si visited[i] == visit_epoch
+  int count_visits;               ///< 1 si se cuentan las visitas de cada celda
+  uint32_t *visits;               ///< Visitas de cada celda (NULL sin count_visits)
+  uint64_t seed;                  ///< Semilla de la simulación (sim_ctx_seed)
+  sim_rng_t world_rng;            ///< Generador del mapa y de la base
+  sim_rng_t robot_rng;            ///< Generador de rmb_rand()
+  journal_t cell_journal;         ///< Cambios de celdas desde la primera instantánea
+  journal_t visit_journal;        ///< Visitas a celdas desde entonces (old = 1: primera)
+  action_log_t actions;           ///< Acciones registradas (ROOMBA_LOG=actions)
+  beh_prof_t prof;                ///< Latencia del comportamiento (ROOMBA_PROFILE)
+  struct _sim_team *team;         ///< Robots que comparten el mapa (NULL = robot único)
+  struct _sim_cycle *cycle;       ///< Detector de ciclos (NULL = sin rmb_declare_state)
+  int robot_id;                   ///< Índice del robot dentro de team (0 = dueño del mapa)
+} sim_ctx_t;
 
-extern map_t map;                 ///< Mapa del mundo
-extern robot_t r;                 ///< Estado interno del robot
-extern sensor_t *hist;            ///< Historial de posiciones (memoria dinámica)
-extern config_t config;           ///< Configuración de la simulación
-extern int timer;                 ///< Contador de ticks
-extern struct sensor *rob;        ///< Puntero público a sensores (apunta a r.sensor)
+/**
+ * @brief Instantánea del estado de una simulación
+ *
+ * Guarda por valor el estado pequeño (robot, tiempo, estadísticas,
+ * generadores) y la posición de los diarios de cambios del contexto. Las
+ * celdas y la matriz de visitadas no se copian: sim_restore() deshace los
+ * cambios registrados desde la instantánea, en O(cambios).
+ */
+typedef struct {
+  size_t cell_mark;               ///< Longitud de cell_journal al tomarla
+  size_t visit_mark;              ///< Longitud de visit_journal al tomarla
+  unsigned gen;                   ///< Generación de los diarios
+  robot_t robot;                  ///< Estado del robot
+  int timer;                      ///< Contador de ticks
+  int should_stop;                ///< Flag de detención
+  struct _stat stats;             ///< Estadísticas
+  sim_rng_t world_rng;            ///< Generador del mapa
+  sim_rng_t robot_rng;            ///< Generador de rmb_rand()
+  int base_x, base_y;             ///< Base del mapa
+} sim_snapshot_t;
 
 /* ============================================================================
  * MÓDULO: CORE (simula.c)
  * ============================================================================ */
 
+/**
+ * @brief Crea un contexto de simulación vacío
+ * @return Puntero al contexto, o NULL si no hay memoria
+ *
+ * El contexto debe liberarse con sim_ctx_destroy().
+ */
+sim_ctx_t* sim_ctx_create(void);
+
+/**
+ * @brief Libera un contexto de simulación, su historial y su mapa
+ * @param ctx Contexto a liberar (no puede ser el contexto por defecto)
+ */
+void sim_ctx_destroy(sim_ctx_t *ctx);
+
+/**
+ * @brief Devuelve el contexto por defecto usado por la API de simula.h
+ * @return Puntero al contexto por defecto
+ */
+sim_ctx_t* sim_ctx_default(void);
+
+/**
+ * @brief Devuelve el contexto activo del hilo actual
+ * @return Contexto enlazado con sim_ctx_bind(), o el contexto por defecto
+ */
+sim_ctx_t* sim_ctx_current(void);
+
+/**
+ * @brief Enlaza un contexto como activo para la API de simula.h
+ * @param ctx Contexto a activar (NULL vuelve al contexto por defecto)
+ * @return Contexto que estaba activo antes de la llamada
+ */
+sim_ctx_t* sim_ctx_bind(sim_ctx_t *ctx);
+
+/**
+ * @brief Fija la semilla de un contexto
+ * @param ctx Contexto de simulación
+ * @param seed Semilla; con la misma semilla y el mismo mapa la simulación
+ *             (mapa aleatorio, base y rmb_rand()) se repite exactamente
+ *
+ * sim_ctx_create() usa la semilla 0; configure() toma ROOMBA_SEED o, si no
+ * está definida, el reloj.
+ */
+void sim_ctx_seed(sim_ctx_t *ctx, uint64_t seed);
+
+/**
+ * @brief Configura un contexto de simulación (equivalente a configure())
+ * @param ctx Contexto a configurar
+ * @param start Función de inicialización (puede ser NULL)
+ * @param beh Función de comportamiento cíclico (obligatoria)
+ * @param stop Función de finalización (puede ser NULL)
+ * @param exec_time Tiempo máximo de ejecución en ticks
+ * @return 0 si OK, -1 si error
+ *
+ * A diferencia de configure(), no registra manejadores atexit().
+ */
+int sim_ctx_configure(sim_ctx_t *ctx, void (*start)(), void (*beh)(),
+                      void (*stop)(), int exec_time);
+
+/**
+ * @brief Ejecuta la simulación de un contexto (equivalente a run())
+ * @param ctx Contexto previamente configurado
+ * @return 0 si OK, -1 si el contexto no está configurado
+ *
+ * Durante la ejecución el contexto queda enlazado como activo, de modo que
+ * los comportamientos que usan la API de simula.h actúan sobre él.
+ */
+int sim_ctx_run(sim_ctx_t *ctx);
+
+/**
+ * @brief Carga un mapa en un contexto (equivalente a load_map())
+ * @param ctx Contexto destino
+ * @param filename Ruta del archivo PGM
+ * @return 0 si OK, -1 si error
+ */
+int sim_ctx_load_map(sim_ctx_t *ctx, char *filename);
+
 /**
  * @brief Solicita la detención de la simulación
+ * @param ctx Contexto de simulación
  */
-void sim_request_stop(void);
+void sim_request_stop(sim_ctx_t *ctx);
 
 /**
- * @brief Flag que indica si se debe detener la simulación
+ * @brief Toma una instantánea del estado de la simulación
+ * @param ctx Contexto de simulación
+ * @param snap Instantánea a rellenar
+ *
+ * Activa el registro de cambios de celdas y visitadas del contexto. Se
+ * pueden tomar varias; restaurar una invalida las tomadas después de ella.
+ * El registro sigue activo hasta sim_snapshot_drop() o hasta cargar o
+ * generar otro mapa.
  */
-extern int sim_should_stop;
+void sim_snapshot(sim_ctx_t *ctx, sim_snapshot_t *snap);
+
+/**
+ * @brief Vuelve al estado de una instantánea
+ * @param ctx Contexto de simulación
+ * @param snap Instantánea tomada con sim_snapshot() sobre el mismo contexto
+ * @return 0 si OK, -1 si la instantánea ya no es válida
+ *
+ * Deshace solo las celdas y visitadas que cambiaron desde la instantánea.
+ * La instantánea sigue siendo válida y puede restaurarse otra vez.
+ */
+int sim_restore(sim_ctx_t *ctx, const sim_snapshot_t *snap);
+
+/**
+ * @brief Descarta todas las instantáneas y desactiva el registro de cambios
+ * @param ctx Contexto de simulación
+ */
+void sim_snapshot_drop(sim_ctx_t *ctx);
 
 /**
  * @brief Registra un tick en el historial
+ * @param ctx Contexto de simulación
  * @param action Tipo de acción realizada (enum movement)
  */
-void sim_log_tick(int action);
+void sim_log_tick(sim_ctx_t *ctx, int action);
+
+/**
+ * @brief Activa o desactiva la medida de latencia del comportamiento
+ * @param ctx Contexto de simulación
+ * @param on 1 para medir cada llamada a exec_beh, 0 para no medir
+ *
+ * Pone a cero lo medido antes. Lo usa configure() con ROOMBA_PROFILE=1.
+ */
+void sim_ctx_profile(sim_ctx_t *ctx, int on);
+
+/**
+ * @brief Llama una vez al comportamiento del contexto
+ * @param ctx Contexto enlazado como activo
+ *
+ * Con la medida activa (sim_ctx_profile) anota el tiempo de la llamada
+ * y si el robot no hizo ninguna acción. Tras config.stall_limit llamadas
+ * seguidas sin avanzar el tiempo detiene la ejecución con SIM_END_STALL.
+ * Es el cuerpo de todos los bucles de ejecución (run, equipos y
+ * competición).
+ */
+void sim_ctx_exec_beh(sim_ctx_t *ctx);
+
+/**
+ * @brief Aplica una acción registrada con su función rmb_ctx_*
+ * @param ctx Contexto de simulación
+ * @param action Código (FWD, TURN, CLEAN, LOAD, ACTION_AWAKE, ACTION_STALL)
+ * @param alpha Ángulo (solo con TURN)
+ * @return 0 si OK, -1 si el código no es válido
+ */
+int sim_apply_action(sim_ctx_t *ctx, int action, float alpha);
+
+/**
+ * @brief Empieza a registrar las acciones del robot de un contexto
+ * @param ctx Contexto de simulación
+ *
+ * Descarta lo registrado antes. Lo usa configure() con ROOMBA_LOG=actions.
+ */
+void sim_ctx_record_actions(sim_ctx_t *ctx);
+
+/**
+ * @brief Reproduce un registro de acciones en un contexto
+ * @param ctx Contexto nuevo; si la ejecución original cargó un mapa
+ *            (ACTIONS_MAP_FILE), ese mapa ya debe estar cargado
+ * @param log Registro leído con action_log_load()
+ * @return 0 si OK, -1 si el mapa no coincide o el registro está dañado
+ *
+ * Configura el contexto con la semilla y el tiempo del registro y aplica
+ * cada acción con rmb_ctx_*: al terminar, el historial, las estadísticas y
+ * el mapa son los de la ejecución original.
+ */
+int sim_ctx_replay(sim_ctx_t *ctx, const action_log_t *log);
+
+/**
+ * @brief Activa el modo batch (configure() no registra manejadores atexit)
+ *
+ * Usado por el runner para ejecutar varias repeticiones en un solo proceso.
+ */
+void sim_batch_enable(void);
+
+/**
+ * @brief Guarda las estadísticas del contexto por defecto y libera su historial
+ *
+ * Sustituye a los manejadores atexit() al final de cada ejecución batch.
+ */
+void sim_batch_finish_run(void);
 
 /* ============================================================================
  * MÓDULO: ESTADÍSTICAS (sim_stats.c)
@@ -154,55 +510,130 @@ void sim_log_tick(int action);
 
 /**
  * @brief Registra un movimiento en las estadísticas
+ * @param ctx Contexto de simulación
  * @param kind Tipo de movimiento (enum movement)
  */
-void stats_move(int kind);
+void stats_move(sim_ctx_t *ctx, int kind);
 
 /**
  * @brief Marca una celda como visitada
+ * @param ctx Contexto de simulación
+ */
+void stats_visit_cell(sim_ctx_t *ctx);
+
+/**
+ * @brief Indica si el robot ha pisado una celda en esta ejecución
+ * @param ctx Contexto de simulación
+ * @param idx Índice row-major de la celda
+ * @return 1 si está visitada, 0 si no
+ */
+int stats_is_visited(const sim_ctx_t *ctx, size_t idx);
+
+/**
+ * @brief Activa o desactiva el contador de visitas por celda
+ * @param ctx Contexto de simulación
+ * @param on 1 para contar cada entrada del robot en cada celda
+ * @return 0 si OK, -1 si no hay memoria (el contador queda desactivado)
+ *
+ * Desactivado (por defecto) no cuesta nada en stats_visit_cell().
+ */
+int stats_count_visits(sim_ctx_t *ctx, int on);
+
+/**
+ * @brief Entradas en celdas ya visitadas
+ * @param ctx Contexto de simulación con el contador activo
+ * @return Visitas contadas menos celdas distintas visitadas (0 sin contador)
  */
-void stats_visit_cell(void);
+uint64_t stats_revisits(const sim_ctx_t *ctx);
 
 /**
  * @brief Registra una colisión
+ * @param ctx Contexto de simulación
  */
-void stats_bump(void);
+void stats_bump(sim_ctx_t *ctx);
 
 /**
  * @brief Registra una acción de limpieza
+ * @param ctx Contexto de simulación
  * @param before Nivel de suciedad antes de limpiar
  * @param after Nivel de suciedad después de limpiar
  */
-void stats_clean_action(int before, int after);
+void stats_clean_action(sim_ctx_t *ctx, int before, int after);
 
 /**
  * @brief Registra consumo de batería
+ * @param ctx Contexto de simulación
  * @param amount Cantidad de batería consumida
  */
-void stats_battery_consume(float amount);
+void stats_battery_consume(sim_ctx_t *ctx, float amount);
 
 /**
  * @brief Reconstruye estadísticas basándose en el estado actual del mapa
+ * @param ctx Contexto de simulación
  * @param m Puntero al mapa
  */
-void stats_rebuild_from_map(const map_t* m);
+void stats_rebuild_from_map(sim_ctx_t *ctx, const map_t* m);
+
+/**
+ * @brief Toma las estadísticas del mapa de otro contexto con el mismo mapa
+ * @param ctx Contexto de simulación
+ * @param owner Contexto cuyo mapa comparte ctx
+ *
+ * Como stats_rebuild_from_map(), pero sin recorrer las celdas.
+ */
+void stats_share_map(sim_ctx_t *ctx, const sim_ctx_t *owner);
 
 /**
- * @brief Establece la batería media por tick
- * @param mean Valor de batería media
+ * @brief Acumula la batería del tick recién registrado
+ * @param ctx Contexto de simulación (con timer ya incrementado)
+ * @param battery Batería del robot en ese tick
+ *
+ * Mantiene bat_sum y bat_mean al día, de modo que stats_get() es O(1) en
+ * cualquier tick y no necesita el historial.
  */
-void stats_set_mean_battery(float mean);
+void stats_tick(sim_ctx_t *ctx, float battery);
+
+/**
+ * @brief Reinicia el acumulador de batería al empezar una ejecución
+ * @param ctx Contexto de simulación
+ */
+void stats_reset_battery(sim_ctx_t *ctx);
 
 /**
  * @brief Obtiene las estadísticas actuales
+ * @param ctx Contexto de simulación
  * @return Puntero a la estructura de estadísticas (solo lectura)
  */
-const struct _stat* stats_get(void);
+const struct _stat* stats_get(const sim_ctx_t *ctx);
 
 /**
  * @brief Reinicia todas las estadísticas a cero
+ * @param ctx Contexto de simulación
  */
-void stats_reset(void);
+void stats_reset(sim_ctx_t *ctx);
+
+/**
+ * @brief Anota una llamada al comportamiento en el histograma
+ * @param prof Medidas del contexto
+ * @param ns Duración de la llamada en nanosegundos
+ * @param idle 1 si el robot no hizo ninguna acción
+ */
+void prof_record(beh_prof_t *prof, uint64_t ns, int idle);
+
+/**
+ * @brief Suma las medidas de otro robot
+ * @param dst Medidas acumuladas
+ * @param src Medidas a sumar
+ */
+void prof_merge(beh_prof_t *dst, const beh_prof_t *src);
+
+/**
+ * @brief Percentil de la latencia a partir del histograma
+ * @param prof Medidas
+ * @param pct Percentil (1-100)
+ * @return Cota superior en ns de la cubeta del percentil (sin pasar de max_ns)
+ */
+uint64_t prof_percentile(const beh_prof_t *prof, int pct);
 
 /* ============================================================================
  * MÓDULO: ENTRADA/SALIDA (sim_io.c)
@@ -215,16 +646,334 @@ void stats_reset(void);
  */
 void save_log(const sensor_t *hist, int len);
 
+/**
+ * @brief Escribe un historial en formato CSV (el de log.csv)
+ * @param file Archivo de salida
+ * @param hist Array de posiciones visitadas
+ * @param len Longitud del array
+ */
+void write_log_csv(FILE *file, const sensor_t *hist, int len);
+
+/* Traza binaria (log.bin): cabecera de TRACE_HEADER_SIZE bytes seguida de
+ * registros de tamaño fijo, todo en little-endian.
+ *
+ *   Cabecera: magic "RMBTRACE", u16 versión, u16 flags, u32 tamaño de
+ *             registro, u64 hash del mapa, u32 número de registros,
+ *             i32 x0, i32 y0, u32 reservado.
+ *   Registro: i32 x, i32 y, f32 heading, f32 battery, u8 bumper,
+ *             u8 infrared, u16 relleno                           (20 bytes)
+ *   Registro con TRACE_DELTA_XY: i8 dx, i8 dy, u8 bumper, u8 infrared,
+ *             f32 heading, f32 battery                           (12 bytes)
+ *
+ * Con TRACE_DELTA_XY la posición de cada registro es la del anterior
+ * (o x0, y0 para el primero) más dx, dy. */
+
+#define TRACE_MAGIC "RMBTRACE"    ///< Firma de la traza binaria
+#define TRACE_VERSION 1           ///< Versión del formato
+#define TRACE_HEADER_SIZE 40      ///< Bytes de la cabecera
+#define TRACE_DELTA_XY 0x0001     ///< Flag: posiciones codificadas como incrementos
+#define TRACE_BUFFER_SIZE 65536   ///< Tamaño del buffer del escritor
+
+/**
+ * @brief Escritor en streaming de trazas binarias
+ */
+typedef struct {
+  FILE *file;                     ///< Archivo de salida
+  unsigned char buf[TRACE_BUFFER_SIZE]; ///< Registros pendientes de escribir
+  size_t used;                    ///< Bytes ocupados en buf
+  int flags;                      ///< Flags TRACE_*
+  uint32_t count;                 ///< Registros escritos
+  int last_x, last_y;             ///< Posición del último registro
+  int error;                      ///< Distinto de 0 si falló alguna escritura
+} trace_writer_t;
+
+/**
+ * @brief Abre una traza binaria para escritura
+ * @param w Escritor a inicializar
+ * @param path Ruta del archivo
+ * @param map_hash Hash del mapa (sim_world_hash)
+ * @param flags Flags TRACE_*
+ * @param x0 Columna de referencia para TRACE_DELTA_XY
+ * @param y0 Fila de referencia para TRACE_DELTA_XY
+ * @return 0 si OK, -1 si error
+ */
+int trace_open(trace_writer_t *w, const char *path, uint64_t map_hash,
+               int flags, int x0, int y0);
+
+/**
+ * @brief Añade un registro a la traza
+ * @param w Escritor abierto
+ * @param s Estado del robot a registrar
+ *
+ * Con TRACE_DELTA_XY el desplazamiento respecto al registro anterior
+ * debe caber en un byte con signo; si no, la traza se marca como errónea.
+ */
+void trace_write(trace_writer_t *w, const sensor_t *s);
+
+/**
+ * @brief Vuelca el buffer, escribe el número de registros y cierra
+ * @param w Escritor abierto
+ * @return 0 si OK, -1 si hubo algún error
+ */
+int trace_close(trace_writer_t *w);
+
+/**
+ * @brief Lee una traza binaria completa
+ * @param path Ruta del archivo
+ * @param hist Puntero donde guardar el historial (liberar con free)
+ * @param len Puntero donde guardar el número de registros
+ * @param map_hash Puntero donde guardar el hash del mapa (puede ser NULL)
+ * @return 0 si OK, -1 si error
+ */
+int trace_load(const char *path, sensor_t **hist, int *len, uint64_t *map_hash);
+
+/**
+ * @brief Guarda el historial de posiciones en la traza binaria log.bin
+ * @param hist Array de posiciones visitadas
+ * @param len Longitud del array
+ * @param map_hash Hash del mapa simulado
+ *
+ * Usa TRACE_DELTA_XY siempre que todos los pasos quepan en un byte.
+ */
+void save_trace(const sensor_t *hist, int len, uint64_t map_hash);
+
+/* Registro de acciones (actions.bin): cabecera de ACTIONS_HEADER_SIZE
+ * bytes seguida de las acciones, todo en little-endian.
+ *
+ *   Cabecera: magic "RMBACTNS", u16 versión, u16 flags, u32 tiempo de
+ *             ejecución, u64 hash del mapa, u32 número de acciones,
+ *             u32 bytes de acciones, u64 semilla.
+ *   Acción:   u8 código (FWD, TURN, CLEAN, LOAD, ACTION_AWAKE o
+ *             ACTION_STALL); TURN va seguido de un f32 con el ángulo.
+ *
+ * Con ACTIONS_MAP_FILE la ejecución cargó el mapa de un archivo (hay que
+ * volver a cargarlo para reproducirla); sin él, el mapa se generó con la
+ * semilla. */
+
+#define ACTIONS_MAGIC "RMBACTNS"  ///< Firma del registro de acciones
+#define ACTIONS_VERSION 1         ///< Versión del formato
+#define ACTIONS_HEADER_SIZE 40    ///< Bytes de la cabecera
+#define ACTIONS_MAP_FILE 0x0001   ///< Flag: mapa cargado de archivo
+#define ACTION_AWAKE 5            ///< Código de rmb_awake() (tras enum movement)
+#define ACTION_STALL 6            ///< El vigilante paró la ejecución (SIM_END_STALL)
+
+/**
+ * @brief Añade una acción a un registro
+ * @param log Registro activo
+ * @param action Código (FWD, TURN, CLEAN, LOAD o ACTION_AWAKE)
+ * @param alpha Ángulo (solo se guarda con TURN)
+ *
+ * Si no hay memoria el registro se marca como fallido (log->failed).
+ */
+void action_log_push(action_log_t *log, int action, float alpha);
+
+/**
+ * @brief Lee la siguiente acción de un registro
+ * @param log Registro
+ * @param pos Posición en log->buf (entrada/salida; empieza en 0)
+ * @param alpha Ángulo de la acción si es TURN (salida)
+ * @return Código de la acción, o -1 al final o si el registro está dañado
+ */
+int action_log_next(const action_log_t *log, size_t *pos, float *alpha);
+
+/**
+ * @brief Libera las acciones de un registro y lo desactiva
+ * @param log Registro
+ */
+void action_log_free(action_log_t *log);
+
+/**
+ * @brief Escribe un registro de acciones
+ * @param log Registro con flags, exec_time, map_hash y seed rellenos
+ * @param path Ruta del archivo
+ * @return 0 si OK, -1 si error
+ */
+int action_log_write(const action_log_t *log, const char *path);
+
+/**
+ * @brief Lee un registro de acciones completo
+ * @param path Ruta del archivo
+ * @param log Registro a rellenar (liberar con action_log_free)
+ * @return 0 si OK, -1 si error
+ */
+int action_log_load(const char *path, action_log_t *log);
+
+/**
+ * @brief Guarda un registro de acciones en actions.bin
+ * @param log Registro con flags, exec_time, map_hash y seed rellenos
+ */
+void save_actions(const action_log_t *log);
+
+/**
+ * @brief Guarda la latencia del comportamiento en latency.csv
+ * @param prof Medidas de la ejecución
+ *
+ * Añade una fila por ejecución (la cabecera solo si el archivo está vacío).
+ */
+void save_latency(const beh_prof_t *prof);
+
+/* Mapa de calor (heatmap.bin): un registro por ejecución, añadido al final
+ * del archivo, todo en little-endian.
+ *
+ *   Cabecera: magic "RMBHEATM", u16 versión, u16 bytes del nombre, u32
+ *             filas, u32 columnas, u64 hash del mapa, u32 ticks, u32
+ *             celdas distintas visitadas, u32 bytes de celdas.
+ *   Nombre:   nombre del mapa sin terminador (vacío si se generó).
+ *   Celdas:   para cada celda con visitas, en orden row-major, dos varints
+ *             LEB128: celdas sin visitas saltadas desde la anterior y
+ *             número de visitas. */
+
+#define HEATMAP_MAGIC "RMBHEATM"  ///< Firma de un registro de heatmap.bin
+#define HEATMAP_VERSION 1         ///< Versión del formato
+#define HEATMAP_HEADER_SIZE 40    ///< Bytes de la cabecera
+#define HEATMAP_MAX_CELLS (1u << 26) ///< Celdas máximas de un registro al leer
+
+/**
+ * @brief Visitas a cada celda de un mapa en una ejecución
+ */
+typedef struct {
+  char name[256];                 ///< Nombre del mapa ("" si se generó)
+  int nrow, ncol;                 ///< Dimensiones del mapa
+  uint64_t map_hash;              ///< sim_world_hash() del mapa inicial
+  uint32_t ticks;                 ///< Ticks de la ejecución (suma de robots)
+  uint32_t cell_visited;          ///< Celdas distintas visitadas
+  uint32_t *visits;               ///< Visitas por celda (nrow*ncol, row-major)
+} heatmap_t;
+
+/**
+ * @brief Añade un registro a un archivo de mapas de calor
+ * @param path Ruta del archivo
+ * @param h Registro a escribir
+ * @return 0 si OK, -1 si error
+ */
+int heatmap_append(const char *path, const heatmap_t *h);
+
+/**
+ * @brief Lee el siguiente registro de un archivo de mapas de calor
+ * @param file Archivo abierto en modo binario
+ * @param h Registro a rellenar; h->visits se reserva o amplía según el
+ *          tamaño del mapa (empezar con {0} y liberar con free())
+ * @return 1 si ha leído un registro, 0 al final del archivo, -1 si error
+ */
+int heatmap_read(FILE *file, heatmap_t *h);
+
+/**
+ * @brief Añade el mapa de calor de la ejecución a heatmap.bin
+ * @param h Registro a escribir
+ */
+void save_heatmap(const heatmap_t *h);
+
 /**
  * @brief Guarda las estadísticas finales en stats.csv
  * @param st Puntero a la estructura de estadísticas
  */
 void save_stats(const struct _stat *st);
 
+/**
+ * @brief Guarda las estadísticas de varios robots en stats.csv
+ * @param robots Estadísticas de cada robot
+ * @param n Número de robots
+ * @param fleet Estadísticas del conjunto (sim_team_stats)
+ *
+ * Igual que save_stats() añade una fila por ejecución: la del conjunto,
+ * con el formato de save_stats(), para que el runner y score la lean como
+ * la de un solo robot.
+ */
+void save_team_stats(const struct _stat *robots, int n,
+                     const struct _stat *fleet);
+
 /* ============================================================================
  * MÓDULO: MUNDO (sim_world.c)
  * ============================================================================ */
 
+/**
+ * @brief Añade un cambio a un diario
+ * @param j Diario activo
+ * @param idx Índice row-major de la celda
+ * @param old Valor anterior de la celda
+ *
+ * Si no hay memoria el diario se marca como fallido (j->failed).
+ */
+void sim_journal_push(journal_t *j, size_t idx, cell_t old);
+
+/**
+ * @brief Libera un diario y lo desactiva
+ * @param j Diario
+ */
+void sim_journal_reset(journal_t *j);
+
+/**
+ * @brief Inicializa un generador PCG32
+ * @param rng Generador
+ * @param seed Semilla
+ * @param stream Flujo (SIM_RNG_*); flujos distintos son independientes
+ */
+void sim_rng_seed(sim_rng_t *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Siguiente número de 32 bits
+ * @param rng Generador
+ * @return Valor uniforme en [0, 2^32)
+ */
+uint32_t sim_rng_next(sim_rng_t *rng);
+
+/**
+ * @brief Entero uniforme en [0, n)
+ * @param rng Generador
+ * @param n Límite superior (> 0)
+ * @return Valor en [0, n)
+ */
+int sim_rng_below(sim_rng_t *rng, int n);
+
+/**
+ * @brief Real uniforme en [0, 1)
+ * @param rng Generador
+ * @return Valor en [0, 1)
+ */
+float sim_rng_unit(sim_rng_t *rng);
+
+/**
+ * @brief Reserva las celdas de un mapa de nrow x ncol
+ * @param m Puntero al mapa
+ * @param nrow Número de filas
+ * @param ncol Número de columnas
+ * @return 0 si OK, -1 si las dimensiones no son válidas o no hay memoria
+ *
+ * Reutiliza la memoria existente si el tamaño no cambia. Vacía la lista
+ * de suciedad; el contenido de las celdas queda sin inicializar.
+ */
+int sim_world_alloc(map_t* m, int nrow, int ncol);
+
+/**
+ * @brief Libera la memoria dinámica de un mapa
+ * @param m Puntero al mapa
+ */
+void sim_world_free(map_t* m);
+
+/**
+ * @brief Construye el índice disperso de celdas sucias
+ * @param m Puntero al mapa
+ * @return Número de celdas sucias, o -1 si no hay memoria
+ *
+ * El índice refleja el estado de las celdas en el momento de construirlo
+ * y se descarta al recargar o regenerar el mapa.
+ */
+int sim_world_dirt_index(map_t* m);
+
+/**
+ * @brief Memoria ocupada por un mapa
+ * @param m Puntero al mapa
+ * @return Bytes de la estructura, las celdas y el índice de suciedad
+ */
+size_t sim_world_footprint(const map_t* m);
+
+/**
+ * @brief Carácter ASCII con el que se representa una celda
+ * @param c Celda codificada
+ * @return WALL, EMPTY, 'B' o el dígito de su nivel de suciedad
+ */
+char sim_world_cell_char(cell_t c);
+
 /**
  * @brief Genera un mapa aleatorio
  * @param m Puntero al mapa a generar
@@ -232,12 +981,14 @@ void save_stats(const struct _stat *st);
  * @param ncol Número de columnas
  * @param num_dirty Número de celdas sucias
  * @param nobs Densidad de obstáculos (0.0 a 1.0)
+ * @param rng Generador pseudoaleatorio
  * @return 0 si OK, -1 si error
  */
-int sim_world_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs);
+int sim_world_generate(map_t* m, int nrow, int ncol, int num_dirty, float nobs,
+                       sim_rng_t *rng);
 
 /**
- * @brief Carga un mapa desde un archivo PGM
+ * @brief Carga un mapa desde un archivo PGM (P2 o P5)
  * @param m Puntero al mapa
  * @param filename Ruta del archivo
  * @return 0 si OK, -1 si error
@@ -250,6 +1001,53 @@ int sim_world_load(map_t* m, char *filename);
  */
 void sim_world_save(const map_t* m);
 
+/**
+ * @brief Escribe un mapa en un archivo PGM
+ * @param m Puntero al mapa
+ * @param filename Ruta del archivo destino
+ * @param binary 0 para P2 (texto), distinto de 0 para P5 (binario)
+ * @return 0 si OK, -1 si error
+ */
+int sim_world_write_pgm(const map_t* m, const char *filename, int binary);
+
+/**
+ * @brief Hash FNV-1a de 64 bits de las dimensiones y celdas de un mapa
+ * @param m Puntero al mapa
+ * @return Hash del mapa
+ */
+uint64_t sim_world_hash(const map_t* m);
+
+/**
+ * @brief Copia un mapa sobre otro reutilizando su memoria
+ * @param dst Mapa destino
+ * @param src Mapa origen
+ * @return 0 si OK, -1 si no hay memoria
+ */
+int sim_world_copy(map_t* dst, const map_t* src);
+
+/**
+ * @brief Carga un mapa usando la caché de plantillas
+ * @param m Puntero al mapa
+ * @param filename Ruta del archivo PGM
+ * @return 0 si OK, -1 si error
+ *
+ * Cada archivo (ruta + fecha de modificación) se parsea una sola vez por
+ * proceso; las cargas siguientes copian las celdas de la plantilla.
+ */
+int sim_world_load_cached(map_t* m, const char *filename);
+
+/**
+ * @brief Parsea un mapa y lo deja en la caché sin cargarlo
+ * @param filename Ruta del archivo PGM
+ * @return 0 si OK, -1 si error
+ */
+int sim_world_cache_preload(const char *filename);
+
+/**
+ * @brief Libera todas las plantillas de la caché de mapas
+ */
+void sim_world_cache_clear(void);
+
 /**
  * @brief Coloca la base en una posición específica
  * @param m Puntero al mapa
@@ -259,14 +1057,25 @@ void sim_world_save(const map_t* m);
  */
 float sim_world_put_base(map_t* m, int x, int y);
 
+/**
+ * @brief Orientación inicial del robot en una base
+ * @param m Puntero al mapa
+ * @param x Columna de la base
+ * @param y Fila de la base
+ * @return Ángulo en radianes, perpendicular a la pared de la base
+ */
+float sim_world_base_heading(const map_t* m, int x, int y);
+
 /**
  * @brief Establece la posición inicial del robot en la base
  * @param m Puntero al mapa
  * @param x Puntero donde guardar la columna inicial
  * @param y Puntero donde guardar la fila inicial
  * @param h Puntero donde guardar la orientación inicial
+ * @param rng Generador para colocar la base si el mapa no tiene
  */
-void sim_world_set_base_origin(map_t* m, int *x, int *y, float *h);
+void sim_world_set_base_origin(map_t* m, int *x, int *y, float *h,
+                               sim_rng_t *rng);
 
 /**
  * @brief Verifica si una celda es un obstáculo
@@ -317,7 +1126,257 @@ int sim_world_clean_cell(map_t* m, int y, int x);
  * MÓDULO: ROBOT (sim_robot.c)
  * ============================================================================ */
 
-/* Las funciones del robot están declaradas en simula.h (API pública) */
+#define STEP_LUT_SIZE 17              ///< Orientaciones k*M_PI_8, k = 0..16
+
+/**
+ * @brief Paso precalculado para las orientaciones cercanas a k*M_PI_8
+ *
+ * Los giros acumulados en float dejan la orientación a unos pocos ulps del
+ * múltiplo exacto de M_PI_8. [lo, hi] es el intervalo de floats alrededor de
+ * k*M_PI_8 para los que rounda(cos/sin) da exactamente los mismos bits que
+ * dx/dy, de modo que usar la tabla no cambia ninguna trayectoria.
+ */
+typedef struct {
+  float lo, hi;                   ///< Orientaciones cubiertas por la entrada
+  float dx, dy;                   ///< Desplazamiento continuo
+  int diagonal;                   ///< 1 si el paso es diagonal
+} step_lut_t;
+
+/**
+ * @brief Tabla de pasos (STEP_LUT_SIZE entradas, de solo lectura)
+ * @return Puntero a la primera entrada
+ */
+const step_lut_t* sim_robot_step_lut(void);
+
+/**
+ * @brief Desplazamiento de un paso hacia delante
+ * @param heading Orientación en radianes
+ * @param dx Puntero para almacenar desplazamiento x continuo
+ * @param dy Puntero para almacenar desplazamiento y continuo
+ * @return 1 si el paso es diagonal, 0 si no
+ */
+int sim_robot_step(float heading, float *dx, float *dy);
+
+/* Las funciones rmb_* de simula.h son envoltorios sobre el contexto activo.
+ * Las variantes rmb_ctx_* reciben el contexto de forma explícita. */
+
+/** @brief Variante con contexto de rmb_awake() */
+int rmb_ctx_awake(sim_ctx_t *ctx, int *x, int *y);
+/** @brief Variante con contexto de rmb_turn() */
+void rmb_ctx_turn(sim_ctx_t *ctx, float alpha);
+/** @brief Variante con contexto de rmb_forward() */
+void rmb_ctx_forward(sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_forward_until() */
+int rmb_ctx_forward_until(sim_ctx_t *ctx, int until, int n);
+/** @brief Variante con contexto de rmb_clean() */
+void rmb_ctx_clean(sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_load() */
+int rmb_ctx_load(sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_state() */
+sensor_t rmb_ctx_state(const sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_bumper() */
+int rmb_ctx_bumper(const sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_ifr() */
+int rmb_ctx_ifr(const sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_battery() */
+float rmb_ctx_battery(const sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_at_base() */
+int rmb_ctx_at_base(const sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_rand() */
+unsigned int rmb_ctx_rand(sim_ctx_t *ctx);
+/** @brief Variante con contexto de rmb_id() */
+int rmb_ctx_id(const sim_ctx_t *ctx);
+
+/* ============================================================================
+ * MÓDULO: EQUIPO (sim_team.c)
+ * ============================================================================ */
+
+#define SIM_TEAM_MAX 16           ///< Robots por simulación, incluido el de configure()
+
+/**
+ * @brief Varios robots que limpian un mismo mapa
+ *
+ * Cada robot es un contexto completo (comportamiento, sensores,
+ * estadísticas, historial y generador propios). Los de sim_team_add()
+ * comparten las celdas del mapa del dueño (robot[0]): la suciedad que
+ * limpia uno desaparece para todos, y un robot choca contra la celda que
+ * ocupa otro igual que contra un muro, salvo en la base, que admite
+ * varios robots a la vez.
+ */
+typedef struct _sim_team{
+  sim_ctx_t *robot[SIM_TEAM_MAX]; ///< Contextos de los robots, en orden de turno
+  int n;                          ///< Número de robots
+  unsigned char *occupied;        ///< Robots en cada celda (nrow*ncol, row-major)
+  size_t occupied_len;            ///< Número de celdas de occupied
+} sim_team_t;
+
+/**
+ * @brief Añade un robot que comparte el mapa de otro contexto
+ * @param owner Contexto ya configurado (sim_ctx_configure) dueño del mapa
+ * @param start Función de inicialización del nuevo robot (puede ser NULL)
+ * @param beh Función de comportamiento del nuevo robot (obligatoria)
+ * @param stop Función de finalización del nuevo robot (puede ser NULL)
+ * @return Índice del robot (1 a SIM_TEAM_MAX-1), o -1 si error
+ *
+ * El nuevo contexto toma el tiempo de ejecución y la semilla del dueño;
+ * su rmb_rand() usa un flujo propio.
+ */
+int sim_team_add(sim_ctx_t *owner, void (*start)(), void (*beh)(),
+                 void (*stop)());
+
+/**
+ * @brief Libera los robots añadidos y el equipo de un contexto
+ * @param owner Contexto dueño del mapa (sin equipo no hace nada)
+ */
+void sim_team_destroy(sim_ctx_t *owner);
+
+/**
+ * @brief Ejecuta todos los robots del equipo hasta que terminen
+ * @param owner Contexto dueño del mapa
+ *
+ * Llama a on_start de cada robot y después, en cada vuelta, a exec_beh de
+ * cada robot que siga activo, siempre en orden de índice. Cada robot
+ * termina por su cuenta (tiempo o batería), como en sim_ctx_run().
+ */
+void sim_team_run(sim_ctx_t *owner);
+
+/**
+ * @brief Comprueba si otro robot del equipo ocupa una celda
+ * @param ctx Contexto del robot que se mueve
+ * @param y Fila
+ * @param x Columna
+ * @return 1 si la celda está ocupada (y no es la base), 0 si no
+ */
+int sim_team_blocked(const sim_ctx_t *ctx, int y, int x);
+
+/**
+ * @brief Anota en el equipo que un robot se coloca en una celda
+ * @param ctx Contexto del robot
+ * @param y Fila de destino
+ * @param x Columna de destino
+ *
+ * Se llama antes de cambiar la posición del sensor: si el robot ya tenía
+ * una celda (timer > 0), la deja libre.
+ */
+void sim_team_move(sim_ctx_t *ctx, int y, int x);
+
+/**
+ * @brief Estadísticas del conjunto de robots
+ * @param owner Contexto dueño del mapa
+ * @param st Estructura a rellenar
+ *
+ * Suma movimientos, batería y suciedad limpiada; cell_visited cuenta las
+ * celdas que ha pisado al menos un robot y bat_mean es la media de la
+ * batería sobre los ticks de todos los robots.
+ */
+void sim_team_stats(const sim_ctx_t *owner, struct _stat *st);
+
+/* ============================================================================
+ * MÓDULO: CICLOS (sim_cycle.c)
+ * ============================================================================ */
+
+#define SIM_CYCLE_STATE_MAX 256       ///< Bytes máximos del estado declarado
+#define SIM_CYCLE_MAX_CALLS 32768     ///< Llamadas vigiladas antes de rendirse
+
+/**
+ * @brief Situación del robot antes de una llamada al comportamiento
+ *
+ * Todo lo que ve un comportamiento que cumple el contrato de
+ * rmb_declare_state(), salvo el estado declarado, que va aparte.
+ */
+typedef struct {
+  float precise_x, precise_y;     ///< Posición continua
+  int x, y;                       ///< Celda
+  float heading;                  ///< Orientación
+  int bumper;                     ///< Bumper
+  int infrared;                   ///< Infrarrojo
+  int dirt_cleaned;               ///< Versión de la suciedad del mapa
+} cycle_key_t;
+
+/**
+ * @brief Una llamada al comportamiento vigilada
+ */
+typedef struct {
+  uint64_t hash;                  ///< Hash de key y del estado declarado
+  cycle_key_t key;                ///< Situación antes de la llamada
+  size_t state;                   ///< Copia del estado declarado en states
+  size_t pos;                     ///< Acciones de la llamada desde tape[pos]
+  int timer;                      ///< Tick antes de la llamada
+} cycle_entry_t;
+
+/**
+ * @brief Detector de ciclos de un contexto
+ *
+ * Antes de cada llamada al comportamiento busca la situación actual entre
+ * las anteriores (tabla hash abierta sobre entry). Si ya se vio, con algún
+ * tick entre medias y sin limpiar nada, el comportamiento repetiría las
+ * mismas llamadas: a partir de ahí el detector las repite él mismo desde
+ * tape, con las mismas funciones rmb_ctx_*, sin ejecutar código del equipo,
+ * y deja en state el valor que tendría el comportamiento en cada llamada.
+ */
+typedef struct _sim_cycle{
+  void *state;                    ///< Estado declarado (memoria del equipo)
+  int size;                       ///< Bytes de state
+  int off;                        ///< 1 si la detección está desactivada
+  int replay;                     ///< 1 si se está repitiendo el ciclo
+  int first;                      ///< Primera llamada del ciclo
+  int next;                       ///< Siguiente llamada a repetir
+  int period;                     ///< Ticks de una vuelta del ciclo
+  action_log_t tape;              ///< Acciones de todas las llamadas vigiladas
+  cycle_entry_t *entry;           ///< Llamadas vigiladas, en orden
+  int n, cap;                     ///< Llamadas usadas / reservadas
+  unsigned char *states;          ///< Copias del estado declarado
+  uint32_t *slot;                 ///< Índice hash: entrada + 1, 0 = libre
+  uint32_t nslot;                 ///< Huecos del índice (potencia de 2)
+} sim_cycle_t;
+
+/**
+ * @brief Declara el estado del comportamiento y activa la detección
+ * @param ctx Contexto de simulación
+ * @param state Variables del comportamiento (NULL si size es 0)
+ * @param size Bytes de state (0 a SIM_CYCLE_STATE_MAX)
+ * @return 0 si OK, -1 si el tamaño no es válido o no hay memoria
+ */
+int sim_cycle_declare(sim_ctx_t *ctx, void *state, int size);
+
+/**
+ * @brief Olvida las llamadas vigiladas al empezar una ejecución
+ * @param ctx Contexto de simulación
+ *
+ * Mantiene el estado declarado y vuelve a activar la detección.
+ */
+void sim_cycle_reset(sim_ctx_t *ctx);
+
+/**
+ * @brief Desactiva la detección hasta la siguiente ejecución
+ * @param ctx Contexto de simulación
+ *
+ * La usan las lecturas que rompen el contrato (rmb_battery, rmb_rand) y
+ * sim_restore().
+ */
+void sim_cycle_taint(sim_ctx_t *ctx);
+
+/**
+ * @brief Anota una acción de la llamada en curso
+ * @param ctx Contexto de simulación
+ * @param action Código de la acción
+ * @param alpha Ángulo (solo con TURN)
+ */
+void sim_cycle_record(sim_ctx_t *ctx, int action, float alpha);
+
+/**
+ * @brief Paso del detector antes de una llamada al comportamiento
+ * @param ctx Contexto de simulación
+ * @return 1 si ha repetido una llamada del ciclo (no hay que llamar al
+ *         comportamiento), 0 si hay que llamarlo
+ */
+int sim_cycle_step(sim_ctx_t *ctx);
+
+/**
+ * @brief Libera el detector de un contexto
+ * @param ctx Contexto de simulación
+ */
+void sim_cycle_destroy(sim_ctx_t *ctx);
 
 /* ============================================================================
  * MÓDULO: VISUALIZACIÓN (sim_visual.c)
@@ -328,6 +1387,12 @@ int sim_world_clean_cell(map_t* m, int y, int x);
  */
 void visualize(void);
 
+/**
+ * @brief Variante con contexto de visualize()
+ * @param ctx Contexto de simulación a visualizar
+ */
+void sim_ctx_visualize(sim_ctx_t *ctx);
+
 /* ============================================================================
  * EXPORTS FOR COMPETITION EXTENSIONS
  * ============================================================================ */
@@ -339,21 +1404,9 @@ extern "C" {
 /**
  * @brief Exported symbols for competition_ext.c
  * 
- * These allow competition extensions to access core simulator state
- * and functions without modifying simula.c.
- */
-
-// Core state (already declared above, but ensuring visibility)
-// extern map_t map;
-// extern robot_t r;
-// extern sensor_t *hist;
-// extern config_t config;
-// extern int timer;
-
-/**
- * @brief Statistics structure (for competition stats export)
+ * Competition extensions access the core simulator state through
+ * sim_ctx_current() (see MÓDULO: CORE) instead of process-wide globals.
  */
-extern struct _stat stats;
 
 /**
  * @brief Load a map from file (needed by competition_ext.c)
@@ -0,0 +1,55 @@
+/**
+ * Comportamiento de prueba: giros fuera de la rejilla de 16 orientaciones
+ *
+ * Rebota contra los muros girando ángulos que casi nunca son múltiplos de
+ * M_PI_8, para que la prueba dorada recorra el cálculo exacto del paso con
+ * sin/cos y no solo la tabla de pasos. También gira múltiplos de M_PI_4
+ * (vuelve a la rejilla desde cualquier orientación) y ángulos mayores que
+ * 2π en ambos sentidos (el fmod de rmb_turn()).
+ *
+ * Los ángulos salen de un generador propio con semilla fija, así que la
+ * trayectoria solo depende del mapa.
+ */
+
+#include "simula.h"
+#include <math.h>
+
+static unsigned int semilla = 12345;
+
+/**
+ * @brief Siguiente número pseudoaleatorio (0..32767), independiente de rand()
+ */
+static int siguiente() {
+    semilla = semilla * 1103515245u + 12345u;
+    return (semilla >> 16) & 0x7fff;
+}
+
+void inicializar() {
+    int x, y;
+    rmb_awake(&x, &y);
+}
+
+void comportamiento() {
+    if (rmb_ifr() > 0) {
+        rmb_clean();
+    } else if (!rmb_bumper()) {
+        rmb_forward();
+    } else {
+        switch (siguiente() % 5) {
+            case 0: rmb_turn((siguiente() % 360) * M_PI / 180); break;
+            case 1: rmb_turn(-(siguiente() % 1000) / 137.0f); break;
+            case 2: rmb_turn(M_PI_4 * (1 + siguiente() % 8)); break;
+            case 3: rmb_turn(7.5f); break;
+            default: rmb_turn(-7.0f); break;
+        }
+    }
+}
+
+void finalizar() {
+}
+
+int main() {
+    configure(inicializar, comportamiento, finalizar, 3000);
+    run();
+    return 0;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file golden_main.c
+ * @brief Punto de entrada de los ejemplos en la prueba de trazas doradas
+ *
+ * Cada ejemplo se compila con -Dmain=sample_main y se enlaza con este
+ * fichero, que carga el mapa recibido como argumento antes de ceder el
+ * control al main() del ejemplo. Así todos los ejemplos se ejecutan sobre
+ * los mapas fijos de maps/ en lugar de uno generado al azar.
+ *
+ * Uso:
+ *   ROOMBA_SEED=<semilla> ./<ejemplo> mapa.pgm
+ */
+
+#include "simula.h"
+#include <stdio.h>
+
+int sample_main();
+
+/**
+ * @brief Carga el mapa y ejecuta el ejemplo
+ * @param argc Número de argumentos
+ * @param argv Argumentos (argv[1] = mapa .pgm)
+ * @return Código de salida del ejemplo, o 1 si el mapa no se puede cargar
+ */
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Uso: %s mapa.pgm\n", argv[0]);
+    return 1;
+  }
+  if (load_map(argv[1]) != 0)
+    return 1;
+  return sample_main();
+}
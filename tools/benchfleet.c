@@ -0,0 +1,224 @@
+/**
+ * @file benchfleet.c
+ * @brief Lockstep fleet benchmark for Roomba simulator
+ *
+ * Runs K robots with a parametrised bounce-and-clean behaviour on one map,
+ * first one after another through sim_ctx_t (the normal simulator path)
+ * and then together through sim_fleet_t, checks that every robot ends
+ * with the same sensors and statistics in both engines, and reports
+ * ticks per second for K = 1, 8, 64, 512 and 4096.
+ *
+ * Compilation:
+ *   make benchfleet (from tools/)
+ *
+ * Usage:
+ *   ./tools/benchfleet [map.pgm] [max_robots]
+ */
+
+#include "../simula_internal.h"
+#include "sim_fleet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_EXEC_TIME COMPETITION_EXEC_TIME ///< Ticks por robot
+#define BENCH_MIN_TICKS 4000000L              ///< Ticks mínimos por medida
+
+static float bench_theta;       ///< Ángulo de giro del robot secuencial en curso
+
+/**
+ * @brief Current monotonic time in seconds
+ * @return Seconds
+ */
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Turn angle tried by robot k (the parameter being tuned)
+ * @param k Robot index
+ * @return Angle in radians
+ */
+static float theta_of(int k) {
+  return (float)(M_PI_8 * (1 + k % 15));
+}
+
+/**
+ * @brief Start callback for the sequential engine
+ */
+static void bench_start(void) {
+  int x, y;
+  rmb_awake(&x, &y);
+}
+
+/**
+ * @brief Behaviour for the sequential engine: clean, bounce or advance
+ */
+static void bench_beh(void) {
+  if (rmb_ifr() > 0)
+    rmb_clean();
+  else if (rmb_bumper())
+    rmb_turn(bench_theta);
+  else
+    rmb_forward();
+}
+
+/**
+ * @brief Same behaviour as bench_beh() for every robot of a fleet
+ * @param f Fleet
+ * @param action Action of each robot (output); turns use each robot's theta
+ */
+static void fleet_policy(const sim_fleet_t *f, unsigned char *action) {
+  for (int k = 0; k < f->n; k++)
+    action[k] = f->infrared[k] > 0 ? CLEAN : f->bumper[k] ? TURN : FWD;
+}
+
+/**
+ * @brief Run n robots one after another through sim_ctx_t
+ * @param map Map path
+ * @param n Number of robots
+ * @param state Final sensors of each robot (output)
+ * @param stats Final statistics of each robot (output)
+ * @return Total ticks, or -1 on error
+ */
+static long run_sequential(const char *map, int n, sensor_t *state,
+                           struct _stat *stats) {
+  long ticks = 0;
+  for (int k = 0; k < n; k++) {
+    sim_ctx_t *ctx = sim_ctx_create();
+    if (!ctx || sim_ctx_load_map(ctx, (char *)map) != 0 ||
+        sim_ctx_configure(ctx, bench_start, bench_beh, NULL,
+                          BENCH_EXEC_TIME) != 0) {
+      sim_ctx_destroy(ctx);
+      return -1;
+    }
+    bench_theta = theta_of(k);
+    sim_ctx_run(ctx);
+    state[k] = rmb_ctx_state(ctx);
+    stats[k] = *stats_get(ctx);
+    ticks += ctx->timer;
+    sim_ctx_destroy(ctx);
+  }
+  return ticks;
+}
+
+/**
+ * @brief Run n robots in lockstep through sim_fleet_t
+ * @param map Loaded map
+ * @param n Number of robots
+ * @param state Final sensors of each robot (output)
+ * @param stats Final statistics of each robot (output)
+ * @return Total ticks, or -1 on error
+ */
+static long run_fleet(const map_t *map, int n, sensor_t *state,
+                      struct _stat *stats) {
+  sim_fleet_t *f = sim_fleet_create(map, n, BENCH_EXEC_TIME);
+  unsigned char *action = malloc(n);
+  float *theta = malloc(n * sizeof(float));
+  if (!f || !action || !theta) {
+    sim_fleet_destroy(f);
+    free(action);
+    free(theta);
+    return -1;
+  }
+  for (int k = 0; k < n; k++)
+    theta[k] = theta_of(k);
+
+  do
+    fleet_policy(f, action);
+  while (sim_fleet_step(f, action, theta) > 0);
+
+  long ticks = 0;
+  for (int k = 0; k < n; k++) {
+    state[k] = sim_fleet_state(f, k);
+    sim_fleet_stats(f, k, &stats[k]);
+    ticks += f->timer[k];
+  }
+  sim_fleet_destroy(f);
+  free(action);
+  free(theta);
+  return ticks;
+}
+
+/**
+ * @brief Benchmark main function
+ * @param argc Argument count
+ * @param argv Arguments: [map.pgm] [max_robots]
+ * @return 0 on OK, 1 on error or mismatch
+ */
+int main(int argc, char *argv[]) {
+  static const int sizes[] = {1, 8, 64, 512, 4096};
+  const char *path = argc > 1 ? argv[1] : "maps/random1.pgm";
+  int max_robots = argc > 2 ? atoi(argv[2]) : 4096;
+
+  map_t map = {0};
+  if (sim_world_load(&map, (char *)path) != 0) {
+    fprintf(stderr, "Error: Cannot load map %s\n", path);
+    return 1;
+  }
+
+  printf("Map %s (%dx%d), %d ticks per robot\n", path, map.ncol, map.nrow,
+         BENCH_EXEC_TIME);
+  printf("%-7s %10s %14s %14s %8s\n", "Robots", "Ticks", "ctx Mticks/s",
+         "fleet Mticks/s", "Speedup");
+  int rc = 0;
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    int n = sizes[s];
+    if (n > max_robots)
+      break;
+    sensor_t *st_seq = malloc(n * sizeof(sensor_t));
+    sensor_t *st_fleet = malloc(n * sizeof(sensor_t));
+    struct _stat *stat_seq = malloc(n * sizeof(struct _stat));
+    struct _stat *stat_fleet = malloc(n * sizeof(struct _stat));
+    if (!st_seq || !st_fleet || !stat_seq || !stat_fleet) {
+      fprintf(stderr, "Error: Out of memory\n");
+      rc = 1;
+      break;
+    }
+
+    // Repetir hasta reunir BENCH_MIN_TICKS para que la medida sea estable
+    long ticks = 0, seq_ticks = 0, fleet_ticks = 0;
+    double seq_s = 0, fleet_s = 0;
+    do {
+      double t0 = now_s();
+      ticks = run_sequential(path, n, st_seq, stat_seq);
+      double t1 = now_s();
+      long ft = run_fleet(&map, n, st_fleet, stat_fleet);
+      double t2 = now_s();
+      if (ticks < 0 || ft != ticks) {
+        fprintf(stderr, "Error: Run failed for %d robots\n", n);
+        rc = 1;
+        break;
+      }
+      seq_ticks += ticks;
+      fleet_ticks += ft;
+      seq_s += t1 - t0;
+      fleet_s += t2 - t1;
+    } while (seq_ticks < BENCH_MIN_TICKS);
+
+    for (int k = 0; rc == 0 && k < n; k++) {
+      if (memcmp(&st_seq[k], &st_fleet[k], sizeof(sensor_t)) != 0 ||
+          memcmp(&stat_seq[k], &stat_fleet[k], sizeof(struct _stat)) != 0) {
+        fprintf(stderr, "Error: Robot %d differs between engines\n", k);
+        rc = 1;
+      }
+    }
+    if (rc == 0)
+      printf("%-7d %10ld %14.2f %14.2f %7.1fx\n", n, ticks,
+             seq_ticks / seq_s / 1e6, fleet_ticks / fleet_s / 1e6,
+             seq_s / fleet_s);
+    free(st_seq);
+    free(st_fleet);
+    free(stat_seq);
+    free(stat_fleet);
+    if (rc)
+      break;
+  }
+
+  sim_world_free(&map);
+  sim_world_cache_clear();
+  return rc;
+}
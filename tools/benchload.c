@@ -0,0 +1,165 @@
+/**
+ * @file benchload.c
+ * @brief Map loading microbenchmark for Roomba simulator
+ *
+ * Generates square maps from 50x50 up to 4096x4096, saves each one as
+ * P2 (text) and P5 (binary) PGM and measures the average load time of:
+ *  - the previous loader (one fscanf per cell, one fgets per row),
+ *  - map_load() on the P2 file,
+ *  - map_load() on the P5 file.
+ *
+ * Compilation:
+ *   make benchload (from tools/)
+ *
+ * Usage:
+ *   ./tools/benchload [max_size]
+ */
+
+#include "../sim_world_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_CELLS_PER_SIZE 20000000L  ///< Celdas a cargar por tamaño
+#define BENCH_MIN_REPS 3                ///< Repeticiones mínimas
+#define BENCH_MAX_REPS 200              ///< Repeticiones máximas
+
+/**
+ * @brief Current monotonic time in seconds
+ * @return Seconds
+ */
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Reference loader: the per-cell fscanf parser used before P5 support
+ * @param filename P2 map path
+ * @return 0 on OK, -1 on error
+ */
+static int legacy_load(const char *filename) {
+  char line[256];
+  int nrow, ncol, aux;
+  FILE *fd = fopen(filename, "r");
+  if (!fd)
+    return -1;
+  (void)fgets(line, sizeof(line), fd);
+  (void)fgets(line, sizeof(line), fd);
+  (void)fscanf(fd, "%d%d", &ncol, &nrow);
+  (void)fscanf(fd, "%d", &aux);
+  unsigned char *cells = malloc((size_t)nrow * ncol);
+  if (!cells) {
+    fclose(fd);
+    return -1;
+  }
+  for (int i = 0; i < nrow; i++) {
+    for (int j = 0; j < ncol; j++) {
+      int cell = 0;
+      (void)fscanf(fd, "%d", &cell);
+      cells[(size_t)i * ncol + j] = (unsigned char)cell;
+    }
+    (void)fgets(line, sizeof(line), fd);
+  }
+  free(cells);
+  fclose(fd);
+  return 0;
+}
+
+/**
+ * @brief Average time of one map_load() call
+ * @param m Map to load into
+ * @param filename Map path
+ * @param reps Repetitions
+ * @return Milliseconds per load, or -1 on error
+ */
+static double time_map_load(map_t *m, const char *filename, int reps) {
+  double t0 = now_s();
+  for (int r = 0; r < reps; r++)
+    if (map_load(m, filename) != 0)
+      return -1;
+  return (now_s() - t0) * 1000.0 / reps;
+}
+
+/**
+ * @brief Average time of one legacy_load() call
+ * @param filename Map path
+ * @param reps Repetitions
+ * @return Milliseconds per load, or -1 on error
+ */
+static double time_legacy_load(const char *filename, int reps) {
+  double t0 = now_s();
+  for (int r = 0; r < reps; r++)
+    if (legacy_load(filename) != 0)
+      return -1;
+  return (now_s() - t0) * 1000.0 / reps;
+}
+
+/**
+ * @brief Benchmark main function
+ * @param argc Argument count
+ * @param argv Arguments: [max_size]
+ * @return 0 on OK, 1 on error
+ */
+int main(int argc, char *argv[]) {
+  static const int sizes[] = {50, 128, 256, 512, 1024, 2048, 4096};
+  int max_size = argc > 1 ? atoi(argv[1]) : 4096;
+  char dir[] = "/tmp/benchloadXXXXXX";
+  char p2[64], p5[64];
+
+  if (!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  snprintf(p2, sizeof(p2), "%s/map_p2.pgm", dir);
+  snprintf(p5, sizeof(p5), "%s/map_p5.pgm", dir);
+
+  map_t *m = map_create();
+  if (!m) {
+    fprintf(stderr, "Error: Cannot create map structure\n");
+    return 1;
+  }
+  srand(1);
+
+  printf("%-11s %5s %12s %12s %12s %10s %10s\n", "Size", "Reps",
+         "legacy ms", "P2 ms", "P5 ms", "P2 gain", "P5 gain");
+  int rc = 0;
+  for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+    int n = sizes[k];
+    if (n > max_size)
+      break;
+    if (map_generate(m, n, n, n * n / 50, 0.03f) != 0 ||
+        map_save(m, p2) != 0 || map_save_binary(m, p5) != 0) {
+      fprintf(stderr, "Error: Cannot prepare %dx%d map\n", n, n);
+      rc = 1;
+      break;
+    }
+    long reps = BENCH_CELLS_PER_SIZE / ((long)n * n);
+    if (reps < BENCH_MIN_REPS)
+      reps = BENCH_MIN_REPS;
+    if (reps > BENCH_MAX_REPS)
+      reps = BENCH_MAX_REPS;
+
+    double legacy = time_legacy_load(p2, (int)reps);
+    double t2 = time_map_load(m, p2, (int)reps);
+    double t5 = time_map_load(m, p5, (int)reps);
+    if (legacy < 0 || t2 < 0 || t5 < 0) {
+      fprintf(stderr, "Error: Cannot load %dx%d map\n", n, n);
+      rc = 1;
+      break;
+    }
+    char label[32];
+    snprintf(label, sizeof(label), "%dx%d", n, n);
+    printf("%-11s %5ld %12.3f %12.3f %12.3f %9.1fx %9.1fx\n", label, reps,
+           legacy, t2, t5, legacy / t2, legacy / t5);
+  }
+
+  map_destroy(m);
+  unlink(p2);
+  unlink(p5);
+  rmdir(dir);
+  return rc;
+}
@@ -9,7 +9,7 @@
  *   make tools (from root)
  *
  * Usage:
- *   ./tools/generate
+ *   ./tools/generate [nrow ncol]
  */
 
 #include "../sim_world_api.h"
@@ -24,11 +24,23 @@
  * @brief Map generator main function
  *
  * Creates several test maps with different obstacle and dirt configurations,
- * and saves them to the 'maps' directory.
+ * and saves them to the 'maps' directory. The map size defaults to
+ * WORLDSIZE x WORLDSIZE and can be given as two optional arguments.
  *
+ * @param argc Number of arguments
+ * @param argv Arguments: [nrow ncol]
  * @return 0 on OK, 1 on error
  */
-int main(void) {
+int main(int argc, char *argv[]) {
+  int nrow = WORLDSIZE, ncol = WORLDSIZE;
+  if (argc == 3) {
+    nrow = atoi(argv[1]);
+    ncol = atoi(argv[2]);
+  }
+  if ((argc != 1 && argc != 3) || nrow < 10 || ncol < 10) {
+    fprintf(stderr, "Usage: %s [nrow ncol]  (minimum 10x10)\n", argv[0]);
+    return 1;
+  }
   srand(time(NULL));
 
   // Crear directorio maps si no existe
@@ -52,23 +64,23 @@ int main(void) {
 
   // Mapa 1: Sin obstáculos, solo suciedad
   printf("Map 1: No obstacles...\n");
-  map_generate(m, WORLDSIZE, WORLDSIZE, 50, 0);
+  map_generate(m, nrow, ncol, 50, 0);
   if (map_save(m, "maps/noobs.pgm") != 0)
     success = 0;
 
   // Mapas 2-4: Obstáculos dispersos con diferentes densidades
   printf("Map 2: Random obstacles (low density)...\n");
-  map_generate(m, WORLDSIZE, WORLDSIZE, 50, 0.01);
+  map_generate(m, nrow, ncol, 50, 0.01);
   if (map_save(m, "maps/random1.pgm") != 0)
     success = 0;
 
   printf("Map 3: Random obstacles (medium density)...\n");
-  map_generate(m, WORLDSIZE, WORLDSIZE, 50, 0.03);
+  map_generate(m, nrow, ncol, 50, 0.03);
   if (map_save(m, "maps/random3.pgm") != 0)
     success = 0;
 
   printf("Map 4: Random obstacles (high density)...\n");
-  map_generate(m, WORLDSIZE, WORLDSIZE, 50, 0.05);
+  map_generate(m, nrow, ncol, 50, 0.05);
   if (map_save(m, "maps/random5.pgm") != 0)
     success = 0;
 
@@ -77,16 +89,19 @@ int main(void) {
     char filename[64];
     printf("Map %d: %d wall(s)...\n", i + 4, i);
     snprintf(filename, sizeof(filename), "maps/walls%d.pgm", i);
-    map_generate(m, WORLDSIZE, WORLDSIZE, 50, (float)i);
+    map_generate(m, nrow, ncol, 50, (float)i);
     if (map_save(m, filename) != 0)
       success = 0;
   }
+  size_t footprint = map_footprint(m);
 
   map_destroy(m);
 
   if (success) {
     printf("\nMap generation complete\n");
     printf("  All maps have random base positions on walls.\n");
+    printf("  Map size: %dx%d (%zu bytes in memory per map)\n", nrow, ncol,
+           footprint);
     return 0;
   } else {
     fprintf(stderr, "\nError: Some maps could not be saved.\n");
@@ -0,0 +1,338 @@
+/**
+ * @file heatmap.c
+ * @brief Visit heatmap aggregator for Roomba simulator
+ *
+ * Reads one or more heatmap.bin files (written with ROOMBA_HEATMAP=1, one
+ * record per run) in a single streaming pass and adds up the visits of
+ * every run on the same map, whatever the team or repetition. Only one
+ * accumulator per map is kept in memory. For each map it writes a hot
+ * spot image (PGM, brighter = more visits per run, black = never
+ * visited) and prints the revisit ratio and the hottest cells.
+ *
+ * Forked runner rounds load a copy of each map as map.pgm, so records are
+ * grouped by map hash; --maps names each group after the official map
+ * file with the same hash.
+ *
+ * Compilation:
+ *   make heatmap (from tools/)
+ *
+ * Usage:
+ *   ./tools/heatmap [-o dir] [--top n] [--maps dir] heatmap.bin [more.bin ...]
+ */
+
+#include "../simula_internal.h"
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEAT_MIN_LEVEL 64 ///< Gris de una celda visitada alguna vez
+#define HEAT_MAX_TOP 100  ///< Celdas calientes máximas por mapa
+
+/**
+ * @brief Visits of all runs on one map
+ */
+typedef struct {
+  char name[256];    ///< Map name of the first run
+  char file[300];    ///< Output image name
+  uint64_t map_hash; ///< Map hash
+  int nrow, ncol;    ///< Map size
+  uint64_t *sum;     ///< Visits per cell, all runs
+  long runs;         ///< Runs added
+  uint64_t ticks;    ///< Ticks, all runs
+  uint64_t visits;   ///< Visits, all runs
+  uint64_t distinct; ///< Distinct visited cells, all runs
+} heat_group_t;
+
+/**
+ * @brief Print usage
+ */
+static void usage(void) {
+  printf("Uso: heatmap [-o dir] [--top n] [--maps dir] heatmap.bin "
+         "[more.bin ...]\n");
+}
+
+/**
+ * @brief Base name of a map path without directory or extension
+ * @param name Map path ("" for generated maps)
+ * @param hash Map hash (names generated maps)
+ * @param out Output buffer
+ * @param size Buffer size
+ */
+static void map_base(const char *name, uint64_t hash, char *out, size_t size) {
+  const char *slash = strrchr(name, '/');
+  const char *base = slash ? slash + 1 : name;
+  if (base[0] == '\0') {
+    snprintf(out, size, "generated_%08x", (unsigned)hash);
+    return;
+  }
+  snprintf(out, size, "%s", base);
+  char *dot = strrchr(out, '.');
+  if (dot && dot != out)
+    *dot = '\0';
+}
+
+/**
+ * @brief Find the group of a record's map, creating it if needed
+ * @param groups Groups (may be reallocated)
+ * @param n Number of groups (input/output)
+ * @param h Record
+ * @return Group, or NULL if out of memory
+ */
+static heat_group_t *group_of(heat_group_t **groups, int *n,
+                              const heatmap_t *h) {
+  for (int i = 0; i < *n; i++) {
+    heat_group_t *g = &(*groups)[i];
+    if (g->map_hash == h->map_hash && g->nrow == h->nrow && g->ncol == h->ncol)
+      return g;
+  }
+  heat_group_t *grown = realloc(*groups, (*n + 1) * sizeof(heat_group_t));
+  if (!grown)
+    return NULL;
+  *groups = grown;
+  heat_group_t *g = &grown[*n];
+  memset(g, 0, sizeof(*g));
+  g->sum = calloc((size_t)h->nrow * h->ncol, sizeof(uint64_t));
+  if (!g->sum)
+    return NULL;
+  snprintf(g->name, sizeof(g->name), "%s", h->name);
+  g->map_hash = h->map_hash;
+  g->nrow = h->nrow;
+  g->ncol = h->ncol;
+  (*n)++;
+  return g;
+}
+
+/**
+ * @brief Name groups after the map files of a directory with the same hash
+ * @param dir Maps directory
+ * @param groups Groups
+ * @param n Number of groups
+ * @return 0 on OK, -1 if the directory cannot be read
+ */
+static int name_from_maps(const char *dir, heat_group_t *groups, int n) {
+  DIR *d = opendir(dir);
+  if (!d) {
+    fprintf(stderr, "Error: Cannot open directory %s\n", dir);
+    return -1;
+  }
+  struct dirent *entry;
+  char path[sizeof(groups->name)];
+  while ((entry = readdir(d)) != NULL) {
+    size_t len = strlen(entry->d_name);
+    if (len <= 4 || strcmp(entry->d_name + len - 4, ".pgm") != 0)
+      continue;
+    if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >=
+        (int)sizeof(path))
+      continue;
+    map_t m = {0};
+    if (sim_world_load(&m, path) != 0)
+      continue;
+    for (int i = 0; i < n; i++)
+      if (groups[i].map_hash == m.hash && groups[i].nrow == m.nrow &&
+          groups[i].ncol == m.ncol)
+        snprintf(groups[i].name, sizeof(groups[i].name), "%s", path);
+    sim_world_free(&m);
+  }
+  closedir(d);
+  return 0;
+}
+
+/**
+ * @brief Choose the output image name of every group
+ * @param groups Groups
+ * @param n Number of groups
+ */
+static void name_files(heat_group_t *groups, int n) {
+  char base[256];
+  for (int i = 0; i < n; i++) {
+    heat_group_t *g = &groups[i];
+    map_base(g->name, g->map_hash, base, sizeof(base));
+    snprintf(g->file, sizeof(g->file), "heatmap_%s.pgm", base);
+    // Mismo nombre y otro contenido (p. ej. un mapa editado): añadir el hash
+    for (int j = 0; j < i; j++)
+      if (strcmp(groups[j].file, g->file) == 0)
+        snprintf(g->file, sizeof(g->file), "heatmap_%s_%08x.pgm", base,
+                 (unsigned)g->map_hash);
+  }
+}
+
+/**
+ * @brief Add every record of a file to its map's group
+ * @param path File path
+ * @param groups Groups (may be reallocated)
+ * @param n Number of groups (input/output)
+ * @param h Record buffer reused between records
+ * @return Records read, or -1 on error
+ */
+static long add_file(const char *path, heat_group_t **groups, int *n,
+                     heatmap_t *h) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for reading\n", path);
+    return -1;
+  }
+  long records = 0;
+  int rc;
+  while ((rc = heatmap_read(file, h)) == 1) {
+    heat_group_t *g = group_of(groups, n, h);
+    if (!g) {
+      rc = -1;
+      break;
+    }
+    size_t cells = (size_t)h->nrow * h->ncol;
+    for (size_t i = 0; i < cells; i++) {
+      g->sum[i] += h->visits[i];
+      g->visits += h->visits[i];
+    }
+    g->runs++;
+    g->ticks += h->ticks;
+    g->distinct += h->cell_visited;
+    records++;
+  }
+  fclose(file);
+  if (rc != 0) {
+    fprintf(stderr, "Error: %s is not a heatmap file or is truncated\n", path);
+    return -1;
+  }
+  return records;
+}
+
+/**
+ * @brief Write a group's hot spot image
+ * @param g Group
+ * @param dir Output directory
+ * @param max Largest per-cell sum of the group
+ * @return 0 on OK, -1 on error
+ *
+ * Grey levels follow log(1 + visits) so that a few very hot cells do not
+ * hide the rest of the path.
+ */
+static int write_image(const heat_group_t *g, const char *dir, uint64_t max) {
+  char path[600];
+  snprintf(path, sizeof(path), "%s/%s", dir, g->file);
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "Error: Cannot open %s for writing\n", path);
+    return -1;
+  }
+  fprintf(file, "P5\n# %s, %ld runs, max %.2f visits/run\n%d %d\n255\n",
+          g->name[0] ? g->name : "generated map", g->runs,
+          (double)max / g->runs, g->ncol, g->nrow);
+  size_t cells = (size_t)g->nrow * g->ncol;
+  double scale = max > 0 ? (255 - HEAT_MIN_LEVEL) / log1p((double)max) : 0;
+  int rc = 0;
+  for (size_t i = 0; i < cells && rc == 0; i++) {
+    int level = 0;
+    if (g->sum[i] > 0)
+      level = HEAT_MIN_LEVEL + (int)(log1p((double)g->sum[i]) * scale + 0.5);
+    if (fputc(level, file) == EOF)
+      rc = -1;
+  }
+  if (fclose(file) != 0)
+    rc = -1;
+  if (rc != 0)
+    fprintf(stderr, "Error: Cannot write %s\n", path);
+  return rc;
+}
+
+/**
+ * @brief Print the hottest cells of a group
+ * @param g Group
+ * @param top Number of cells to print
+ */
+static void print_top(const heat_group_t *g, int top) {
+  size_t best[HEAT_MAX_TOP];
+  int k = 0;
+  size_t cells = (size_t)g->nrow * g->ncol;
+  // Inserción en una lista ordenada de top elementos: una pasada
+  for (size_t i = 0; i < cells; i++) {
+    if (g->sum[i] == 0 || (k == top && g->sum[i] <= g->sum[best[k - 1]]))
+      continue;
+    int j = k < top ? k++ : k - 1;
+    while (j > 0 && g->sum[best[j - 1]] < g->sum[i]) {
+      best[j] = best[j - 1];
+      j--;
+    }
+    best[j] = i;
+  }
+  for (int j = 0; j < k; j++)
+    printf("    (%zu, %zu) %.2f visits/run\n", best[j] % g->ncol,
+           best[j] / g->ncol, (double)g->sum[best[j]] / g->runs);
+}
+
+/**
+ * @brief Aggregator main function
+ * @param argc Argument count
+ * @param argv Arguments (see usage())
+ * @return 0 on OK, 1 on error
+ */
+int main(int argc, char *argv[]) {
+  const char *dir = ".", *maps = NULL;
+  int top = 5, files = 0;
+  heat_group_t *groups = NULL;
+  int n = 0, rc = 0;
+  long records = 0;
+  heatmap_t h = {0};
+
+  for (int i = 1; i < argc && rc == 0; i++) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      usage();
+      return 0;
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (strcmp(argv[i], "--maps") == 0 && i + 1 < argc) {
+      maps = argv[++i];
+    } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+      top = atoi(argv[++i]);
+      if (top < 0 || top > HEAT_MAX_TOP)
+        top = HEAT_MAX_TOP;
+    } else if (argv[i][0] != '-') {
+      long r = add_file(argv[i], &groups, &n, &h);
+      if (r < 0)
+        rc = 1;
+      records += r;
+      files++;
+    } else {
+      usage();
+      rc = 1;
+    }
+  }
+  if (rc == 0 && files == 0) {
+    usage();
+    rc = 1;
+  }
+
+  if (rc == 0 && maps && name_from_maps(maps, groups, n) != 0)
+    rc = 1;
+  name_files(groups, n);
+
+  if (rc == 0) {
+    printf("%ld runs from %d files, %d maps\n\n", records, files, n);
+    printf("%-32s %6s %10s %10s %10s %8s\n", "Map", "Runs", "Ticks/run",
+           "Cells/run", "Visits/run", "Revisit");
+  }
+  for (int i = 0; rc == 0 && i < n; i++) {
+    heat_group_t *g = &groups[i];
+    uint64_t max = 0;
+    size_t cells = (size_t)g->nrow * g->ncol;
+    for (size_t c = 0; c < cells; c++)
+      if (g->sum[c] > max)
+        max = g->sum[c];
+    double revisit =
+        g->visits ? (double)(g->visits - g->distinct) / g->visits : 0.0;
+    printf("%-32s %6ld %10.1f %10.1f %10.1f %7.1f%%\n", g->file, g->runs,
+           (double)g->ticks / g->runs, (double)g->distinct / g->runs,
+           (double)g->visits / g->runs, revisit * 100.0);
+    print_top(g, top);
+    if (write_image(g, dir, max) != 0)
+      rc = 1;
+  }
+
+  for (int i = 0; i < n; i++)
+    free(groups[i].sum);
+  free(groups);
+  free(h.visits);
+  return rc;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file replay.c
+ * @brief Action log replayer for Roomba simulator
+ *
+ * Re-runs an action log (actions.bin, written with ROOMBA_LOG=actions)
+ * without the team's code: the simulator applies the recorded actions on
+ * the same map and seed and rebuilds the full history, the statistics and
+ * the final map. Prints the statistics in the stats.csv format and, with
+ * --check, compares them with the ones reported by the original run.
+ *
+ * Compilation:
+ *   make replay (from tools/)
+ *
+ * Usage:
+ *   ./tools/replay [actions.bin] [--map map.pgm] [--log log.csv]
+ *                  [--final final.pgm] [--check stats.csv]
+ */
+
+#include "../simula_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Current monotonic time in seconds
+ * @return Seconds
+ */
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Format statistics as one stats.csv row (without newline)
+ * @param st Statistics
+ * @param row Output buffer
+ * @param size Buffer size
+ */
+static void format_stats(const struct _stat *st, char *row, size_t size) {
+  snprintf(row, size, "%d, %d, %d, %d, %.1f, %.1f, %d, %d, %d, %d, %d, %d",
+           st->cell_total, st->cell_visited, st->dirt_total, st->dirt_cleaned,
+           st->bat_total, st->bat_mean, st->moves[FWD], st->moves[TURN],
+           st->moves[BUMP], st->moves[CLEAN], st->moves[LOAD], st->end);
+}
+
+/**
+ * @brief Read the last data row of a stats.csv file
+ * @param path File path
+ * @param row Output buffer (without newline)
+ * @param size Buffer size
+ * @return 0 on OK, -1 if the file cannot be read or has no rows
+ */
+static int last_stats_row(const char *path, char *row, size_t size) {
+  char line[256];
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return -1;
+  row[0] = '\0';
+  while (fgets(line, sizeof(line), file)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    // Saltar la cabecera y las líneas vacías
+    if (line[0] >= '0' && line[0] <= '9')
+      snprintf(row, size, "%s", line);
+  }
+  fclose(file);
+  return row[0] ? 0 : -1;
+}
+
+/**
+ * @brief Print usage
+ */
+static void usage(void) {
+  printf("Uso: replay [actions.bin] [--map map.pgm] [--log log.csv]\n"
+         "              [--final final.pgm] [--check stats.csv]\n");
+}
+
+/**
+ * @brief Replayer main function
+ * @param argc Argument count
+ * @param argv Arguments (see usage())
+ * @return 0 on OK, 1 on error or if --check finds different statistics
+ */
+int main(int argc, char *argv[]) {
+  const char *input = "actions.bin";
+  const char *map = NULL, *log = NULL, *final = NULL, *check = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      usage();
+      return 0;
+    } else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+      map = argv[++i];
+    } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+      log = argv[++i];
+    } else if (strcmp(argv[i], "--final") == 0 && i + 1 < argc) {
+      final = argv[++i];
+    } else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+      check = argv[++i];
+    } else if (argv[i][0] != '-') {
+      input = argv[i];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+
+  action_log_t actions;
+  if (action_log_load(input, &actions) != 0)
+    return 1;
+  if ((actions.flags & ACTIONS_MAP_FILE) && !map) {
+    fprintf(stderr, "Error: %s was recorded on a map file, use --map\n",
+            input);
+    action_log_free(&actions);
+    return 1;
+  }
+
+  sim_ctx_t *ctx = sim_ctx_create();
+  int rc = ctx ? 0 : 1;
+  if (rc == 0 && map && sim_ctx_load_map(ctx, (char *)map) != 0)
+    rc = 1;
+  double t0 = now_s();
+  if (rc == 0 && sim_ctx_replay(ctx, &actions) != 0)
+    rc = 1;
+  double t1 = now_s();
+
+  if (rc == 0) {
+    char row[256], reported[256];
+    format_stats(stats_get(ctx), row, sizeof(row));
+    fprintf(stderr,
+            "%s: %u actions, %zu bytes (%.2f bytes/tick), %d ticks "
+            "replayed in %.2f ms\n",
+            input, actions.count, actions.len,
+            ctx->timer > 0 ? (double)actions.len / ctx->timer : 0.0,
+            ctx->timer, (t1 - t0) * 1000.0);
+    printf("cell_total, cell_visited, dirt_total, dirt_cleaned, "
+           "bat_total, bat_mean, forward, turn, bumps, clean, load, end\n");
+    printf("%s\n", row);
+
+    if (log) {
+      FILE *file = fopen(log, "w");
+      if (file) {
+        write_log_csv(file, ctx->hist, ctx->timer);
+        fclose(file);
+      } else {
+        fprintf(stderr, "Error: Cannot open %s for writing\n", log);
+        rc = 1;
+      }
+    }
+    if (final && sim_world_write_pgm(&ctx->map, final, 0) != 0) {
+      fprintf(stderr, "Error: Cannot write %s\n", final);
+      rc = 1;
+    }
+    if (check) {
+      if (last_stats_row(check, reported, sizeof(reported)) != 0) {
+        fprintf(stderr, "Error: No statistics in %s\n", check);
+        rc = 1;
+      } else if (strcmp(row, reported) != 0) {
+        fprintf(stderr, "Statistics differ from %s:\n  reported: %s\n",
+                check, reported);
+        rc = 1;
+      } else {
+        fprintf(stderr, "Statistics match %s\n", check);
+      }
+    }
+  }
+
+  sim_ctx_destroy(ctx);
+  action_log_free(&actions);
+  sim_world_cache_clear();
+  return rc;
+}
@@ -0,0 +1,469 @@
+/**
+ * @file sim_fleet.c
+ * @brief Motor de varios robots en paralelo sobre un mismo mapa
+ *
+ * Pensado para evaluar muchos robots (parámetros de un comportamiento,
+ * rondas de un torneo) sobre los mismos mapas. Todos los robots avanzan un
+ * tick en cada sim_fleet_step(); cada fase es un bucle sobre los K robots.
+ * Giro, paso, avance y coste están escritos sin saltos para que el
+ * compilador los vectorice (-O3); los casos raros y los accesos a la capa
+ * de cada robot van en dos bucles escalares.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sim_fleet.h"
+
+#define FLEET_FLOATS 8                ///< Arrays float por robot
+#define FLEET_INTS 14                 ///< Arrays int por robot
+
+/* Los núcleos reciben los arrays como parámetros restrict; si GCC los
+ * integra en la función que los llama pierde esa información y deja de
+ * vectorizarlos. */
+#define NOINLINE __attribute__((noinline))
+
+/* ============================================================================
+ * FUNCIONES AUXILIARES PRIVADAS
+ * ============================================================================ */
+
+/**
+ * @brief Reparte el siguiente array de n floats del bloque de la flota
+ * @param p Cursor dentro del bloque
+ * @param n Número de robots
+ * @return Inicio del array
+ */
+static float* take_floats(float **p, int n){
+  float *a = *p;
+  *p += n;
+  return a;
+}
+
+/**
+ * @brief Reparte el siguiente array de n ints del bloque de la flota
+ * @param p Cursor dentro del bloque
+ * @param n Número de robots
+ * @return Inicio del array
+ */
+static int* take_ints(int **p, int n){
+  int *a = *p;
+  *p += n;
+  return a;
+}
+
+/**
+ * @brief Registra un tick de un robot (equivalente a sim_log_tick)
+ * @param f Flota
+ * @param k Índice del robot
+ */
+static void fleet_tick(sim_fleet_t *f, int k){
+  f->timer[k]++;
+  f->bat_sum[k] += f->battery[k];
+  if(f->battery[k] < MIN_BATTERY_THRESHOLD)
+    f->done[k] = 1;
+}
+
+/* ============================================================================
+ * NÚCLEOS POR ACCIÓN
+ * ============================================================================ */
+
+/**
+ * @brief Giro, batería y tick de los robots con acción TURN
+ * @param n Número de robots
+ * @param action Acción de cada robot
+ * @param alpha Ángulo de giro de cada robot
+ * @param done Robots terminados (se actualiza con la batería)
+ * @param heading Orientación
+ * @param battery Batería
+ * @param bat_total Batería consumida
+ * @param bat_sum Suma de batería por tick
+ * @param bumper Bumper
+ * @param timer Ticks
+ * @param turns Contador de giros
+ *
+ * Los arrays van como parámetros restrict (en variables locales GCC no
+ * los tiene en cuenta) y sin saltos: cada robot calcula el resultado y
+ * se queda con él solo si su acción es TURN.
+ */
+NOINLINE static void turn_kernel(int n, const unsigned char *restrict action,
+                        const float *restrict alpha, int *restrict done,
+                        float *restrict heading, float *restrict battery,
+                        float *restrict bat_total, float *restrict bat_sum,
+                        int *restrict bumper, int *restrict timer,
+                        int *restrict turns){
+  for(int k = 0; k < n; k++){
+    int on = (action[k] == TURN) & !done[k];
+    float h = heading[k] + alpha[k];
+    float w = (float)(h + 2 * M_PI);
+    h = h < 0 ? w : h;
+    float b = battery[k] - COST_TURN;
+    heading[k] = on ? h : heading[k];
+    bumper[k] = on ? 0 : bumper[k];
+    battery[k] = on ? b : battery[k];
+    bat_total[k] = on ? bat_total[k] + COST_TURN : bat_total[k];
+    turns[k] += on;
+    timer[k] += on;
+    bat_sum[k] = on ? bat_sum[k] + b : bat_sum[k];
+    done[k] |= on & (b < MIN_BATTERY_THRESHOLD);
+  }
+}
+
+/**
+ * @brief Paso de cada robot según su orientación, desde la tabla de pasos
+ * @param n Número de robots
+ * @param heading Orientación
+ * @param lut Tabla de sim_robot_step_lut()
+ * @param dx Desplazamiento x
+ * @param dy Desplazamiento y
+ * @param diag 1 si es diagonal, 0 si no, -1 si la orientación no está en la tabla
+ */
+NOINLINE static void step_kernel(int n, const float *restrict heading,
+                        const step_lut_t *restrict lut, float *restrict dx,
+                        float *restrict dy, int *restrict diag){
+  for(int k = 0; k < n; k++){
+    float h = heading[k];
+    float q = h * (float)(1.0 / M_PI_8);
+    int i = (int)(q + 0.5f);
+    i = i < 0 ? 0 : i > STEP_LUT_SIZE - 1 ? STEP_LUT_SIZE - 1 : i;
+    int ok = !signbit(q) & (q < STEP_LUT_SIZE - 0.5f) &
+             (h >= lut[i].lo) & (h <= lut[i].hi);
+    dx[k] = lut[i].dx;
+    dy[k] = lut[i].dy;
+    diag[k] = ok ? lut[i].diagonal : -1;
+  }
+}
+
+/**
+ * @brief Avance o choque contra el mapa compartido de los robots con acción FWD
+ * @param n Número de robots
+ * @param action Acción de cada robot
+ * @param done Robots terminados
+ * @param walls Rejilla de muros compartida (1 = muro)
+ * @param nrow Filas del mapa
+ * @param ncol Columnas del mapa
+ * @param dx Desplazamiento x
+ * @param dy Desplazamiento y
+ * @param px Posición continua x
+ * @param py Posición continua y
+ * @param x Posición entera x
+ * @param y Posición entera y
+ * @param bumper Bumper
+ * @param fwd Contador de avances
+ * @param bumps Contador de choques
+ */
+NOINLINE static void move_kernel(int n, const unsigned char *restrict action,
+                        const int *restrict done, const int *restrict walls,
+                        int nrow, int ncol,
+                        const float *restrict dx, const float *restrict dy,
+                        float *restrict px, float *restrict py,
+                        int *restrict x, int *restrict y,
+                        int *restrict bumper, int *restrict fwd,
+                        int *restrict bumps){
+  for(int k = 0; k < n; k++){
+    int on = (action[k] == FWD) & !done[k];
+    float nx = px[k] + dx[k], ny = py[k] + dy[k];
+    int rx = (int)nx, ry = (int)ny;
+    // Fuera de límites cuenta como muro; la celda leída se acota al mapa
+    int inside = (rx >= 0) & (rx < ncol) & (ry >= 0) & (ry < nrow);
+    int cx = rx < 0 ? 0 : rx >= ncol ? ncol - 1 : rx;
+    int cy = ry < 0 ? 0 : ry >= nrow ? nrow - 1 : ry;
+    int wall = (!inside) | walls[cy * ncol + cx];
+    int moved = on & !wall;
+    bumper[k] = on ? wall : bumper[k];
+    bumps[k] += on & wall;
+    fwd[k] += moved;
+    px[k] = moved ? nx : px[k];
+    py[k] = moved ? ny : py[k];
+    x[k] = moved ? rx : x[k];
+    y[k] = moved ? ry : y[k];
+  }
+}
+
+/**
+ * @brief Tick y coste de batería de los robots con acción FWD y fin de tiempo
+ * @param n Número de robots
+ * @param action Acción de cada robot
+ * @param bumper Bumper (1 si el paso ha chocado)
+ * @param diag Paso diagonal
+ * @param exec_time Ticks máximos por robot
+ * @param done Robots terminados (se actualiza con la batería y el tiempo)
+ * @param battery Batería
+ * @param bat_total Batería consumida
+ * @param bat_sum Suma de batería por tick
+ * @param timer Ticks
+ * @return Número de robots que siguen activos
+ *
+ * Como rmb_ctx_forward(), el tick se registra con la batería de antes del
+ * paso y el choque no cuenta como tick.
+ */
+NOINLINE static int cost_kernel(int n, const unsigned char *restrict action,
+                        const int *restrict bumper, const int *restrict diag,
+                        int exec_time, int *restrict done,
+                        float *restrict battery, float *restrict bat_total,
+                        float *restrict bat_sum, int *restrict timer){
+  int active = 0;
+  for(int k = 0; k < n; k++){
+    int on = (action[k] == FWD) & !done[k];
+    int moved = on & !bumper[k];
+    float b = battery[k];
+    float cost = bumper[k] ? COST_BUMP : diag[k] ? COST_MOVE_DIAG : COST_MOVE;
+    int t = timer[k] + moved;
+    timer[k] = t;
+    bat_sum[k] = moved ? bat_sum[k] + b : bat_sum[k];
+    battery[k] = on ? b - cost : b;
+    bat_total[k] = on ? bat_total[k] + cost : bat_total[k];
+    int d = done[k] | (on & (b < MIN_BATTERY_THRESHOLD)) | (t >= exec_time);
+    done[k] = d;
+    active += !d;
+  }
+  return active;
+}
+
+/* ============================================================================
+ * FASES ESCALARES
+ * ============================================================================ */
+
+/**
+ * @brief Casos que la tabla de pasos y el giro vectorizado no cubren
+ * @param f Flota
+ * @param action Acción de cada robot
+ *
+ * Tras giros de más de una vuelta la orientación sale de [0, 2π) y se
+ * corrige con fmod, como rmb_ctx_turn(); los avances con orientaciones
+ * fuera de la tabla calculan el paso con sim_robot_step(). Los robots que
+ * giran no avanzan en el mismo tick, así que el paso que step_kernel()
+ * calculó con su orientación anterior no se usa.
+ */
+static void fleet_fixup(sim_fleet_t *f, const unsigned char *action){
+  for(int k = 0; k < f->n; k++){
+    if(action[k] == TURN){
+      if(f->heading[k] < 0 || f->heading[k] >= 2 * M_PI)
+        f->heading[k] = fmod(f->heading[k], 2 * M_PI);
+    } else if(action[k] == FWD && f->step_diag[k] < 0 && !f->done[k]){
+      f->step_diag[k] = sim_robot_step(f->heading[k], &f->step_dx[k], &f->step_dy[k]);
+    }
+  }
+}
+
+/**
+ * @brief Efectos sobre la capa de cada robot: avance, limpieza y carga
+ * @param f Flota
+ * @param action Acción de cada robot
+ *
+ * Actualiza infrarrojos y celdas visitadas de los robots que han avanzado
+ * (como rmb_ctx_forward) y resuelve las acciones CLEAN y LOAD (como
+ * rmb_ctx_clean y rmb_ctx_load). Se ejecuta antes de cost_kernel(), que
+ * es el único que cambia done en los robots con acción FWD.
+ */
+static void fleet_cells(sim_fleet_t *f, const unsigned char *action){
+  const map_t *m = f->map;
+  for(int k = 0; k < f->n; k++){
+    if(f->done[k] || action[k] == TURN)
+      continue;
+    cell_t *c = &f->layer[k * f->ncells + (size_t)f->y[k] * m->ncol + f->x[k]];
+    if(action[k] == FWD){
+      if(f->bumper[k]) continue;
+      f->infrared[k] = CELL_DIRT(*c);
+      if(!(*c & FLEET_VISITED)){
+        *c |= FLEET_VISITED;
+        f->cell_visited[k]++;
+      }
+    } else if(action[k] == CLEAN){
+      int dirt = CELL_DIRT(*c);
+      if(dirt > 0){
+        dirt--;
+        *c = (cell_t)((*c & ~CELL_DIRT_MASK) | dirt);
+        f->battery[k] -= COST_CLEAN;
+        f->bat_total[k] += COST_CLEAN;
+        f->infrared[k] = dirt;
+        f->moves[CLEAN][k]++;
+        if(dirt == 0) f->dirt_cleaned[k]++;
+      }
+      fleet_tick(f, k);
+    } else if(action[k] == LOAD){
+      int at_base = (f->x[k] == m->base_x && f->y[k] == m->base_y) ||
+                    sim_world_is_base(m, f->y[k], f->x[k]);
+      if(at_base){
+        f->battery[k] += LOAD_BATTERY_AMOUNT;
+        if(f->battery[k] > MAXBAT)
+          f->battery[k] = MAXBAT;
+        fleet_tick(f, k);
+      } else {
+        f->moves[LOAD][k]++;
+      }
+    }
+  }
+}
+
+/* ============================================================================
+ * API DE LA FLOTA
+ * ============================================================================ */
+
+/**
+ * @brief Crea una flota de robots sobre un mapa
+ * @param map Mapa con base
+ * @param n Número de robots
+ * @param exec_time Ticks máximos por robot
+ * @return Flota despierta, o NULL si no hay memoria o el mapa no tiene base
+ *
+ * Reserva todos los arrays por robot en un solo bloque, una capa de
+ * nrow*ncol bytes por robot y la rejilla de muros compartida.
+ */
+sim_fleet_t* sim_fleet_create(const map_t *map, int n, int exec_time){
+  if(!map || !map->cells || n <= 0 || map->base_x < 0 || map->base_y < 0)
+    return NULL;
+  sim_fleet_t *f = calloc(1, sizeof(*f));
+  if(!f) return NULL;
+  f->map = map;
+  f->n = n;
+  f->ncells = (size_t)map->nrow * map->ncol;
+  f->exec_time = exec_time;
+  f->block = malloc((size_t)n * (FLEET_FLOATS * sizeof(float) + FLEET_INTS * sizeof(int)));
+  f->layer = malloc((size_t)n * f->ncells);
+  f->walls = malloc(f->ncells * sizeof(int));
+  if(!f->block || !f->layer || !f->walls){
+    sim_fleet_destroy(f);
+    return NULL;
+  }
+
+  float *fp = f->block;
+  f->px = take_floats(&fp, n);
+  f->py = take_floats(&fp, n);
+  f->heading = take_floats(&fp, n);
+  f->battery = take_floats(&fp, n);
+  f->bat_total = take_floats(&fp, n);
+  f->bat_sum = take_floats(&fp, n);
+  f->step_dx = take_floats(&fp, n);
+  f->step_dy = take_floats(&fp, n);
+  int *ip = (int *)fp;
+  f->x = take_ints(&ip, n);
+  f->y = take_ints(&ip, n);
+  f->bumper = take_ints(&ip, n);
+  f->infrared = take_ints(&ip, n);
+  f->timer = take_ints(&ip, n);
+  f->done = take_ints(&ip, n);
+  f->cell_visited = take_ints(&ip, n);
+  f->dirt_cleaned = take_ints(&ip, n);
+  for(int i = 0; i < 5; i++)
+    f->moves[i] = take_ints(&ip, n);
+  f->step_diag = take_ints(&ip, n);
+
+  // Muros y estadísticas comunes, como stats_rebuild_from_map()
+  for(size_t i = 0; i < f->ncells; i++){
+    f->walls[i] = (map->cells[i] & CELL_WALL) != 0;
+    if(!(map->cells[i] & CELL_WALL)) f->cell_total++;
+    f->dirt_total += CELL_DIRT(map->cells[i]);
+  }
+  sim_fleet_reset(f);
+  return f;
+}
+
+/**
+ * @brief Libera una flota
+ * @param f Flota (puede ser NULL)
+ */
+void sim_fleet_destroy(sim_fleet_t *f){
+  if(!f) return;
+  free(f->block);
+  free(f->layer);
+  free(f->walls);
+  free(f);
+}
+
+/**
+ * @brief Vuelve a colocar todos los robots en la base
+ * @param f Flota
+ *
+ * Cada robot queda como tras rmb_awake(): en la base, con la orientación
+ * de sim_world_base_heading(), batería llena y un tick registrado.
+ */
+void sim_fleet_reset(sim_fleet_t *f){
+  const map_t *m = f->map;
+  int n = f->n;
+  memset(f->block, 0, (size_t)n * (FLEET_FLOATS * sizeof(float) + FLEET_INTS * sizeof(int)));
+
+  // sim_world_put_base() deja la celda de la base sin suciedad
+  for(size_t i = 0; i < f->ncells; i++)
+    f->layer[i] = CELL_DIRT(m->cells[i]);
+  f->layer[(size_t)m->base_y * m->ncol + m->base_x] = 0;
+  for(int k = 1; k < n; k++)
+    memcpy(f->layer + k * f->ncells, f->layer, f->ncells);
+
+  float h = sim_world_base_heading(m, m->base_x, m->base_y);
+  for(int k = 0; k < n; k++){
+    f->px[k] = m->base_x;
+    f->py[k] = m->base_y;
+    f->x[k] = m->base_x;
+    f->y[k] = m->base_y;
+    f->heading[k] = h;
+    f->battery[k] = MAXBAT;
+    fleet_tick(f, k);
+  }
+}
+
+/**
+ * @brief Avanza un tick todos los robots que no han terminado
+ * @param f Flota
+ * @param action Acción de cada robot (enum movement)
+ * @param alpha Ángulo de giro de cada robot
+ * @return Número de robots que siguen activos
+ *
+ * Cada robot hace una sola acción por tick; las fases se ordenan para que
+ * solo cost_kernel() cierre los robots que avanzan. Un robot termina, como
+ * en run(), al agotar el tiempo o al registrar un tick con la batería bajo
+ * MIN_BATTERY_THRESHOLD.
+ */
+int sim_fleet_step(sim_fleet_t *f, const unsigned char *action,
+                   const float *alpha){
+  int n = f->n;
+  turn_kernel(n, action, alpha, f->done, f->heading, f->battery,
+              f->bat_total, f->bat_sum, f->bumper, f->timer, f->moves[TURN]);
+  step_kernel(n, f->heading, sim_robot_step_lut(), f->step_dx, f->step_dy,
+              f->step_diag);
+  fleet_fixup(f, action);
+  move_kernel(n, action, f->done, f->walls, f->map->nrow, f->map->ncol,
+              f->step_dx, f->step_dy, f->px, f->py, f->x, f->y, f->bumper,
+              f->moves[FWD], f->moves[BUMP]);
+  fleet_cells(f, action);
+  return cost_kernel(n, action, f->bumper, f->step_diag, f->exec_time,
+                     f->done, f->battery, f->bat_total, f->bat_sum, f->timer);
+}
+
+/**
+ * @brief Sensores de un robot de la flota
+ * @param f Flota
+ * @param k Índice del robot
+ * @return Lecturas como las de rmb_state()
+ */
+sensor_t sim_fleet_state(const sim_fleet_t *f, int k){
+  sensor_t s;
+  s.x = f->x[k];
+  s.y = f->y[k];
+  s.heading = f->heading[k];
+  s.bumper = f->bumper[k];
+  s.infrared = f->infrared[k];
+  s.battery = f->battery[k];
+  return s;
+}
+
+/**
+ * @brief Estadísticas de un robot de la flota
+ * @param f Flota
+ * @param k Índice del robot
+ * @param st Estructura a rellenar
+ */
+void sim_fleet_stats(const sim_fleet_t *f, int k, struct _stat *st){
+  *st = (struct _stat){0};
+  st->cell_total = f->cell_total;
+  st->cell_visited = f->cell_visited[k];
+  st->dirt_total = f->dirt_total;
+  st->dirt_cleaned = f->dirt_cleaned[k];
+  st->bat_total = f->bat_total[k];
+  st->bat_sum = f->bat_sum[k];
+  st->bat_mean = f->bat_sum[k] / (float)f->timer[k];
+  for(int i = 0; i < 5; i++)
+    st->moves[i] = f->moves[i][k];
+  // La flota no tiene vigilante: solo para por tiempo o por batería
+  st->end = f->battery[k] < MIN_BATTERY_THRESHOLD ? SIM_END_BATTERY
+                                                   : SIM_END_TIME;
+}
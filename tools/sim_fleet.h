@@ -0,0 +1,107 @@
+/**
+ * @file sim_fleet.h
+ * @brief Motor de varios robots en paralelo (solo para herramientas)
+ *
+ * sim_fleet_t avanza K robots a la vez con núcleos vectorizables. Aún no
+ * es más rápido que K simulaciones sim_ctx_t salvo con cientos de robots
+ * (ver benchfleet), así que vive en tools/ y no forma parte de simula.o.
+ */
+
+#ifndef SIM_FLEET_H
+#define SIM_FLEET_H
+
+#include "../simula_internal.h"
+
+#define FLEET_VISITED 0x80        ///< Bit de celda visitada en la capa de un robot
+
+/**
+ * @brief K robots que avanzan a la vez, un tick por paso, sobre un mapa
+ *
+ * El estado va en forma de estructura de arrays (un array por campo, un
+ * elemento por robot) para que los núcleos de giro, avance y colisión
+ * recorran los K robots con bucles vectorizables. Los muros se leen de una
+ * rejilla compartida de ints (un int por celda, para que el avance pueda
+ * leerlos con gathers de 32 bits) y la base del mapa, que no se modifica;
+ * la suciedad y las celdas visitadas de cada robot van en su propia capa
+ * (layer + k * ncells).
+ * Cada robot evoluciona exactamente igual que una simulación sim_ctx_t
+ * sobre el mismo mapa que hiciera la misma acción en cada ciclo.
+ */
+typedef struct {
+  const map_t *map;               ///< Mapa compartido (solo lectura)
+  int n;                          ///< Número de robots
+  size_t ncells;                  ///< Celdas por capa (nrow*ncol)
+  int exec_time;                  ///< Ticks máximos por robot
+  int cell_total, dirt_total;     ///< Estadísticas comunes del mapa
+  int *walls;                     ///< Rejilla de muros compartida (1 = muro)
+  cell_t *layer;                  ///< Capas privadas: suciedad | FLEET_VISITED
+  float *px, *py;                 ///< Posición continua
+  int *x, *y;                     ///< Posición entera (sensor)
+  float *heading;                 ///< Orientación (sensor)
+  float *battery;                 ///< Batería (sensor)
+  int *bumper, *infrared;         ///< Bumper e infrarrojos (sensor)
+  int *timer;                     ///< Ticks de cada robot
+  int *done;                      ///< 1 si el robot ha terminado (tiempo o batería)
+  float *bat_total, *bat_sum;     ///< Estadísticas de batería
+  int *cell_visited;              ///< Celdas visitadas
+  int *dirt_cleaned;              ///< Celdas limpiadas del todo
+  int *moves[5];                  ///< Contadores por tipo (enum movement)
+  float *step_dx, *step_dy;       ///< Paso del tick en curso (auxiliar)
+  int *step_diag;                 ///< Paso diagonal (auxiliar)
+  void *block;                    ///< Memoria de todos los arrays por robot
+} sim_fleet_t;
+
+/**
+ * @brief Crea una flota de robots sobre un mapa
+ * @param map Mapa con base (por ejemplo, cargado con sim_world_load_cached)
+ * @param n Número de robots
+ * @param exec_time Ticks máximos por robot
+ * @return Flota ya despierta (sim_fleet_reset), o NULL si no hay memoria o
+ *         el mapa no tiene base
+ *
+ * El mapa debe seguir vivo y sin cambios mientras exista la flota.
+ */
+sim_fleet_t* sim_fleet_create(const map_t *map, int n, int exec_time);
+
+/**
+ * @brief Libera una flota
+ * @param f Flota (puede ser NULL)
+ */
+void sim_fleet_destroy(sim_fleet_t *f);
+
+/**
+ * @brief Vuelve a colocar todos los robots en la base (como rmb_awake())
+ * @param f Flota
+ *
+ * Restaura la suciedad de todas las capas y pone a cero las estadísticas.
+ */
+void sim_fleet_reset(sim_fleet_t *f);
+
+/**
+ * @brief Avanza un tick todos los robots que no han terminado
+ * @param f Flota
+ * @param action Acción de cada robot: FWD, TURN, CLEAN o LOAD (enum
+ *        movement); cualquier otro valor deja al robot quieto
+ * @param alpha Ángulo de giro de cada robot (solo se usa con TURN)
+ * @return Número de robots que siguen activos
+ */
+int sim_fleet_step(sim_fleet_t *f, const unsigned char *action,
+                   const float *alpha);
+
+/**
+ * @brief Sensores de un robot de la flota
+ * @param f Flota
+ * @param k Índice del robot
+ * @return Lecturas como las de rmb_state()
+ */
+sensor_t sim_fleet_state(const sim_fleet_t *f, int k);
+
+/**
+ * @brief Estadísticas de un robot de la flota
+ * @param f Flota
+ * @param k Índice del robot
+ * @param st Estructura a rellenar, igual que la de una simulación normal
+ */
+void sim_fleet_stats(const sim_fleet_t *f, int k, struct _stat *st);
+
+#endif /* SIM_FLEET_H */
@@ -14,12 +14,16 @@
  */
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 #define MAX_PATH 512
@@ -28,6 +32,7 @@
 
 #define DEFAULT_MAPS_DIR "maps"
 #define TEST_MAPS 8 // maps generated by generate.c
+#define POLL_FALLBACK_MS 10 // wait step when pidfd_open() is unavailable
 
 // ANSI colors
 #define COLOR_RED "\033[0;31m"
@@ -59,6 +64,17 @@ typedef struct {
   int tests_passed; ///< Total tests passed
 } results_t;
 
+/**
+ * @brief Test execution in progress
+ */
+typedef struct {
+  pid_t pid;          ///< Test process (0 = finished)
+  int pidfd;          ///< pidfd of the process (-1 if unavailable)
+  int result;         ///< 0 OK, -1 error, -2 crash, -3 timeout
+  long elapsed_ms;    ///< Wall time until the process finished
+  char dir[MAX_PATH]; ///< Private working directory of the test
+} test_run_t;
+
 // Global output file pointer
 FILE *output_fp = NULL;
 
@@ -320,70 +336,206 @@ int get_test_maps(const char *maps_dir, char maps[][MAX_PATH], int max_maps) {
 }
 
 /**
- * @brief Ejecuta un test individual con control de tiempo
- * @param team_dir Directorio del equipo
- * @param map_file Ruta al mapa de prueba
- * @param timeout Tiempo máximo de ejecución (segundos)
- * @return 0 si OK, -1 si error, -2 si crash, -3 si timeout
+ * @brief Milisegundos de reloj monótono
+ */
+static long now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/**
+ * @brief Copia un archivo sin pasar por el shell
+ * @param src Origen
+ * @param dst Destino (se sobrescribe)
+ * @return 0 si OK, -1 si error
+ */
+static int copy_file(const char *src, const char *dst) {
+  char buf[8192];
+  size_t n;
+  FILE *in = fopen(src, "rb");
+  if (!in)
+    return -1;
+  FILE *out = fopen(dst, "wb");
+  if (!out) {
+    fclose(in);
+    return -1;
+  }
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    fwrite(buf, 1, n, out);
+  int err = ferror(in);
+  fclose(in);
+  return (fclose(out) == 0 && !err) ? 0 : -1;
+}
+
+/**
+ * @brief Lanza un test en su propio directorio de trabajo
+ * @param team_dir Directorio del equipo (contiene roomba_test)
+ * @param map_file Ruta al mapa de prueba ("default" = mapa interno)
+ * @param index Índice del test (nombre del directorio privado)
+ * @param run Estado del test a rellenar
+ * @return 0 si OK, -1 si error
+ *
+ * Cada test trabaja en team_dir/.test<index>/ con su propio map.pgm,
+ * config.txt y stats.csv, de modo que varios tests pueden ejecutarse a la
+ * vez. El proceso se lanza en su propio grupo para poder matarlo entero.
  */
-int execute_test(const char *team_dir, const char *map_file, int timeout) {
+int start_test(const char *team_dir, const char *map_file, int index,
+               test_run_t *run) {
   char cmd[MAX_CMD];
+  int use_map = strcmp(map_file, "default") != 0;
+
+  run->pid = 0;
+  run->pidfd = -1;
+  run->result = -1;
+  run->elapsed_ms = 0;
+  snprintf(run->dir, sizeof(run->dir), "%s/.test%d", team_dir, index);
+  mkdir(run->dir, 0755);
 
   // Copy map to test directory
-  if (strcmp(map_file, "default") != 0) {
-    // Use provided map
-    snprintf(cmd, sizeof(cmd), "cp %s %s/map.pgm", map_file, team_dir);
-    system(cmd);
+  if (use_map) {
+    snprintf(cmd, sizeof(cmd), "%s/map.pgm", run->dir);
+    if (copy_file(map_file, cmd) != 0)
+      return -1;
   }
 
   // Create config
-  snprintf(cmd, sizeof(cmd), "echo '0 0' > %s/config.txt", team_dir);
-  system(cmd);
+  snprintf(cmd, sizeof(cmd), "%s/config.txt", run->dir);
+  FILE *fp = fopen(cmd, "w");
+  if (!fp)
+    return -1;
+  fprintf(fp, "0 0\n");
+  fclose(fp);
 
-  // Execute with fork for timeout control
+  fflush(NULL);
   pid_t pid = fork();
-
+  if (pid < 0)
+    return -1;
   if (pid == 0) {
     // Child process
-    char exec_cmd[MAX_CMD];
-    if (strcmp(map_file, "default") != 0) {
-      snprintf(exec_cmd, sizeof(exec_cmd),
-               "cd %s && ./roomba_test map.pgm > /dev/null 2>&1", team_dir);
-    } else {
-      snprintf(exec_cmd, sizeof(exec_cmd),
-               "cd %s && ./roomba_test > /dev/null 2>&1", team_dir);
+    setpgid(0, 0);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+      dup2(null_fd, STDOUT_FILENO);
+      dup2(null_fd, STDERR_FILENO);
+      close(null_fd);
     }
-    exit(system(exec_cmd) == 0 ? 0 : 1);
-  } else if (pid > 0) {
-    // Parent process
-    int status;
-    int remaining = timeout;
-
-    while (remaining > 0) {
-      int result = waitpid(pid, &status, WNOHANG);
-
-      if (result == pid) {
-        // Process finished
-        if (WIFEXITED(status)) {
-          return WEXITSTATUS(status) == 0 ? 0 : -1;
-        } else if (WIFSIGNALED(status)) {
-          return -2; // Crashed
-        }
-      } else if (result == -1) {
-        return -1;
-      }
+    if (chdir(run->dir) != 0)
+      _exit(127);
+    if (use_map)
+      execl("../roomba_test", "roomba_test", "map.pgm", (char *)NULL);
+    else
+      execl("../roomba_test", "roomba_test", (char *)NULL);
+    _exit(127);
+  }
+
+  setpgid(pid, pid);
+  run->pid = pid;
+#ifdef SYS_pidfd_open
+  run->pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+#endif
+  return 0;
+}
 
-      sleep(1);
-      remaining--;
+/**
+ * @brief Espera a que terminen todos los tests en curso
+ * @param runs Tests lanzados con start_test()
+ * @param count Número de tests
+ * @param timeout Tiempo máximo de ejecución (segundos)
+ *
+ * Duerme en poll() sobre los pidfd de los procesos hasta que alguno termina
+ * o vence el plazo, de modo que cada test cuesta lo que tarda el robot y el
+ * total lo marca el test más lento. Si el kernel no ofrece pidfd_open(),
+ * comprueba los procesos cada POLL_FALLBACK_MS milisegundos. Al vencer el
+ * plazo se mata el grupo de procesos de cada test pendiente.
+ */
+void wait_tests(test_run_t runs[], int count, int timeout) {
+  struct pollfd fds[TEST_MAPS];
+  long start = now_ms();
+  long deadline = start + timeout * 1000L;
+
+  for (;;) {
+    int pending = 0;
+    int nfds = 0;
+    int fallback = 0;
+    long now = now_ms();
+
+    for (int i = 0; i < count; i++) {
+      if (runs[i].pid <= 0)
+        continue;
+      int status;
+      pid_t result = waitpid(runs[i].pid, &status, WNOHANG);
+      if (result == runs[i].pid || result == -1) {
+        if (result == -1)
+          runs[i].result = -1;
+        else if (WIFSIGNALED(status))
+          runs[i].result = -2; // Crashed
+        else
+          runs[i].result = WEXITSTATUS(status) == 0 ? 0 : -1;
+        runs[i].elapsed_ms = now - start;
+        runs[i].pid = 0;
+        if (runs[i].pidfd >= 0)
+          close(runs[i].pidfd);
+        runs[i].pidfd = -1;
+        continue;
+      }
+      pending++;
+      if (runs[i].pidfd >= 0) {
+        fds[nfds].fd = runs[i].pidfd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+      } else {
+        fallback = 1;
+      }
+    }
+    if (pending == 0)
+      return;
+
+    if (now >= deadline) {
+      // Timeout - kill every pending test
+      for (int i = 0; i < count; i++) {
+        if (runs[i].pid <= 0)
+          continue;
+        kill(-runs[i].pid, SIGKILL);
+        waitpid(runs[i].pid, NULL, 0);
+        runs[i].result = -3;
+        runs[i].elapsed_ms = now - start;
+        runs[i].pid = 0;
+        if (runs[i].pidfd >= 0)
+          close(runs[i].pidfd);
+        runs[i].pidfd = -1;
+      }
+      return;
     }
 
-    // Timeout - kill process
-    kill(pid, SIGKILL);
-    waitpid(pid, &status, 0);
-    return -3; // Timeout
+    long wait_ms = deadline - now;
+    if (fallback && wait_ms > POLL_FALLBACK_MS)
+      wait_ms = POLL_FALLBACK_MS;
+    poll(fds, nfds, (int)wait_ms);
   }
+}
 
-  return -1;
+/**
+ * @brief Añade el stats.csv de un test al stats.csv del equipo
+ * @param team_dir Directorio del equipo
+ * @param run Test terminado
+ */
+void merge_test_stats(const char *team_dir, const test_run_t *run) {
+  char path[MAX_PATH + 16];
+  char line[1024];
+
+  snprintf(path, sizeof(path), "%s/stats.csv", run->dir);
+  FILE *src = fopen(path, "r");
+  if (!src)
+    return;
+  snprintf(path, sizeof(path), "%s/stats.csv", team_dir);
+  FILE *dest = fopen(path, "a");
+  if (dest) {
+    while (fgets(line, sizeof(line), src))
+      fputs(line, dest);
+    fclose(dest);
+  }
+  fclose(src);
 }
 
 /**
@@ -405,11 +557,24 @@ int run_execution_tests(const char *team_dir, const char *maps_dir, int timeout,
     return 0;
   }
 
-  log_info("Running execution tests...");
+  char msg[256];
+  snprintf(msg, sizeof(msg), "Running %d execution tests in parallel...",
+           map_count);
+  log_info(msg);
 
   int passed = 0;
   int failed = 0;
+  test_run_t runs[TEST_MAPS];
 
+  for (int i = 0; i < map_count; i++) {
+    if (start_test(team_dir, maps[i], i, &runs[i]) != 0) {
+      runs[i].pid = 0;
+      runs[i].result = -1;
+    }
+  }
+  wait_tests(runs, map_count, timeout);
+
+  // Report and merge results in map order
   for (int i = 0; i < map_count; i++) {
     char *map_name = strrchr(maps[i], '/');
     if (map_name)
@@ -417,14 +582,12 @@ int run_execution_tests(const char *team_dir, const char *maps_dir, int timeout,
     else
       map_name = maps[i];
 
-    char msg[256];
-    snprintf(msg, sizeof(msg), "  Testing with %s...", map_name);
-    log_info(msg);
-
-    int result = execute_test(team_dir, maps[i], timeout);
+    int result = runs[i].result;
+    merge_test_stats(team_dir, &runs[i]);
 
     if (result == 0) {
-      snprintf(msg, sizeof(msg), "    %s: OK", map_name);
+      snprintf(msg, sizeof(msg), "    %s: OK (%ld ms)", map_name,
+               runs[i].elapsed_ms);
       log_pass(msg);
       passed++;
     } else if (result == -3) {
@@ -508,7 +671,7 @@ int validate_stats(const char *team_dir, results_t *res) {
 void cleanup(const char *team_dir) {
   char cmd[MAX_CMD];
   snprintf(cmd, sizeof(cmd),
-           "cd %s && rm -f roomba_test config.txt map.pgm compile.log",
+           "cd %s && rm -rf roomba_test config.txt map.pgm compile.log .test*",
            team_dir);
   system(cmd);
 }
@@ -31,7 +31,8 @@ int main(int argc, char *argv[]) {
     // Cargar el mapa antes de visualizar
     extern int sim_world_load(map_t *m, char *filename);
     extern float sim_world_put_base(map_t *m, int x, int y);
-    if (sim_world_load(&map, (char *)mapfile) != 0) {
+    sim_ctx_t *ctx = sim_ctx_current();
+    if (sim_world_load(&ctx->map, (char *)mapfile) != 0) {
         fprintf(stderr, "No se pudo abrir o procesar el mapa: %s\n", mapfile);
         return 2;
     }
@@ -45,8 +46,9 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
-// Carga el log en el historial global 'hist' y actualiza 'timer'.
+// Carga el log en el historial del contexto activo y actualiza su 'timer'.
 int load_log_as_history(const char *filename) {
+    sim_ctx_t *ctx = sim_ctx_current();
     FILE *file = fopen(filename, "r");
     if (!file) return 0;
     // Saltar cabecera
@@ -58,10 +60,10 @@ int load_log_as_history(const char *filename) {
     rewind(file);
     fgets(buffer, sizeof(buffer), file); // Saltar cabecera otra vez
     // Reservar memoria para el historial
-    if (hist) free(hist);
-    hist = (sensor_t*)malloc(sizeof(sensor_t) * count);
+    free(ctx->hist);
+    sensor_t *hist = ctx->hist = (sensor_t*)malloc(sizeof(sensor_t) * count);
     if (!hist) { fclose(file); return 0; }
-    timer = count;
+    ctx->timer = count;
     int idx = 0;
     while (fgets(buffer, sizeof(buffer), file)) {
         int x, y, bumper, infrared;